@@ -0,0 +1,496 @@
+// Argon2 parameter grid benchmark: hashes with every combination of variant x time cost x memory cost x parallelism
+// (by default spanning the GUI sliders' ranges) on the engine, with the selected kernel, and reports each grid point's
+// latency percentiles, throughput, effective memory bandwidth (see Argon2Engine::memoryTraffic) and peak RSS as JSON.
+// Two such reports can then be compared, flagging the grid points that got slower (or hungrier) by more than a threshold.
+//
+// Usage: argon2gui_bench [--variants id,i,d] [--time-costs 1,16,128] [--memory-costs 1,32,128] [--parallelism 1,2,16]
+//                        [--hash-length 64] [--samples 5] [--min-time 1] [--jobs 1] [--kernel auto] [--output report.json]
+//        argon2gui_bench --compare baseline.json candidate.json [--threshold 5]
+
+#include "arenapool.h"
+#include "argon2engine.h"
+#include "argon2kernels.h"
+#include "systemresources.h"
+
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+struct BenchOptions
+{
+    std::vector<argon2_type> variants { Argon2_id, Argon2_i, Argon2_d };
+    std::vector<uint32_t> timeCosts { 1, 16, 128 };
+    std::vector<uint32_t> memoryCostsMiB { 1, 32, 128 };
+    std::vector<uint32_t> parallelism { 1, 2, 16 };
+    uint32_t hashLength = 64;
+
+    // Every grid point is hashed (after one warm-up hash) at least this many times, and for at least this long.
+    unsigned int samples = 5;
+    double minSeconds = 1.0;
+
+    // Hashes in flight at once: 1 measures the latency of a lone hash, more measure throughput under load.
+    unsigned int jobs = 1;
+
+    const char* kernel = nullptr;
+    const char* output = nullptr;
+};
+
+struct GridPoint
+{
+    Argon2Parameters parameters;
+    std::vector<double> latencies;
+    double hashesPerSecond = 0.0;
+    double bandwidth = 0.0;
+    double peakRssMiB = 0.0;
+    uint64_t pageFaults = 0;
+};
+
+static void printUsage()
+{
+    fprintf(stderr, "Usage: argon2gui_bench [--variants id,i,d] [--time-costs 1,16,128] [--memory-costs 1,32,128] [--parallelism 1,2,16] [--hash-length 64] [--samples 5] [--min-time 1] [--jobs 1] [--kernel auto] [--output report.json]\n");
+    fprintf(stderr, "       argon2gui_bench --compare baseline.json candidate.json [--threshold 5]\n");
+}
+
+static bool parseList(const char* value, std::vector<uint32_t>& list)
+{
+    list.clear();
+
+    for (const char* p = value; *p != '\0';)
+    {
+        char* end = nullptr;
+        const unsigned long number = strtoul(p, &end, 10);
+
+        if (end == p || number == 0 || number > UINT32_MAX || (*end != ',' && *end != '\0'))
+        {
+            return false;
+        }
+
+        list.push_back(static_cast<uint32_t>(number));
+        p = *end == ',' ? end + 1 : end;
+    }
+
+    return !list.empty();
+}
+
+static bool parseVariants(const char* value, std::vector<argon2_type>& variants)
+{
+    variants.clear();
+
+    for (const char* p = value; *p != '\0';)
+    {
+        const size_t length = strcspn(p, ",");
+        const std::string name(p, length);
+
+        if (name == "id" || name == "argon2id")
+        {
+            variants.push_back(Argon2_id);
+        }
+        else if (name == "i" || name == "argon2i")
+        {
+            variants.push_back(Argon2_i);
+        }
+        else if (name == "d" || name == "argon2d")
+        {
+            variants.push_back(Argon2_d);
+        }
+        else
+        {
+            return false;
+        }
+
+        p += p[length] == ',' ? length + 1 : length;
+    }
+
+    return !variants.empty();
+}
+
+// Nearest-rank percentile of sorted latencies.
+static double percentile(const std::vector<double>& sorted, double fraction)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+
+    const size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+static bool measure(Argon2Engine& engine, const BenchOptions& options, GridPoint& point)
+{
+    Argon2HashRequest request;
+    request.parameters = point.parameters;
+    request.password = "correct horse battery staple";
+
+    // Warm-up: faults in (and pools) the arena and spins up the lane threads.
+    if (engine.hash(request).get().error != ARGON2_OK)
+    {
+        return false;
+    }
+
+    // Every grid point gets its own peak, where the OS allows that.
+    resetPeakResidentBytes();
+
+    const uint64_t pageFaults = ArenaPool::shared().stats().pageFaults;
+    const auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+
+    while (point.latencies.size() < options.samples || elapsed < options.minSeconds)
+    {
+        std::vector<std::future<Argon2HashResult>> inFlight;
+
+        for (unsigned int i = 0; i < options.jobs; ++i)
+        {
+            inFlight.push_back(engine.hash(request));
+        }
+
+        for (std::future<Argon2HashResult>& future : inFlight)
+        {
+            const Argon2HashResult result = future.get();
+
+            if (result.error != ARGON2_OK)
+            {
+                return false;
+            }
+
+            point.latencies.push_back(result.seconds * 1000.0);
+        }
+
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::sort(point.latencies.begin(), point.latencies.end());
+
+    point.hashesPerSecond = static_cast<double>(point.latencies.size()) / elapsed;
+    point.bandwidth = static_cast<double>(Argon2Engine::memoryTraffic(point.parameters)) / (percentile(point.latencies, 0.50) / 1000.0) / (1024.0 * 1024.0 * 1024.0);
+    point.peakRssMiB = static_cast<double>(resourceUsage().peakResidentBytes) / (1024.0 * 1024.0);
+    point.pageFaults = ArenaPool::shared().stats().pageFaults - pageFaults;
+
+    return true;
+}
+
+// One result object per line: that's what --compare reads back.
+static void writeReport(FILE* out, const BenchOptions& options, unsigned int cores, const std::vector<GridPoint>& points)
+{
+    fprintf(out, "{\n  \"kernel\": \"%s\",\n  \"cores\": %u,\n  \"jobs\": %u,\n  \"hash_length\": %u,\n  \"results\": [\n", argon2_active_kernel(), cores, options.jobs, options.hashLength);
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        const GridPoint& point = points[i];
+        const std::vector<double>& latencies = point.latencies;
+
+        fprintf(out, "    { \"variant\": \"%s\", \"t\": %u, \"m_kib\": %u, \"p\": %u, \"samples\": %zu, \"min_ms\": %.3f, \"p50_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f, \"hashes_per_s\": %.3f, \"bandwidth_gib_per_s\": %.3f, \"peak_rss_mib\": %.1f, \"page_faults\": %llu }%s\n",
+            argon2_type2string(point.parameters.type, 1), point.parameters.timeCost, point.parameters.memoryCostKiB, point.parameters.parallelism, latencies.size(),
+            latencies.front(), percentile(latencies, 0.50), percentile(latencies, 0.90), percentile(latencies, 0.99), latencies.back(),
+            point.hashesPerSecond, point.bandwidth, point.peakRssMiB, static_cast<unsigned long long>(point.pageFaults), i + 1 < points.size() ? "," : "");
+    }
+
+    fprintf(out, "  ]\n}\n");
+}
+
+static int runGrid(const BenchOptions& options)
+{
+    if (options.kernel != nullptr && !argon2_select_kernel(options.kernel))
+    {
+        fprintf(stderr, "Unknown or unsupported Argon2 kernel \"%s\" (available on this CPU:", options.kernel);
+
+        for (const char* kernel : argon2_available_kernels())
+        {
+            fprintf(stderr, " %s", kernel);
+        }
+
+        fprintf(stderr, ")\n");
+        return 2;
+    }
+
+    Argon2Engine engine;
+    std::vector<GridPoint> points;
+
+    for (argon2_type variant : options.variants)
+    {
+        for (uint32_t timeCost : options.timeCosts)
+        {
+            for (uint32_t memoryCostMiB : options.memoryCostsMiB)
+            {
+                for (uint32_t parallelism : options.parallelism)
+                {
+                    GridPoint point;
+                    point.parameters.type = variant;
+                    point.parameters.timeCost = timeCost;
+                    point.parameters.memoryCostKiB = memoryCostMiB * 1024;
+                    point.parameters.parallelism = parallelism;
+                    point.parameters.hashLength = options.hashLength;
+
+                    if (!measure(engine, options, point))
+                    {
+                        fprintf(stderr, "Failed to hash with %s, t = %u, m = %u MiB, p = %u\n", argon2_type2string(variant, 1), timeCost, memoryCostMiB, parallelism);
+                        return 1;
+                    }
+
+                    // Progress goes to stderr, so that the report can go to stdout.
+                    fprintf(stderr, "%-8s t = %3u  m = %6u MiB  p = %2u:  p50 %10.3f ms  %9.2f hashes/s  %7.2f GiB/s  %9.1f MiB peak RSS\n",
+                        argon2_type2string(variant, 1), timeCost, memoryCostMiB, parallelism, percentile(point.latencies, 0.50), point.hashesPerSecond, point.bandwidth, point.peakRssMiB);
+
+                    points.push_back(std::move(point));
+                }
+            }
+        }
+    }
+
+    FILE* out = options.output != nullptr ? fopen(options.output, "w") : stdout;
+
+    if (out == NULL)
+    {
+        fprintf(stderr, "Couldn't open \"%s\" for writing\n", options.output);
+        return 1;
+    }
+
+    writeReport(out, options, engine.cores(), points);
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+
+    return 0;
+}
+
+// Value of "key" in one of the report's result lines.
+static bool jsonValue(const std::string& line, const char* key, std::string& value)
+{
+    const std::string quoted = std::string("\"") + key + "\": ";
+    const size_t start = line.find(quoted);
+
+    if (start == std::string::npos)
+    {
+        return false;
+    }
+
+    // Strings are returned without their quotes.
+    const bool string = line[start + quoted.size()] == '"';
+    const size_t begin = start + quoted.size() + (string ? 1 : 0);
+    const size_t end = string ? line.find('"', begin) : line.find_first_of(",}", begin);
+
+    value = line.substr(begin, end - begin);
+    return true;
+}
+
+struct ReportEntry
+{
+    std::string key;
+    double p50 = 0.0;
+    double hashesPerSecond = 0.0;
+    double peakRssMiB = 0.0;
+};
+
+static bool readReport(const char* path, std::string& kernel, std::vector<ReportEntry>& entries)
+{
+    FILE* in = fopen(path, "r");
+
+    if (in == NULL)
+    {
+        fprintf(stderr, "Couldn't open \"%s\"\n", path);
+        return false;
+    }
+
+    char buffer[1024];
+
+    while (fgets(buffer, sizeof(buffer), in) != NULL)
+    {
+        const std::string line(buffer);
+        std::string variant, t, m, p, value;
+
+        if (line.find("\"kernel\": ") != std::string::npos)
+        {
+            jsonValue(line, "kernel", kernel);
+            continue;
+        }
+
+        if (!jsonValue(line, "variant", variant) || !jsonValue(line, "t", t) || !jsonValue(line, "m_kib", m) || !jsonValue(line, "p", p))
+        {
+            continue;
+        }
+
+        ReportEntry entry;
+        entry.key = variant + " t=" + t + " m=" + m + "KiB p=" + p;
+
+        if (jsonValue(line, "p50_ms", value))
+        {
+            entry.p50 = strtod(value.c_str(), nullptr);
+        }
+
+        if (jsonValue(line, "hashes_per_s", value))
+        {
+            entry.hashesPerSecond = strtod(value.c_str(), nullptr);
+        }
+
+        if (jsonValue(line, "peak_rss_mib", value))
+        {
+            entry.peakRssMiB = strtod(value.c_str(), nullptr);
+        }
+
+        entries.push_back(entry);
+    }
+
+    fclose(in);
+
+    if (entries.empty())
+    {
+        fprintf(stderr, "\"%s\" contains no argon2gui_bench results\n", path);
+        return false;
+    }
+
+    return true;
+}
+
+// Relative change from baseline to candidate, in percent.
+static double change(double baseline, double candidate)
+{
+    return baseline > 0.0 ? 100.0 * (candidate - baseline) / baseline : 0.0;
+}
+
+// Exits with 1 if any grid point present in both reports regressed by more than the threshold (in percent)
+// in median latency, throughput or peak RSS, so that this can gate a CI job.
+static int compareReports(const char* baselinePath, const char* candidatePath, double threshold)
+{
+    std::string baselineKernel, candidateKernel;
+    std::vector<ReportEntry> baseline, candidate;
+
+    if (!readReport(baselinePath, baselineKernel, baseline) || !readReport(candidatePath, candidateKernel, candidate))
+    {
+        return 2;
+    }
+
+    printf("baseline %s (kernel %s) vs. candidate %s (kernel %s), threshold %.1f%%\n\n", baselinePath, baselineKernel.c_str(), candidatePath, candidateKernel.c_str(), threshold);
+    printf("%-36s %12s %12s %12s  %s\n", "grid point", "p50", "hashes/s", "peak RSS", "verdict");
+
+    unsigned int regressions = 0;
+    unsigned int improvements = 0;
+    unsigned int compared = 0;
+
+    for (const ReportEntry& before : baseline)
+    {
+        const auto after = std::find_if(candidate.begin(), candidate.end(), [&before](const ReportEntry& entry) { return entry.key == before.key; });
+
+        if (after == candidate.end())
+        {
+            continue;
+        }
+
+        const double latencyChange = change(before.p50, after->p50);
+        const double throughputChange = change(before.hashesPerSecond, after->hashesPerSecond);
+        const double rssChange = change(before.peakRssMiB, after->peakRssMiB);
+
+        const bool regressed = latencyChange > threshold || throughputChange < -threshold || rssChange > threshold;
+        const bool improved = !regressed && (latencyChange < -threshold || throughputChange > threshold);
+
+        regressions += regressed ? 1 : 0;
+        improvements += improved ? 1 : 0;
+        ++compared;
+
+        printf("%-36s %+11.1f%% %+11.1f%% %+11.1f%%  %s\n", before.key.c_str(), latencyChange, throughputChange, rssChange, regressed ? "REGRESSION" : improved ? "improved" : "ok");
+    }
+
+    if (compared == 0)
+    {
+        fprintf(stderr, "The two reports have no grid point in common\n");
+        return 2;
+    }
+
+    printf("\n%u grid points compared: %u regressions, %u improvements\n", compared, regressions, improvements);
+    return regressions != 0 ? 1 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    const char* compare[2] = { nullptr, nullptr };
+    double threshold = 5.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* argument = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (value == nullptr)
+        {
+            printUsage();
+            return 2;
+        }
+
+        ++i;
+        bool valid = true;
+
+        if (strcmp(argument, "--compare") == 0 && i + 1 < argc)
+        {
+            compare[0] = value;
+            compare[1] = argv[++i];
+        }
+        else if (strcmp(argument, "--threshold") == 0)
+        {
+            threshold = strtod(value, nullptr);
+            valid = threshold > 0.0;
+        }
+        else if (strcmp(argument, "--variants") == 0)
+        {
+            valid = parseVariants(value, options.variants);
+        }
+        else if (strcmp(argument, "--time-costs") == 0)
+        {
+            valid = parseList(value, options.timeCosts);
+        }
+        else if (strcmp(argument, "--memory-costs") == 0)
+        {
+            valid = parseList(value, options.memoryCostsMiB) && *std::max_element(options.memoryCostsMiB.begin(), options.memoryCostsMiB.end()) <= UINT32_MAX / 1024;
+        }
+        else if (strcmp(argument, "--parallelism") == 0)
+        {
+            valid = parseList(value, options.parallelism) && *std::max_element(options.parallelism.begin(), options.parallelism.end()) <= ARGON2_MAX_LANES;
+        }
+        else if (strcmp(argument, "--hash-length") == 0)
+        {
+            options.hashLength = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+            valid = options.hashLength >= ARGON2_MIN_OUTLEN && options.hashLength <= 128;
+        }
+        else if (strcmp(argument, "--samples") == 0)
+        {
+            options.samples = static_cast<unsigned int>(strtoul(value, nullptr, 10));
+            valid = options.samples != 0;
+        }
+        else if (strcmp(argument, "--min-time") == 0)
+        {
+            options.minSeconds = strtod(value, nullptr);
+            valid = options.minSeconds >= 0.0;
+        }
+        else if (strcmp(argument, "--jobs") == 0)
+        {
+            options.jobs = static_cast<unsigned int>(strtoul(value, nullptr, 10));
+            valid = options.jobs != 0;
+        }
+        else if (strcmp(argument, "--kernel") == 0)
+        {
+            options.kernel = value;
+        }
+        else if (strcmp(argument, "--output") == 0)
+        {
+            options.output = value;
+        }
+        else
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            printUsage();
+            return 2;
+        }
+    }
+
+    return compare[0] != nullptr ? compareReports(compare[0], compare[1], threshold) : runGrid(options);
+}
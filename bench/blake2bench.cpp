@@ -0,0 +1,168 @@
+// Multi-buffer BLAKE2b microbenchmark: with every kernel the CPU supports, times the first blocks of a hash (argon2_fill_first_blocks,
+// see argon2blake2b.h) against the library's fill_first_blocks for several lane counts, then the tags of a group of hashes
+// (argon2_blake2b_long_many) against blake2b_long one at a time, checking along the way that both produce exactly the same bytes.
+// Odd input and output lengths, which don't show up in Argon2 but go through the same code, are checked too.
+//
+// Usage: argon2gui_blake2bench [repetitions] [group size]
+
+#include "argon2blake2b.h"
+#include "argon2kernels.h"
+#include "saltgenerator.h"
+
+#include <core.h>
+#include <blake2/blake2.h>
+
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+static double measure(const std::function<void()>& body)
+{
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char* name, uint32_t size, size_t repetitions, double librarySeconds, double seconds)
+{
+    printf("  %-14s %3u   %10.2f us %10.2f us %8.2fx\n", name, size, librarySeconds * 1e6 / repetitions, seconds * 1e6 / repetitions, librarySeconds / seconds);
+}
+
+// Both versions of the first blocks of an instance with the passed number of lanes (and a lane length of 2 blocks, which is all they touch).
+static bool benchFirstBlocks(uint32_t lanes, size_t repetitions)
+{
+    std::vector<block> libraryMemory(2 * lanes);
+    std::vector<block> memory(2 * lanes);
+
+    argon2_instance_t instance;
+    memset(&instance, 0x00, sizeof(instance));
+    instance.lanes = lanes;
+    instance.lane_length = 2;
+
+    uint8_t blockhash[ARGON2_PREHASH_SEED_LENGTH];
+    random_salt(blockhash, sizeof(blockhash));
+
+    const double librarySeconds = measure([&] {
+        instance.memory = libraryMemory.data();
+
+        for (size_t i = 0; i < repetitions; ++i)
+        {
+            // (fill_first_blocks writes the block index and lane into the last 8 bytes.)
+            uint8_t seed[ARGON2_PREHASH_SEED_LENGTH];
+            memcpy(seed, blockhash, sizeof(seed));
+            fill_first_blocks(seed, &instance);
+        }
+    });
+
+    const double seconds = measure([&] {
+        instance.memory = memory.data();
+
+        const uint8_t* blockhashes[] = { blockhash };
+        const argon2_instance_t* instances[] = { &instance };
+
+        for (size_t i = 0; i < repetitions; ++i)
+        {
+            argon2_fill_first_blocks(blockhashes, instances, 1);
+        }
+    });
+
+    report("first blocks", lanes, repetitions, librarySeconds, seconds);
+
+    return memcmp(libraryMemory.data(), memory.data(), memory.size() * sizeof(block)) == 0;
+}
+
+// Both versions of H' over count inputs of inlen bytes, outlen bytes each.
+static bool benchLong(const char* name, uint32_t outlen, size_t inlen, uint32_t count, size_t repetitions)
+{
+    std::vector<uint8_t> inputBytes(count * inlen + 1);
+    std::vector<uint8_t> libraryOutputs(count * outlen);
+    std::vector<uint8_t> outputBytes(count * outlen);
+
+    random_salt(inputBytes.data(), inputBytes.size());
+
+    std::vector<const uint8_t*> inputs(count);
+    std::vector<uint8_t*> outputs(count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        inputs[i] = inputBytes.data() + i * inlen;
+        outputs[i] = outputBytes.data() + i * outlen;
+    }
+
+    const double librarySeconds = measure([&] {
+        for (size_t r = 0; r < repetitions; ++r)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                blake2b_long(libraryOutputs.data() + i * outlen, outlen, inputs[i], inlen);
+            }
+        }
+    });
+
+    const double seconds = measure([&] {
+        for (size_t r = 0; r < repetitions; ++r)
+        {
+            argon2_blake2b_long_many(outputs.data(), outlen, inputs.data(), inlen, count);
+        }
+    });
+
+    if (name != nullptr)
+    {
+        report(name, count, repetitions, librarySeconds, seconds);
+    }
+
+    return libraryOutputs == outputBytes;
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t repetitions = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000;
+    const uint32_t groupSize = argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 8;
+
+    if (repetitions == 0 || groupSize == 0)
+    {
+        fprintf(stderr, "Usage: %s [repetitions] [group size]\n", argv[0]);
+        return 2;
+    }
+
+    bool identical = true;
+
+    for (const char* kernel : argon2_available_kernels())
+    {
+        if (!argon2_select_kernel(kernel))
+        {
+            continue;
+        }
+
+        printf("%s (%u at once)          size      library       ours  speedup\n", kernel, argon2_blake2b_width());
+
+        for (const uint32_t lanes : { 1u, 2u, 4u, 8u, 16u })
+        {
+            identical &= benchFirstBlocks(lanes, repetitions);
+        }
+
+        identical &= benchLong("tags (32 B)", 32, ARGON2_BLOCK_SIZE, groupSize, repetitions);
+        identical &= benchLong("tags (128 B)", 128, ARGON2_BLOCK_SIZE, groupSize, repetitions);
+
+        // Every kind of block boundary for the prefixed input, and outputs just below, at and above 64 bytes (and the chain's 32-byte steps).
+        for (size_t inlen = 0; inlen <= 260; inlen += 3)
+        {
+            for (const uint32_t outlen : { 1u, 31u, 63u, 64u, 65u, 95u, 96u, 97u, 200u })
+            {
+                identical &= benchLong(nullptr, outlen, inlen, 1 + static_cast<uint32_t>(inlen % 11), 1);
+            }
+        }
+
+        if (!identical)
+        {
+            fprintf(stderr, "The multi-buffer BLAKE2b and the library disagree with the %s kernel!\n", kernel);
+            return 1;
+        }
+    }
+
+    argon2_select_kernel(nullptr);
+    return 0;
+}
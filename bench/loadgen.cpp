@@ -0,0 +1,297 @@
+// Load generator for the hashing daemon (argon2gui --daemon): opens a few connections, keeps a fixed amount of
+// pipelined requests in flight on each of them and reports the throughput and latency percentiles.
+
+#include "daemonprotocol.h"
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+
+struct LoadOptions
+{
+    std::string socketPath;
+    unsigned int connections = 4;
+    uint64_t requests = 1000;
+    unsigned int pipeline = 8;
+    bool verify = false;
+    Argon2Parameters parameters;
+};
+
+static int connectToDaemon(const std::string& path)
+{
+    sockaddr_un address;
+    memset(&address, 0x00, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        return -1;
+    }
+
+    memcpy(address.sun_path, path.data(), path.size());
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd != -1 && connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static bool writeAll(int fd, const std::string& data)
+{
+    for (size_t written = 0; written < data.size();)
+    {
+        const ssize_t n = write(fd, data.data() + written, data.size() - written);
+
+        if (n <= 0)
+        {
+            return false;
+        }
+
+        written += static_cast<size_t>(n);
+    }
+
+    return true;
+}
+
+// Blocks until one complete response has been received.
+static bool readResponse(int fd, std::string& buffer, DaemonResponse& response)
+{
+    char chunk[16 * 1024];
+
+    for (;;)
+    {
+        const ptrdiff_t frameSize = decodeDaemonResponse(buffer.data(), buffer.size(), response);
+
+        if (frameSize < 0)
+        {
+            return false;
+        }
+
+        if (frameSize > 0)
+        {
+            buffer.erase(0, static_cast<size_t>(frameSize));
+            return true;
+        }
+
+        const ssize_t n = read(fd, chunk, sizeof(chunk));
+
+        if (n <= 0)
+        {
+            return false;
+        }
+
+        buffer.append(chunk, static_cast<size_t>(n));
+    }
+}
+
+static void printUsage()
+{
+    fprintf(stderr, "Usage: argon2gui_loadgen --socket <path> [--connections 4] [--requests 1000] [--pipeline 8] [--verify] [--time-cost 1] [--memory-cost-kib 4096] [--parallelism 1]\n");
+}
+
+int main(int argc, char* argv[])
+{
+    LoadOptions options;
+    options.parameters.timeCost = 1;
+    options.parameters.memoryCostKiB = 4096;
+    options.parameters.parallelism = 1;
+    options.parameters.hashLength = 32;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* argument = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (strcmp(argument, "--verify") == 0)
+        {
+            options.verify = true;
+            continue;
+        }
+
+        if (value == nullptr)
+        {
+            printUsage();
+            return 2;
+        }
+
+        if (strcmp(argument, "--socket") == 0)
+        {
+            options.socketPath = value;
+        }
+        else if (strcmp(argument, "--connections") == 0)
+        {
+            options.connections = static_cast<unsigned int>(strtoul(value, nullptr, 10));
+        }
+        else if (strcmp(argument, "--requests") == 0)
+        {
+            options.requests = strtoull(value, nullptr, 10);
+        }
+        else if (strcmp(argument, "--pipeline") == 0)
+        {
+            options.pipeline = static_cast<unsigned int>(strtoul(value, nullptr, 10));
+        }
+        else if (strcmp(argument, "--time-cost") == 0)
+        {
+            options.parameters.timeCost = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        }
+        else if (strcmp(argument, "--memory-cost-kib") == 0)
+        {
+            options.parameters.memoryCostKiB = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        }
+        else if (strcmp(argument, "--parallelism") == 0)
+        {
+            options.parameters.parallelism = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        }
+        else
+        {
+            printUsage();
+            return 2;
+        }
+
+        ++i;
+    }
+
+    if (options.socketPath.empty() || options.connections == 0 || options.pipeline == 0)
+    {
+        printUsage();
+        return 2;
+    }
+
+    std::mutex mutex;
+    std::vector<double> latencies;
+    uint64_t errors = 0;
+    bool connectionFailed = false;
+
+    latencies.reserve(options.requests);
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> clients;
+
+    for (unsigned int c = 0; c < options.connections; ++c)
+    {
+        const uint64_t share = options.requests / options.connections + (c < options.requests % options.connections ? 1 : 0);
+
+        clients.emplace_back([&, share] {
+            const int fd = connectToDaemon(options.socketPath);
+
+            if (fd == -1)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                connectionFailed = true;
+                return;
+            }
+
+            std::string input;
+            std::string output;
+            DaemonRequest request;
+            DaemonResponse response;
+
+            request.parameters = options.parameters;
+            request.password = "correct horse battery staple";
+
+            // Verification requests need a hash to verify against: get one first (not measured).
+            if (options.verify)
+            {
+                encodeDaemonRequest(request, output);
+
+                if (!writeAll(fd, output) || !readResponse(fd, input, response) || response.error != ARGON2_OK)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    connectionFailed = true;
+                    close(fd);
+                    return;
+                }
+
+                request.opcode = DAEMON_OPCODE_VERIFY;
+                request.encodedHash = response.encodedHash;
+            }
+
+            std::unordered_map<uint64_t, std::chrono::steady_clock::time_point> sendTimes;
+            std::vector<double> localLatencies;
+            uint64_t localErrors = 0;
+            uint64_t sent = 0;
+            uint64_t received = 0;
+
+            while (received < share)
+            {
+                output.clear();
+
+                while (sent < share && sent - received < options.pipeline)
+                {
+                    request.id = ++sent;
+                    encodeDaemonRequest(request, output);
+                    sendTimes.emplace(request.id, std::chrono::steady_clock::now());
+                }
+
+                if ((!output.empty() && !writeAll(fd, output)) || !readResponse(fd, input, response))
+                {
+                    localErrors += share - received;
+                    break;
+                }
+
+                const auto sendTime = sendTimes.find(response.id);
+
+                if (sendTime != sendTimes.end())
+                {
+                    localLatencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sendTime->second).count());
+                    sendTimes.erase(sendTime);
+                }
+
+                if (response.error != ARGON2_OK)
+                {
+                    ++localErrors;
+                }
+
+                ++received;
+            }
+
+            close(fd);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            latencies.insert(latencies.end(), localLatencies.begin(), localLatencies.end());
+            errors += localErrors;
+        });
+    }
+
+    for (std::thread& client : clients)
+    {
+        client.join();
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    if (connectionFailed)
+    {
+        fprintf(stderr, "Couldn't connect to (or get a hash from) the daemon at \"%s\"\n", options.socketPath.c_str());
+        return 1;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    const auto percentile = [&](double p) {
+        return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * static_cast<double>(latencies.size())))];
+    };
+
+    printf("%s: %zu requests (%llu errors) over %u connections, pipeline depth %u, in %.3f s\n", options.verify ? "verify" : "hash", latencies.size(), static_cast<unsigned long long>(errors), options.connections, options.pipeline, seconds);
+    printf("throughput: %.1f requests/s\n", static_cast<double>(latencies.size()) / seconds);
+    printf("latency: p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", percentile(0.50), percentile(0.99), latencies.empty() ? 0.0 : latencies.back());
+
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+// PHC string codec benchmark: encodes and decodes a million (by default) Argon2 hash strings, once with the library's
+// encode_string()/decode_string() and once with encodePhcString() and parsePhcString() + decodeBase64() (see phcstring.h),
+// checking along the way that both produce exactly the same strings and bytes.
+//
+// Usage: argon2gui_phcbench [records] [hash length]
+
+#include "phcstring.h"
+#include "saltgenerator.h"
+
+#include <encoding.h>
+
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+static const size_t saltLength = 16;
+static const size_t stride = 256;
+
+static double measure(const std::function<void()>& body)
+{
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char* name, size_t records, double seconds)
+{
+    printf("%-44s %10.3f s %14.0f records/s\n", name, seconds, static_cast<double>(records) / seconds);
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t records = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    const size_t hashLength = argc > 2 ? strtoull(argv[2], nullptr, 10) : 32;
+
+    if (records == 0 || hashLength < ARGON2_MIN_OUTLEN || hashLength > 128)
+    {
+        fprintf(stderr, "Usage: %s [records] [hash length (4 to 128 bytes)]\n", argv[0]);
+        return 2;
+    }
+
+    const argon2_type types[] = { Argon2_id, Argon2_i, Argon2_d };
+
+    std::vector<uint8_t> salts(records * saltLength);
+    std::vector<uint8_t> hashes(records * hashLength);
+
+    for (size_t i = 0; i < records; ++i)
+    {
+        random_salt(salts.data() + i * saltLength, saltLength);
+        random_salt(hashes.data() + i * hashLength, hashLength);
+    }
+
+    const auto contextFor = [&](size_t i) {
+        argon2_context context;
+        memset(&context, 0x00, sizeof(context));
+
+        context.out = hashes.data() + i * hashLength;
+        context.outlen = static_cast<uint32_t>(hashLength);
+        context.salt = salts.data() + i * saltLength;
+        context.saltlen = saltLength;
+        context.t_cost = 1 + static_cast<uint32_t>(i % 16);
+        context.m_cost = 8192 << (i % 8);
+        context.lanes = 1 + static_cast<uint32_t>(i % 4);
+        context.threads = context.lanes;
+        context.version = ARGON2_VERSION_NUMBER;
+
+        return context;
+    };
+
+    std::vector<char> library(records * stride);
+    std::vector<char> ours(records * stride);
+
+    report("encode_string (library)", records, measure([&] {
+        for (size_t i = 0; i < records; ++i)
+        {
+            argon2_context context = contextFor(i);
+            encode_string(library.data() + i * stride, stride, &context, types[i % 3]);
+        }
+    }));
+
+    report("encodePhcString", records, measure([&] {
+        for (size_t i = 0; i < records; ++i)
+        {
+            const argon2_context context = contextFor(i);
+            encodePhcString(types[i % 3], context.version, context.m_cost, context.t_cost, context.lanes, context.salt, context.saltlen, context.out, context.outlen, ours.data() + i * stride, stride);
+        }
+    }));
+
+    if (library != ours)
+    {
+        fprintf(stderr, "encodePhcString and encode_string disagree!\n");
+        return 1;
+    }
+
+    std::vector<uint8_t> decodedSalts(records * saltLength);
+    std::vector<uint8_t> decodedHashes(records * hashLength);
+
+    report("decode_string (library)", records, measure([&] {
+        for (size_t i = 0; i < records; ++i)
+        {
+            argon2_context context;
+            memset(&context, 0x00, sizeof(context));
+
+            context.out = decodedHashes.data() + i * hashLength;
+            context.outlen = static_cast<uint32_t>(hashLength);
+            context.salt = decodedSalts.data() + i * saltLength;
+            context.saltlen = saltLength;
+
+            if (decode_string(&context, library.data() + i * stride, types[i % 3]) != ARGON2_OK)
+            {
+                fprintf(stderr, "decode_string failed on record %zu\n", i);
+                exit(1);
+            }
+        }
+    }));
+
+    std::vector<uint8_t> parsedSalts(records * saltLength);
+    std::vector<uint8_t> parsedHashes(records * hashLength);
+
+    report("parsePhcString + decodeBase64", records, measure([&] {
+        for (size_t i = 0; i < records; ++i)
+        {
+            PhcString phc;
+
+            if (!parsePhcString(std::string_view(ours.data() + i * stride), phc)
+                || decodeBase64(phc.salt, parsedSalts.data() + i * saltLength, saltLength) != saltLength
+                || decodeBase64(phc.hash, parsedHashes.data() + i * hashLength, hashLength) != hashLength)
+            {
+                fprintf(stderr, "parsePhcString failed on record %zu\n", i);
+                exit(1);
+            }
+        }
+    }));
+
+    if (decodedSalts != parsedSalts || decodedHashes != parsedHashes || parsedSalts != salts || parsedHashes != hashes)
+    {
+        fprintf(stderr, "decodeBase64 and decode_string disagree!\n");
+        return 1;
+    }
+
+    return 0;
+}
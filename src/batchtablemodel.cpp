@@ -0,0 +1,111 @@
+#include "batchtablemodel.h"
+
+#include <climits>
+#include <algorithm>
+
+static QString statusText(const BatchRow& row)
+{
+    switch (row.status)
+    {
+        case BatchRowStatus::Queued:
+            return QString("Queued");
+        case BatchRowStatus::Running:
+            return QString("Running");
+        case BatchRowStatus::Hashed:
+            return QString("Hashed");
+        case BatchRowStatus::Matched:
+            return QString("Match");
+        case BatchRowStatus::Mismatched:
+            return QString("Mismatch");
+        default:
+            return QString("Error %1").arg(row.error);
+    }
+}
+
+BatchTableModel::BatchTableModel(QObject* parent) : QAbstractTableModel(parent)
+{
+}
+
+void BatchTableModel::setBatch(BatchTable* batch)
+{
+    beginResetModel();
+    this->batch = batch;
+    rows = batch != nullptr ? static_cast<int>(std::min<uint64_t>(batch->rowCount(), INT_MAX)) : 0;
+    endResetModel();
+}
+
+void BatchTableModel::refresh()
+{
+    if (batch == nullptr)
+    {
+        return;
+    }
+
+    const std::pair<uint64_t, uint64_t> changes = batch->takeChanges();
+
+    if (changes.first >= changes.second || changes.first >= static_cast<uint64_t>(rows))
+    {
+        return;
+    }
+
+    const int last = static_cast<int>(std::min<uint64_t>(changes.second, static_cast<uint64_t>(rows))) - 1;
+
+    emit dataChanged(index(static_cast<int>(changes.first), StatusColumn), index(last, HashColumn), { Qt::DisplayRole, Qt::ToolTipRole });
+}
+
+int BatchTableModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : rows;
+}
+
+int BatchTableModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant BatchTableModel::data(const QModelIndex& index, int role) const
+{
+    if (batch == nullptr || !index.isValid() || index.row() >= rows || (role != Qt::DisplayRole && role != Qt::ToolTipRole))
+    {
+        return QVariant();
+    }
+
+    if (index.column() == LineColumn)
+    {
+        return role == Qt::DisplayRole ? QVariant(index.row() + 1) : QVariant();
+    }
+
+    const BatchRow row = batch->row(static_cast<uint64_t>(index.row()));
+
+    if (index.column() == StatusColumn)
+    {
+        if (role == Qt::ToolTipRole)
+        {
+            return row.status == BatchRowStatus::Failed ? QVariant(QString(argon2_error_message(row.error))) : QVariant();
+        }
+
+        return statusText(row);
+    }
+
+    return QString::fromStdString(row.hash);
+}
+
+QVariant BatchTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+    {
+        return QVariant();
+    }
+
+    switch (section)
+    {
+        case LineColumn:
+            return QString("Line");
+        case StatusColumn:
+            return QString("Status");
+        case HashColumn:
+            return QString("Hash");
+        default:
+            return QVariant();
+    }
+}
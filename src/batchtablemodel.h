@@ -0,0 +1,43 @@
+#ifndef BATCHTABLEMODEL_H
+#define BATCHTABLEMODEL_H
+
+#include <QAbstractTableModel>
+
+#include "batchtable.h"
+
+// Shows a batch (see batchtable.h) as a table of line number, status and hash. Nothing is stored on the model's side:
+// every cell is cut out of the batch when the view asks for it, which it only does for the rows it shows.
+// The batch's changes are only picked up by refresh, in one dataChanged signal (meant to be called by a timer, a few times per second).
+class BatchTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column
+    {
+        LineColumn,
+        StatusColumn,
+        HashColumn,
+        ColumnCount,
+    };
+
+    explicit BatchTableModel(QObject* parent = nullptr);
+
+    // Shows another batch (or none). The batch must outlive the model, or at least its next setBatch.
+    void setBatch(BatchTable* batch);
+
+    void refresh();
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    BatchTable* batch = nullptr;
+
+    // (Views take row counts as ints: longer lists are cut off there, but still processed and exported.)
+    int rows = 0;
+};
+
+#endif // BATCHTABLEMODEL_H
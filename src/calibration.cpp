@@ -0,0 +1,126 @@
+#include "calibration.h"
+#include "constants.h"
+#include "argon2kernels.h"
+
+#include <QDateTime>
+
+Argon2TunerOptions loadTuningOptions(QSettings& settings, bool largeMemoryMode)
+{
+    Argon2TunerOptions options;
+
+    options.targetSeconds = settings.value(Constants::Settings::tuneTargetLatency, QVariant(Constants::Settings::DefaultValues::tuneTargetLatencyMs)).toDouble() / 1000.0;
+    options.concurrency = settings.value(Constants::Settings::tuneConcurrency, QVariant(Constants::Settings::DefaultValues::tuneConcurrency)).toUInt();
+    options.memoryBudget = static_cast<size_t>(settings.value(Constants::Settings::tuneMemoryBudget, QVariant(Constants::Settings::DefaultValues::tuneMemoryBudgetMiB)).toUInt()) * 1024 * 1024;
+
+    options.maxTimeCost = 128;
+    options.maxMemoryCostMiB = largeMemoryMode ? Constants::LargeMemoryMode::maxMemoryCostMiB : 128;
+    options.maxParallelism = largeMemoryMode ? Constants::LargeMemoryMode::maxParallelism : 16;
+
+    return options;
+}
+
+void saveCalibration(QSettings& settings, const Argon2TunerOptions& options, const Argon2TuningResult& result, unsigned int cores)
+{
+    settings.setValue(Constants::Settings::tuneTargetLatency, QVariant(qRound(options.targetSeconds * 1000.0)));
+    settings.setValue(Constants::Settings::tuneConcurrency, QVariant(options.concurrency));
+    settings.setValue(Constants::Settings::tuneMemoryBudget, QVariant(static_cast<uint>(options.memoryBudget / (1024 * 1024))));
+
+    settings.remove(Constants::Settings::calibration);
+    settings.beginGroup(Constants::Settings::calibration);
+
+    settings.setValue("Date", QVariant(QDateTime::currentDateTime().toString(Qt::ISODate)));
+    settings.setValue("Kernel", QVariant(QString(argon2_active_kernel())));
+    settings.setValue("Cores", QVariant(cores));
+    settings.setValue("TargetLatencyMs", QVariant(options.targetSeconds * 1000.0));
+    settings.setValue("Concurrency", QVariant(options.concurrency));
+    settings.setValue("Algorithm", QVariant(QString(argon2_type2string(result.parameters.type, 1))));
+    settings.setValue("MetTarget", QVariant(result.metTarget));
+    settings.setValue("TimeCost", QVariant(result.parameters.timeCost));
+    settings.setValue("MemoryCostKiB", QVariant(result.parameters.memoryCostKiB));
+    settings.setValue("Parallelism", QVariant(result.parameters.parallelism));
+    settings.setValue("LatencyMs", QVariant(result.seconds * 1000.0));
+
+    settings.beginWriteArray("Samples", static_cast<int>(result.samples.size()));
+
+    for (int i = 0; i < static_cast<int>(result.samples.size()); ++i)
+    {
+        const Argon2CalibrationSample& sample = result.samples[static_cast<size_t>(i)];
+
+        settings.setArrayIndex(i);
+        settings.setValue("TimeCost", QVariant(sample.parameters.timeCost));
+        settings.setValue("MemoryCostKiB", QVariant(sample.parameters.memoryCostKiB));
+        settings.setValue("Parallelism", QVariant(sample.parameters.parallelism));
+        settings.setValue("LatencyMs", QVariant(sample.seconds * 1000.0));
+    }
+
+    settings.endArray();
+    settings.endGroup();
+}
+
+QString describeCalibration(QSettings& settings)
+{
+    settings.beginGroup(Constants::Settings::calibration);
+
+    QString description;
+
+    if (settings.contains("TimeCost"))
+    {
+        description = QString("%1, t = %2, m = %3 MiB, p = %4: %5 ms with %6 concurrent hash%7 (target: %8 ms%9). Calibrated on %10 with the %11 kernel and %12 core%13.")
+                          .arg(settings.value("Algorithm").toString())
+                          .arg(settings.value("TimeCost").toUInt())
+                          .arg(settings.value("MemoryCostKiB").toUInt() / 1024)
+                          .arg(settings.value("Parallelism").toUInt())
+                          .arg(settings.value("LatencyMs").toDouble(), 0, 'f', 0)
+                          .arg(settings.value("Concurrency").toUInt())
+                          .arg(settings.value("Concurrency").toUInt() > 1 ? "es" : "")
+                          .arg(settings.value("TargetLatencyMs").toDouble(), 0, 'f', 0)
+                          .arg(settings.value("MetTarget").toBool() ? "" : ", missed")
+                          .arg(QDateTime::fromString(settings.value("Date").toString(), Qt::ISODate).toString("yyyy-MM-dd hh:mm"))
+                          .arg(settings.value("Kernel").toString())
+                          .arg(settings.value("Cores").toUInt())
+                          .arg(Constants::plural[settings.value("Cores").toUInt() > 1]);
+    }
+
+    settings.endGroup();
+    return description;
+}
+
+static QString costModelGroup()
+{
+    return QString("%1/%2").arg(Constants::Settings::costModel).arg(argon2_active_kernel());
+}
+
+bool loadCostModel(QSettings& settings, unsigned int cores, Argon2CostModel& model)
+{
+    settings.beginGroup(costModelGroup());
+
+    const bool found = settings.value("Cores").toUInt() == cores;
+
+    if (found)
+    {
+        model.overheadSeconds = settings.value("OverheadSeconds").toDouble();
+        model.smallSecondsPerByte = settings.value("SmallSecondsPerByte").toDouble();
+        model.largeSecondsPerByte = settings.value("LargeSecondsPerByte").toDouble();
+        model.parallelEfficiency = settings.value("ParallelEfficiency").toDouble();
+        model.aggregateBytesPerSecond = settings.value("AggregateBytesPerSecond").toDouble();
+        model.correction = settings.value("Correction", QVariant(1.0)).toDouble();
+    }
+
+    settings.endGroup();
+    return found && model.valid();
+}
+
+void saveCostModel(QSettings& settings, unsigned int cores, const Argon2CostModel& model)
+{
+    settings.beginGroup(costModelGroup());
+
+    settings.setValue("Cores", QVariant(cores));
+    settings.setValue("OverheadSeconds", QVariant(model.overheadSeconds));
+    settings.setValue("SmallSecondsPerByte", QVariant(model.smallSecondsPerByte));
+    settings.setValue("LargeSecondsPerByte", QVariant(model.largeSecondsPerByte));
+    settings.setValue("ParallelEfficiency", QVariant(model.parallelEfficiency));
+    settings.setValue("AggregateBytesPerSecond", QVariant(model.aggregateBytesPerSecond));
+    settings.setValue("Correction", QVariant(model.correction));
+
+    settings.endGroup();
+}
@@ -0,0 +1,26 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <QString>
+#include <QSettings>
+
+#include "argon2tuner.h"
+#include "argon2costmodel.h"
+
+// The auto-tuner's settings (latency target, concurrency and memory per hash) as last saved, by the GUI or by --tune.
+// The search space is bounded by the sliders' ranges, which depend on the large-memory mode.
+Argon2TunerOptions loadTuningOptions(QSettings& settings, bool largeMemoryMode);
+
+// Saves the tuner's settings along with the calibration (every measured sample, the result, the kernel, the number of cores and when it ran)
+// into the Constants::Settings::calibration group, replacing the previous one.
+void saveCalibration(QSettings& settings, const Argon2TunerOptions& options, const Argon2TuningResult& result, unsigned int cores);
+
+// One-line summary of the last saved calibration (empty if there's none).
+QString describeCalibration(QSettings& settings);
+
+// Cost models are cached per kernel (the active one) and only valid for the number of cores they were fitted with.
+// Returns false if there's no such model, in which case it should be fitted again (see Argon2CostModel::calibrate).
+bool loadCostModel(QSettings& settings, unsigned int cores, Argon2CostModel& model);
+void saveCostModel(QSettings& settings, unsigned int cores, const Argon2CostModel& model);
+
+#endif // CALIBRATION_H
@@ -0,0 +1,411 @@
+#include "cli.h"
+#include "constants.h"
+#include "mappedfile.h"
+#include "batchhasher.h"
+#include "bulkverifier.h"
+#include "hashdaemon.h"
+#include "argon2kernels.h"
+#include "arenapool.h"
+#include "lanepool.h"
+#include "calibration.h"
+
+#include <QSettings>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const char* headlessModes[] = { "--batch", "--verify-batch", "--daemon", "--tune" };
+
+// The options of runHeadless that take a value (as the next argument, unless it's attached with "="): that argument is never a mode.
+static const char* valueOptions[] = { "--latency", "--concurrency", "--memory-per-hash", "--socket", "--input", "--algorithm", "--time-cost", "--memory-cost", "--parallelism", "--hash-length", "--cores", "--kernel", "--memory-budget" };
+
+// The daemon that SIGINT/SIGTERM shut down gracefully (finishing the requests in flight first).
+static HashDaemon* runningDaemon = nullptr;
+
+static void onTerminationSignal(int)
+{
+    if (runningDaemon != nullptr)
+    {
+        runningDaemon->stop();
+    }
+}
+
+bool isHeadlessInvocation(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        // Everything after "--" is a positional argument.
+        if (strcmp(argv[i], "--") == 0)
+        {
+            return false;
+        }
+
+        for (const char* mode : headlessModes)
+        {
+            if (strcmp(argv[i], mode) == 0)
+            {
+                return true;
+            }
+        }
+
+        for (const char* option : valueOptions)
+        {
+            if (strcmp(argv[i], option) == 0)
+            {
+                // Skips the value (e.g. "--input --batch" reads from a file named "--batch").
+                ++i;
+                break;
+            }
+        }
+    }
+
+    return false;
+}
+
+static bool parseUnsignedOption(const QCommandLineParser& parser, const QCommandLineOption& option, uint32_t& value, uint32_t maximum = UINT32_MAX)
+{
+    if (!parser.isSet(option))
+    {
+        return true;
+    }
+
+    bool ok = false;
+    const uint32_t parsed = parser.value(option).toUInt(&ok);
+
+    if (!ok)
+    {
+        fprintf(stderr, "Invalid value \"%s\" for option --%s\n", qPrintable(parser.value(option)), qPrintable(option.names().constFirst()));
+        return false;
+    }
+
+    if (parsed > maximum)
+    {
+        fprintf(stderr, "Invalid value \"%s\" for option --%s (the maximum is %u)\n", qPrintable(parser.value(option)), qPrintable(option.names().constFirst()), maximum);
+        return false;
+    }
+
+    value = parsed;
+    return true;
+}
+
+static bool parseAlgorithmOption(const QCommandLineParser& parser, const QCommandLineOption& option, argon2_type& type)
+{
+    if (!parser.isSet(option))
+    {
+        return true;
+    }
+
+    const QString name = parser.value(option).toLower();
+
+    if (name == "argon2id")
+    {
+        type = Argon2_id;
+    }
+    else if (name == "argon2i")
+    {
+        type = Argon2_i;
+    }
+    else if (name == "argon2d")
+    {
+        type = Argon2_d;
+    }
+    else
+    {
+        fprintf(stderr, "Unknown algorithm \"%s\" (expected argon2id, argon2i or argon2d)\n", qPrintable(name));
+        return false;
+    }
+
+    return true;
+}
+
+// Hashing parameters default to whatever the sliders were last saved as (see MainWindow::~MainWindow).
+static Argon2Parameters defaultHashingParameters()
+{
+    QSettings::setDefaultFormat(QSettings::IniFormat);
+    QSettings settings;
+
+    Argon2Parameters parameters;
+
+    switch (settings.value(Constants::Settings::hashAlgo, QVariant(Constants::Settings::DefaultValues::hashAlgo)).toInt())
+    {
+        default:
+            parameters.type = Argon2_id;
+            break;
+        case 1:
+            parameters.type = Argon2_i;
+            break;
+        case 2:
+            parameters.type = Argon2_d;
+            break;
+    }
+
+    parameters.timeCost = settings.value(Constants::Settings::timeCost, QVariant(Constants::Settings::DefaultValues::timeCost)).toUInt();
+    parameters.memoryCostKiB = settings.value(Constants::Settings::memoryCost, QVariant(Constants::Settings::DefaultValues::memoryCostMiB)).toUInt() * 1024;
+    parameters.parallelism = settings.value(Constants::Settings::parallelism, QVariant(Constants::Settings::DefaultValues::parallelism)).toUInt();
+    parameters.hashLength = settings.value(Constants::Settings::hashLength, QVariant(Constants::Settings::DefaultValues::hashLength)).toUInt();
+
+    return parameters;
+}
+
+// Selects the fill_segment kernel named by --kernel, falling back to the one chosen in the settings tab.
+static bool applyKernelOption(const QCommandLineParser& parser, const QCommandLineOption& option)
+{
+    if (!parser.isSet(option))
+    {
+        QSettings settings;
+        argon2_select_kernel(settings.value(Constants::Settings::kernel, QVariant(Constants::Settings::DefaultValues::kernel)).toString().toUtf8().constData());
+        return true;
+    }
+
+    if (argon2_kernel_overridden_by_environment())
+    {
+        fprintf(stderr, "Ignoring --kernel: the kernel is already forced to \"%s\" via %s\n", argon2_active_kernel(), ARGON2_KERNEL_ENVIRONMENT_VARIABLE);
+        return true;
+    }
+
+    if (!argon2_select_kernel(parser.value(option).toUtf8().constData()))
+    {
+        QStringList available { "auto" };
+
+        for (const char* kernel : argon2_available_kernels())
+        {
+            available << kernel;
+        }
+
+        fprintf(stderr, "Unknown or unsupported Argon2 kernel \"%s\" (available on this CPU: %s)\n", qPrintable(parser.value(option)), qPrintable(available.join(", ")));
+        return false;
+    }
+
+    return true;
+}
+
+// Calibrates the parameters on this machine (see Argon2Tuner) and saves them as the sliders' values, along with the calibration data.
+// The resulting parameters are printed to stdout as command line options (e.g. for --batch).
+static int tune(Argon2Engine& engine, const Argon2TunerOptions& options)
+{
+    fprintf(stderr, "Tuning %s for %.0f ms per hash with %u concurrent hash%s on %u core%s...\n", argon2_type2string(options.type, 1), options.targetSeconds * 1000.0, options.concurrency, options.concurrency > 1 ? "es" : "", engine.cores(), Constants::plural[engine.cores() > 1]);
+
+    const Argon2TuningResult result = Argon2Tuner(engine, options).run([](const Argon2CalibrationSample& sample) {
+        fprintf(stderr, "  t = %u, m = %u MiB, p = %u: %.1f ms\n", sample.parameters.timeCost, sample.parameters.memoryCostKiB / 1024, sample.parameters.parallelism, sample.seconds * 1000.0);
+        return true;
+    });
+
+    if (result.error != ARGON2_OK)
+    {
+        fprintf(stderr, "Tuning failed: %s\n", argon2_error_message(result.error));
+        return 1;
+    }
+
+    QSettings::setDefaultFormat(QSettings::IniFormat);
+    QSettings settings;
+
+    saveCalibration(settings, options, result, engine.cores());
+
+    if (!result.metTarget)
+    {
+        fprintf(stderr, "Even the cheapest parameters (1 MiB, a single pass) took %.1f ms, which misses the target: the saved parameters were left unchanged\n", result.seconds * 1000.0);
+        return 1;
+    }
+
+    const Argon2Parameters& parameters = result.parameters;
+
+    settings.setValue(Constants::Settings::hashAlgo, QVariant(parameters.type == Argon2_i ? 1 : parameters.type == Argon2_d ? 2 : 0));
+    settings.setValue(Constants::Settings::timeCost, QVariant(parameters.timeCost));
+    settings.setValue(Constants::Settings::memoryCost, QVariant(parameters.memoryCostKiB / 1024));
+    settings.setValue(Constants::Settings::parallelism, QVariant(parameters.parallelism));
+
+    fprintf(stderr, "Done: %.1f ms per hash\n", result.seconds * 1000.0);
+    printf("--algorithm %s --time-cost %u --memory-cost %u --parallelism %u\n", argon2_type2string(parameters.type, 0), parameters.timeCost, parameters.memoryCostKiB / 1024, parameters.parallelism);
+
+    return 0;
+}
+
+static void printArenaPoolStats()
+{
+    const ArenaPoolStats stats = ArenaPool::shared().stats();
+    const uint64_t allocations = stats.hits + stats.misses;
+
+    fprintf(stderr, "Memory arenas: %llu hits, %llu misses (%.1f%% hit rate), %llu page faults, %.1f MiB wiped in the background\n", static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses), allocations != 0 ? 100.0 * static_cast<double>(stats.hits) / static_cast<double>(allocations) : 0.0, static_cast<unsigned long long>(stats.pageFaults), static_cast<double>(stats.wipedBytes) / (1024.0 * 1024.0));
+}
+
+int runHeadless(int argc, char* argv[])
+{
+    QCoreApplication application(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Argon2 GUI - headless mode");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    const QCommandLineOption batchOption("batch", "Hash the passwords read line by line from stdin (or --input) and write their PHC-encoded hashes to stdout, in input order.");
+    const QCommandLineOption verifyBatchOption("verify-batch", "Verify the \"<encoded hash> <password>\" records (one per line) of the --input file and write a PASS/FAIL report to stdout.");
+    const QCommandLineOption tuneOption("tune", "Search for the strongest parameters whose hashes meet the --latency target with --concurrency of them running at once, save them (and the calibration data) as the GUI's settings and print them. --algorithm and --hash-length apply.");
+    const QCommandLineOption latencyOption("latency", "Latency target of --tune for a single hash, in milliseconds (default: the one last used for tuning, 500 unless changed).", "ms");
+    const QCommandLineOption concurrencyOption("concurrency", "Number of hashes running at once while --tune measures them (default: the one last used for tuning, 1 unless changed).", "n");
+    const QCommandLineOption memoryPerHashOption("memory-per-hash", "Most memory a single hash may use with --tune, in MiB (default: the memory budget divided by the concurrency).", "MiB");
+    const QCommandLineOption daemonOption("daemon", "Serve hash and verify requests on the Unix domain --socket until SIGINT or SIGTERM is received (see src/core/daemonprotocol.h for the wire format).");
+    const QCommandLineOption socketOption("socket", "Path of the Unix domain socket the daemon listens on.", "path");
+    const QCommandLineOption inputOption("input", "Read the input from <file> instead of stdin (required for --verify-batch).", "file");
+    const QCommandLineOption algorithmOption("algorithm", "Argon2 variant to use: argon2id, argon2i or argon2d.", "name");
+    const QCommandLineOption timeCostOption("time-cost", "Time cost parameter (n of iterations).", "iterations");
+    const QCommandLineOption memoryCostOption("memory-cost", "Memory cost parameter (in MiB).", "MiB");
+    const QCommandLineOption parallelismOption("parallelism", "Parallelism parameter (n of lanes).", "threads");
+    const QCommandLineOption hashLengthOption("hash-length", "Desired hash length (in bytes).", "bytes");
+    const QCommandLineOption coresOption("cores", "Maximum number of threads used by all concurrent hashes together (default: every core available to the process).", "n");
+    const QCommandLineOption multiBufferOption("multi-buffer", "Throughput mode for --batch: hash several passwords at once per core, interleaved across the SIMD lanes (4 with AVX2, 8 with AVX-512, 2 with NEON). Best suited for small memory costs.");
+    const QCommandLineOption lockMemoryOption("lock-memory", "Lock the memory matrices into RAM (mlock/VirtualLock), so that they can never be swapped out (falls back to unlocked memory if the OS refuses).");
+    const QCommandLineOption arenaStatsOption("arena-stats", "Print the memory arena pool's statistics (hit rate, page faults, background wiping) to stderr once done.");
+    const QCommandLineOption pinThreadsOption("pin-threads", "Pin every lane worker thread to its own CPU core.");
+    const QCommandLineOption numaOption("numa", "Spread the lane worker threads across the NUMA nodes, so that each lane of a large (1 GiB or more) memory matrix is allocated on the node of the thread that fills it.");
+    const QCommandLineOption kernelOption("kernel", "Argon2 fill_segment kernel to use (e.g. ref, sse2, avx2, avx512f or neon; default: the one selected in the GUI, which is \"auto\" unless changed).", "name");
+    const QCommandLineOption memoryBudgetOption("memory-budget", "Maximum amount of memory used by all concurrent hashes together, in MiB (default: 3/4 of the memory available to the process, container limits included).", "MiB");
+
+    parser.addOptions({ batchOption, verifyBatchOption, daemonOption, tuneOption, socketOption, inputOption, algorithmOption, timeCostOption, memoryCostOption, parallelismOption, hashLengthOption, coresOption, memoryBudgetOption, kernelOption, multiBufferOption, lockMemoryOption, arenaStatsOption, pinThreadsOption, numaOption, latencyOption, concurrencyOption, memoryPerHashOption });
+    parser.process(application);
+
+    BatchHasherOptions options;
+    options.parameters = defaultHashingParameters();
+
+    uint32_t memoryCostMiB = options.parameters.memoryCostKiB / 1024;
+    uint32_t cores = 0;
+    uint32_t memoryBudgetMiB = 0;
+
+    Argon2TunerOptions tuningOptions;
+
+    {
+        QSettings settings;
+        tuningOptions = loadTuningOptions(settings, settings.value(Constants::Settings::largeMemoryMode, QVariant(Constants::Settings::DefaultValues::largeMemoryMode)).toBool());
+    }
+
+    uint32_t latencyMs = static_cast<uint32_t>(tuningOptions.targetSeconds * 1000.0 + 0.5);
+    uint32_t memoryPerHashMiB = static_cast<uint32_t>(tuningOptions.memoryBudget / (1024 * 1024));
+
+    if (!parseAlgorithmOption(parser, algorithmOption, options.parameters.type)
+        || !parseUnsignedOption(parser, timeCostOption, options.parameters.timeCost)
+        || !parseUnsignedOption(parser, memoryCostOption, memoryCostMiB, static_cast<uint32_t>(ARGON2_MAX_MEMORY / 1024))
+        || !parseUnsignedOption(parser, parallelismOption, options.parameters.parallelism)
+        || !parseUnsignedOption(parser, hashLengthOption, options.parameters.hashLength)
+        || !parseUnsignedOption(parser, coresOption, cores)
+        || !parseUnsignedOption(parser, memoryBudgetOption, memoryBudgetMiB)
+        || !parseUnsignedOption(parser, latencyOption, latencyMs)
+        || !parseUnsignedOption(parser, concurrencyOption, tuningOptions.concurrency)
+        || !parseUnsignedOption(parser, memoryPerHashOption, memoryPerHashMiB)
+        || !applyKernelOption(parser, kernelOption))
+    {
+        return 2;
+    }
+
+    options.parameters.memoryCostKiB = memoryCostMiB * 1024;
+    options.multiBuffer = parser.isSet(multiBufferOption);
+
+    if (parser.isSet(lockMemoryOption))
+    {
+        ArenaPoolOptions arenaOptions;
+        arenaOptions.lockMemory = true;
+        ArenaPool::shared().configure(arenaOptions);
+    }
+
+    if (parser.isSet(pinThreadsOption) || parser.isSet(numaOption))
+    {
+        LanePoolOptions laneOptions;
+        laneOptions.pinThreads = parser.isSet(pinThreadsOption);
+        laneOptions.numaAware = parser.isSet(numaOption);
+        LanePool::shared().configure(laneOptions);
+    }
+
+    Argon2Engine engine(Argon2EngineOptions { static_cast<size_t>(memoryBudgetMiB) * 1024 * 1024, cores });
+
+    if (parser.isSet(tuneOption))
+    {
+        tuningOptions.type = options.parameters.type;
+        tuningOptions.hashLength = options.parameters.hashLength;
+        tuningOptions.targetSeconds = latencyMs / 1000.0;
+        tuningOptions.memoryBudget = static_cast<size_t>(memoryPerHashMiB) * 1024 * 1024;
+
+        return tune(engine, tuningOptions);
+    }
+
+    if (parser.isSet(daemonOption))
+    {
+        if (!parser.isSet(socketOption))
+        {
+            fprintf(stderr, "--daemon needs a --socket path to listen on\n");
+            return 2;
+        }
+
+        HashDaemon daemon(engine, HashDaemonOptions { parser.value(socketOption).toLocal8Bit().toStdString() });
+
+        runningDaemon = &daemon;
+        signal(SIGINT, &onTerminationSignal);
+        signal(SIGTERM, &onTerminationSignal);
+#ifndef _WIN32
+        signal(SIGPIPE, SIG_IGN);
+#endif
+
+        const int r = daemon.run();
+
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        runningDaemon = nullptr;
+
+        if (parser.isSet(arenaStatsOption))
+        {
+            printArenaPoolStats();
+        }
+
+        return r;
+    }
+
+    if (parser.isSet(verifyBatchOption))
+    {
+        if (!parser.isSet(inputOption))
+        {
+            fprintf(stderr, "--verify-batch needs an --input file (the records are memory-mapped, so stdin can't be used)\n");
+            return 2;
+        }
+
+        MappedFile file;
+
+        if (!file.open(parser.value(inputOption).toLocal8Bit().constData()))
+        {
+            return 2;
+        }
+
+        const BulkVerifierStats stats = BulkVerifier(engine).run(file.data(), file.size(), stdout);
+
+        if (parser.isSet(arenaStatsOption))
+        {
+            printArenaPoolStats();
+        }
+
+        return stats.failed == 0 && stats.errors == 0 ? 0 : 1;
+    }
+
+    std::ios::sync_with_stdio(false);
+
+    std::ifstream file;
+
+    if (parser.isSet(inputOption) && parser.value(inputOption) != "-")
+    {
+        file.open(parser.value(inputOption).toLocal8Bit().constData(), std::ios::in | std::ios::binary);
+
+        if (!file.is_open())
+        {
+            fprintf(stderr, "Couldn't open input file \"%s\"\n", qPrintable(parser.value(inputOption)));
+            return 2;
+        }
+    }
+
+    const uint64_t failures = BatchHasher(engine, options).run(file.is_open() ? static_cast<std::istream&>(file) : std::cin, stdout);
+
+    if (parser.isSet(arenaStatsOption))
+    {
+        printArenaPoolStats();
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+#ifndef CLI_H
+#define CLI_H
+
+// Headless entry points of the argon2gui binary.
+// Nothing in here ever creates a QApplication or any widget.
+
+// Checks whether the passed command line arguments ask for one of the headless modes (e.g. "--batch").
+bool isHeadlessInvocation(int argc, char* argv[]);
+
+// Parses the command line and runs the requested headless mode. The returned value is the process' exit code.
+int runHeadless(int argc, char* argv[]);
+
+#endif // CLI_H
@@ -15,6 +15,19 @@ struct Constants
         static inline const char* memoryCost = "MemoryCostMiB";
         static inline const char* parallelism = "Parallelism";
         static inline const char* hashLength = "HashLength";
+        static inline const char* kernel = "Argon2Kernel";
+        static inline const char* largeMemoryMode = "LargeMemoryMode";
+        static inline const char* matrixFileEnabled = "MatrixFileEnabled";
+        static inline const char* matrixFilePath = "MatrixFilePath";
+        static inline const char* tuneTargetLatency = "TuneTargetLatencyMs";
+        static inline const char* tuneConcurrency = "TuneConcurrency";
+        static inline const char* tuneMemoryBudget = "TuneMemoryBudgetMiB";
+
+        // Group holding the auto-tuner's last calibration (see calibration.h).
+        static inline const char* calibration = "Calibration";
+
+        // Group holding the fitted cost models, one per kernel (see calibration.h).
+        static inline const char* costModel = "CostModel";
 
         struct DefaultValues
         {
@@ -26,9 +39,23 @@ struct Constants
             static constexpr int memoryCostMiB = 32;
             static constexpr int parallelism = 2;
             static constexpr int hashLength = 64;
+            static inline const char* kernel = "auto";
+            static constexpr bool largeMemoryMode = false;
+            static constexpr bool matrixFileEnabled = false;
+            static constexpr int tuneTargetLatencyMs = 500;
+            static constexpr int tuneConcurrency = 1;
+            static constexpr int tuneMemoryBudgetMiB = 0;
         };
     };
 
+    // In large-memory mode, the memory cost slider is logarithmic: position p stands for 2^(p / memorySliderStepsPerDoubling) MiB.
+    struct LargeMemoryMode
+    {
+        static constexpr int memorySliderStepsPerDoubling = 8;
+        static constexpr int maxMemoryCostMiB = 64 * 1024;
+        static constexpr int maxParallelism = 64;
+    };
+
     // Tiny lookup table for english plural suffix (accessible via a boolean check as an index).
     static inline const char* plural[] = { "", "s" };
 
@@ -0,0 +1,323 @@
+#include "arenapool.h"
+#include "systemresources.h"
+#include "argon2blake2b.h"
+
+#include <core.h>
+#include <blake2/blake2.h>
+#include <blake2/blake2-impl.h>
+
+#include <cstring>
+#include <iterator>
+
+#ifdef _WIN32
+#define WIN32_NO_STATUS
+#include <windows.h>
+#undef WIN32_NO_STATUS
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
+
+static const size_t pageSize = 4096;
+
+// Minor and major page faults taken by the calling thread so far (0 if the OS can't tell).
+static uint64_t pageFaults()
+{
+#if defined(RUSAGE_THREAD)
+    struct rusage usage;
+    return getrusage(RUSAGE_THREAD, &usage) == 0 ? static_cast<uint64_t>(usage.ru_minflt) + static_cast<uint64_t>(usage.ru_majflt) : 0;
+#else
+    return 0;
+#endif
+}
+
+ArenaPool& ArenaPool::shared()
+{
+    static ArenaPool pool;
+    return pool;
+}
+
+ArenaPool::ArenaPool()
+{
+    options.maxIdleBytes = availableMemory() / 8;
+    wiper = std::thread(&ArenaPool::wipe, this);
+}
+
+ArenaPool::~ArenaPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    // The wiper drains the queue before returning.
+    wipeQueued.notify_all();
+    wiper.join();
+
+    for (const Arena& arena : idle)
+    {
+        unmap(arena);
+    }
+}
+
+void ArenaPool::configure(const ArenaPoolOptions& newOptions)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    options = newOptions;
+
+    if (options.maxIdleBytes == 0)
+    {
+        options.maxIdleBytes = availableMemory() / 8;
+    }
+}
+
+ArenaPoolStats ArenaPool::stats()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return statistics;
+}
+
+uint8_t* ArenaPool::acquire(size_t size)
+{
+    bool lockMemory;
+    bool firstTouch;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (auto arena = idle.rbegin(); arena != idle.rend(); ++arena)
+        {
+            if (arena->size == size)
+            {
+                uint8_t* memory = arena->memory;
+
+                idle.erase(std::next(arena).base());
+                statistics.idleBytes -= size;
+                ++statistics.hits;
+
+                return memory;
+            }
+        }
+
+        // Not wiped yet, but no need to: the hash about to use it overwrites every block before reading it.
+        // (Large arenas never get here: their pages sit on the NUMA nodes of the previous hash's lane threads, so they're unmapped right away.)
+        for (auto arena = dirty.begin(); arena != dirty.end(); ++arena)
+        {
+            if (arena->size == size)
+            {
+                uint8_t* memory = arena->memory;
+
+                dirty.erase(arena);
+                ++statistics.hits;
+
+                return memory;
+            }
+        }
+
+        ++statistics.misses;
+        lockMemory = options.lockMemory;
+        firstTouch = size >= options.firstTouchBytes;
+    }
+
+    const uint64_t faultsBefore = pageFaults();
+
+    uint8_t* memory = map(size);
+
+    if (memory != nullptr && !firstTouch)
+    {
+#ifdef _WIN32
+        const bool locked = lockMemory && VirtualLock(memory, size);
+#else
+        // mlock() also faults in every page.
+        const bool locked = lockMemory && mlock(memory, size) == 0;
+#endif
+
+        if (!locked)
+        {
+            for (size_t offset = 0; offset < size; offset += pageSize)
+            {
+                reinterpret_cast<volatile uint8_t*>(memory)[offset] = 0;
+            }
+        }
+    }
+#if defined(MLOCK_ONFAULT)
+    else if (memory != nullptr && lockMemory)
+    {
+        mlock2(memory, size, MLOCK_ONFAULT);
+    }
+#endif
+
+    const uint64_t faults = pageFaults() - faultsBefore;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    statistics.pageFaults += faults;
+
+    return memory;
+}
+
+void ArenaPool::release(uint8_t* memory, size_t size)
+{
+    if (memory == nullptr)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (size < options.firstTouchBytes)
+        {
+            dirty.push_back(Arena { memory, size, Argon2Trace::current() });
+        }
+    }
+
+    if (size < options.firstTouchBytes)
+    {
+        wipeQueued.notify_one();
+        return;
+    }
+
+    // Large arenas are never pooled, so they're wiped and unmapped right here instead: the engine gives the job's memory back to its budget
+    // as soon as it returns, and the next large hash mustn't fault in its matrix while this one is still mapped, waiting for the wiper.
+    {
+        const Argon2TraceSpan span(Argon2Trace::current().get(), "wipe");
+        secure_wipe_memory(memory, size);
+    }
+
+    unmap(Arena { memory, size, nullptr });
+
+    std::lock_guard<std::mutex> lock(mutex);
+    statistics.wipedBytes += size;
+}
+
+uint8_t* ArenaPool::map(size_t size)
+{
+#ifdef _WIN32
+    return static_cast<uint8_t*>(VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+    void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (memory == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+#ifdef MADV_HUGEPAGE
+    // Fewer TLB misses on the random reference block accesses (and 512 times fewer page faults when faulting it in).
+    madvise(memory, size, MADV_HUGEPAGE);
+#endif
+
+    return static_cast<uint8_t*>(memory);
+#endif
+}
+
+void ArenaPool::unmap(const Arena& arena)
+{
+#ifdef _WIN32
+    VirtualFree(arena.memory, 0, MEM_RELEASE);
+#else
+    munmap(arena.memory, arena.size);
+#endif
+}
+
+void ArenaPool::wipe()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for (;;)
+    {
+        wipeQueued.wait(lock, [this] { return stopping || !dirty.empty(); });
+
+        if (dirty.empty())
+        {
+            return;
+        }
+
+        Arena arena = std::move(dirty.front());
+        dirty.pop_front();
+
+        lock.unlock();
+
+        if (arena.trace)
+        {
+            arena.trace->nameThread("Arena wiper");
+        }
+
+        {
+            const Argon2TraceSpan span(arena.trace.get(), "wipe");
+            secure_wipe_memory(arena.memory, arena.size);
+        }
+
+        // Idle arenas don't keep the trace alive.
+        arena.trace.reset();
+
+        lock.lock();
+
+        statistics.wipedBytes += arena.size;
+
+        // Make room by evicting the least recently released arenas.
+        std::vector<Arena> evicted;
+
+        while (!idle.empty() && statistics.idleBytes + arena.size > options.maxIdleBytes)
+        {
+            evicted.push_back(idle.front());
+            statistics.idleBytes -= idle.front().size;
+            idle.erase(idle.begin());
+        }
+
+        if (statistics.idleBytes + arena.size <= options.maxIdleBytes)
+        {
+            idle.push_back(arena);
+            statistics.idleBytes += arena.size;
+        }
+        else
+        {
+            evicted.push_back(arena);
+        }
+
+        lock.unlock();
+
+        for (const Arena& evictedArena : evicted)
+        {
+            unmap(evictedArena);
+        }
+
+        lock.lock();
+    }
+}
+
+int argon2_arena_allocate(uint8_t** memory, size_t bytes_to_allocate)
+{
+    *memory = ArenaPool::shared().acquire(bytes_to_allocate);
+    return *memory != nullptr ? ARGON2_OK : ARGON2_MEMORY_ALLOCATION_ERROR;
+}
+
+void argon2_arena_free(uint8_t* memory, size_t bytes_to_allocate)
+{
+    ArenaPool::shared().release(memory, bytes_to_allocate);
+}
+
+void argon2_arena_finalize(const argon2_context* context, argon2_instance_t* instance)
+{
+    argon2_arena_finalize_many(&context, &instance, 1);
+}
+
+void argon2_arena_finalize_many(const argon2_context* const* contexts, argon2_instance_t* const* instances, size_t count)
+{
+    // What follows mirrors finalize(), minus the wiping of pooled matrices.
+    argon2_finalize_tags(contexts, instances, count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (contexts[i]->free_cbk == &argon2_arena_free)
+        {
+            ArenaPool::shared().release(reinterpret_cast<uint8_t*>(instances[i]->memory), static_cast<size_t>(instances[i]->memory_blocks) * sizeof(block));
+        }
+        else
+        {
+            free_memory(contexts[i], reinterpret_cast<uint8_t*>(instances[i]->memory), instances[i]->memory_blocks, sizeof(block));
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef ARENAPOOL_H
+#define ARENAPOOL_H
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+
+#include <argon2.h>
+
+#include "argon2trace.h"
+
+struct ArenaPoolOptions
+{
+    // How much memory idle arenas may keep around in total (0 means: 1/8 of the currently available memory).
+    size_t maxIdleBytes = 0;
+
+    // Lock the arenas into RAM (mlock/VirtualLock), so that memory matrices never end up in the swap file.
+    // If the OS refuses (e.g. because of RLIMIT_MEMLOCK), the arena is used unlocked.
+    bool lockMemory = false;
+
+    // Arenas of at least this size are neither faulted in up front nor kept in the pool once released: they're wiped and unmapped by the
+    // releasing thread, so that their memory is gone by the time the job that used them returns (and the engine admits the next one).
+    // Their pages are then faulted in by the lane threads as they first write to them, in parallel and, thanks to the OS's first-touch policy,
+    // on the NUMA node of the thread that fills the lane (see LanePoolOptions::numaAware). Locked ones are locked on fault (where supported).
+    size_t firstTouchBytes = static_cast<size_t>(1) << 30;
+};
+
+struct ArenaPoolStats
+{
+    // Allocations served by an idle arena vs. ones that had to map (and fault in) a new one.
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    // Page faults taken while faulting in new arenas (0 where the OS can't tell).
+    uint64_t pageFaults = 0;
+
+    // Bytes zeroized by the background wiper.
+    uint64_t wipedBytes = 0;
+
+    size_t idleBytes = 0;
+};
+
+// Process-wide pool of memory matrices for the Argon2 library's allocate_cbk/free_cbk.
+// Every arena is mapped separately (advised to be backed by transparent huge pages on Linux) and, unless it's a large one, faulted in right away,
+// so that the hash that gets it never page-faults; released arenas are kept per size, to be handed out again to the next hash
+// with the same parameters. Instead of wiping a matrix on the critical path (which is what the library does before freeing it),
+// finished arenas are queued to a background thread that zeroizes them before they go back to the pool (large ones excepted, see firstTouchBytes).
+// An arena that's still waiting to be wiped can be handed out right away: Argon2 overwrites every block before ever reading it.
+class ArenaPool
+{
+public:
+    static ArenaPool& shared();
+
+    ArenaPool(const ArenaPool&) = delete;
+    ArenaPool& operator=(const ArenaPool&) = delete;
+
+    // Only affects arenas mapped (or released) from then on.
+    void configure(const ArenaPoolOptions& options);
+
+    ArenaPoolStats stats();
+
+    // Returns nullptr if the memory can't be mapped.
+    uint8_t* acquire(size_t size);
+
+    // The arena must not be wiped by the caller: the pool does it in the background (traced into the calling thread's current trace, if any),
+    // or right away for arenas of at least firstTouchBytes.
+    void release(uint8_t* memory, size_t size);
+
+private:
+    struct Arena
+    {
+        uint8_t* memory;
+        size_t size;
+        std::shared_ptr<Argon2Trace> trace;
+    };
+
+    std::mutex mutex;
+    std::condition_variable wipeQueued;
+    std::deque<Arena> dirty;
+    std::vector<Arena> idle;
+    std::thread wiper;
+    bool stopping = false;
+
+    ArenaPoolOptions options;
+    ArenaPoolStats statistics;
+
+    ArenaPool();
+    ~ArenaPool();
+
+    uint8_t* map(size_t size);
+    void unmap(const Arena& arena);
+    void wipe();
+};
+
+// allocate_fptr and deallocate_fptr for argon2_context, backed by the shared pool.
+int argon2_arena_allocate(uint8_t** memory, size_t bytes_to_allocate);
+void argon2_arena_free(uint8_t* memory, size_t bytes_to_allocate);
+
+struct Argon2_instance_t;
+
+// Drop-in replacement for the library's finalize() (core.h): for contexts allocating through argon2_arena_allocate,
+// the matrix goes back to the pool without being wiped on the calling thread (the pool's wiper takes care of that).
+// Any other context is simply passed on to finalize().
+void argon2_arena_finalize(const argon2_context* context, Argon2_instance_t* instance);
+
+// argon2_arena_finalize for several instances with the same output length, whose tags are hashed together (see argon2_blake2b_long_many).
+void argon2_arena_finalize_many(const argon2_context* const* contexts, Argon2_instance_t* const* instances, size_t count);
+
+#endif // ARENAPOOL_H
@@ -0,0 +1,136 @@
+#include "argon2addresscache.h"
+#include "argon2multibufferkernel.h"
+
+#include <list>
+#include <mutex>
+
+// Total size of the tables kept around. The cache is shared by every engine and isn't charged to any job's memory cost,
+// so it's kept small next to the matrices: a table larger than this isn't built at all.
+static const size_t cacheBytes = 64 * 1024 * 1024;
+
+// Passes beyond which Argon2i gets no table: it holds 4 bytes per block and pass, so up to 16 bytes per 1 KiB block here.
+static const uint32_t maxArgon2iPasses = 4;
+
+Argon2AddressTable::Argon2AddressTable(const argon2_instance_t* instance)
+    : lanes(instance->lanes)
+    , segmentLength(instance->segment_length)
+    , slicesPerPass(instance->type == Argon2_i ? ARGON2_SYNC_POINTS : ARGON2_SYNC_POINTS / 2)
+{
+    const uint32_t passes = instance->type == Argon2_i ? instance->passes : 1;
+
+    offsets.resize(static_cast<size_t>(passes) * slicesPerPass * lanes * segmentLength);
+
+    block addressBlock;
+    block inputBlock;
+    block zeroBlock;
+
+    for (uint32_t pass = 0; pass < passes; ++pass)
+    {
+        for (uint32_t slice = 0; slice < slicesPerPass; ++slice)
+        {
+            for (uint32_t lane = 0; lane < lanes; ++lane)
+            {
+                argon2_position_t position { pass, lane, static_cast<uint8_t>(slice), 0 };
+
+                uint32_t* segmentOffsets = offsets.data() + ((static_cast<size_t>(pass) * slicesPerPass + slice) * lanes + lane) * segmentLength;
+
+                // Same sequence as in fillSegments() (argon2multibufferkernel.h) and the library's fill_segment().
+                initAddressInput(instance, position, &inputBlock, &zeroBlock);
+
+                uint32_t startingIndex = 0;
+
+                if (pass == 0 && slice == 0)
+                {
+                    startingIndex = 2;
+                    nextAddresses(&addressBlock, &inputBlock, &zeroBlock);
+                }
+
+                for (uint32_t i = startingIndex; i < segmentLength; ++i)
+                {
+                    if (i % ARGON2_ADDRESSES_IN_BLOCK == 0)
+                    {
+                        nextAddresses(&addressBlock, &inputBlock, &zeroBlock);
+                    }
+
+                    position.index = i;
+                    segmentOffsets[i] = referenceOffset(instance, position, addressBlock.v[i % ARGON2_ADDRESSES_IN_BLOCK]);
+                }
+            }
+        }
+    }
+}
+
+const uint32_t* Argon2AddressTable::segment(const argon2_position_t& position) const
+{
+    const size_t index = (static_cast<size_t>(position.pass) * slicesPerPass + position.slice) * lanes + position.lane;
+
+    if (position.slice >= slicesPerPass || index * segmentLength >= offsets.size())
+    {
+        return NULL;
+    }
+
+    return offsets.data() + index * segmentLength;
+}
+
+struct CacheEntry
+{
+    argon2_type type;
+    uint32_t passes;
+    uint32_t lanes;
+    uint32_t memoryBlocks;
+    size_t bytes;
+    std::shared_ptr<const Argon2AddressTable> table;
+};
+
+std::shared_ptr<const Argon2AddressTable> argon2_address_table(const argon2_instance_t* instance)
+{
+    if (instance->type != Argon2_i && instance->type != Argon2_id)
+    {
+        return nullptr;
+    }
+
+    // Argon2id only needs half a pass worth of offsets, Argon2i needs all of them.
+    if (instance->type == Argon2_i && instance->passes > maxArgon2iPasses)
+    {
+        return nullptr;
+    }
+
+    const uint32_t passes = instance->type == Argon2_i ? instance->passes : 1;
+    const uint32_t slicesPerPass = instance->type == Argon2_i ? ARGON2_SYNC_POINTS : ARGON2_SYNC_POINTS / 2;
+    const size_t bytes = static_cast<size_t>(passes) * slicesPerPass * instance->lanes * instance->segment_length * sizeof(uint32_t);
+
+    if (bytes > cacheBytes)
+    {
+        return nullptr;
+    }
+
+    static std::mutex mutex;
+    static std::list<CacheEntry> entries;
+    static size_t totalBytes = 0;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto entry = entries.begin(); entry != entries.end(); ++entry)
+    {
+        if (entry->type == instance->type && entry->passes == instance->passes && entry->lanes == instance->lanes && entry->memoryBlocks == instance->memory_blocks)
+        {
+            // Most recently used first.
+            entries.splice(entries.begin(), entries, entry);
+            return entries.front().table;
+        }
+    }
+
+    // Computed while holding the lock on purpose: concurrent jobs with the same parameters wait for this one table
+    // instead of all computing their own (it takes a tiny fraction of a single hash anyway).
+    entries.push_front(CacheEntry { instance->type, instance->passes, instance->lanes, instance->memory_blocks, bytes, std::make_shared<const Argon2AddressTable>(instance) });
+    totalBytes += bytes;
+
+    // (Evicted tables live on until the jobs using them are done: that's at most one per running group.)
+    while (totalBytes > cacheBytes)
+    {
+        totalBytes -= entries.back().bytes;
+        entries.pop_back();
+    }
+
+    return entries.front().table;
+}
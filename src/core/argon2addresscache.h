@@ -0,0 +1,38 @@
+#ifndef ARGON2ADDRESSCACHE_H
+#define ARGON2ADDRESSCACHE_H
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include <core.h>
+
+// In Argon2i (and in the first half pass of Argon2id) the blocks a segment references only depend on the parameters
+// (type, passes, lanes and memory size) and the position, never on the password or salt. This table holds them all,
+// resolved to block offsets (lane * lane_length + index), so that jobs sharing a parameter set don't have to generate
+// the address blocks (two compressions per 128 blocks) and resolve the reference indices over and over again.
+// Only the multi-buffer segment loop (argon2multibufferkernel.h) reads it: the library's fill_segment kernels, which every other
+// hash runs, generate their addresses internally and can't take a table (and a table-taking scalar loop would cost them their SIMD).
+class Argon2AddressTable
+{
+public:
+    explicit Argon2AddressTable(const argon2_instance_t* instance);
+
+    // The reference offsets of the segment at the passed position (indexed by the block's index within the segment),
+    // or NULL if that segment's addressing is data-dependent.
+    const uint32_t* segment(const argon2_position_t& position) const;
+
+private:
+    uint32_t lanes;
+    uint32_t segmentLength;
+    uint32_t slicesPerPass;
+    std::vector<uint32_t> offsets;
+};
+
+// Returns the table for the passed instance's parameters, shared by all threads and computed the first time it's needed.
+// The most recently used tables are kept around (up to a few dozen MiB in all), so that a batch with identical parameters only ever
+// computes its table once. Returns nullptr if the parameters have no data-independent segments, or if the table would be too large
+// (Argon2i with more than a few passes, or matrices of several GiB).
+std::shared_ptr<const Argon2AddressTable> argon2_address_table(const argon2_instance_t* instance);
+
+#endif // ARGON2ADDRESSCACHE_H
@@ -0,0 +1,208 @@
+#include "argon2blake2b.h"
+#include "argon2kernels.h"
+
+#include <core.h>
+#include <blake2/blake2.h>
+#include <blake2/blake2-impl.h>
+
+#include <vector>
+#include <cstring>
+
+typedef void (*MultiBufferBlake2bLong)(uint8_t* const* outputs, uint32_t outlen, const uint8_t* const* inputs, size_t inlen);
+
+// Compiled with their own instruction set flags, along with the multi-buffer fill_segment (see CMakeLists.txt).
+#ifdef ARGON2GUI_MULTIBUFFER_AVX2
+void argon2_multibuffer_blake2b_long_avx2(uint8_t* const* outputs, uint32_t outlen, const uint8_t* const* inputs, size_t inlen);
+#endif
+#ifdef ARGON2GUI_MULTIBUFFER_AVX512F
+void argon2_multibuffer_blake2b_long_avx512f(uint8_t* const* outputs, uint32_t outlen, const uint8_t* const* inputs, size_t inlen);
+#endif
+#ifdef ARGON2GUI_MULTIBUFFER_NEON
+void argon2_multibuffer_blake2b_long_neon(uint8_t* const* outputs, uint32_t outlen, const uint8_t* const* inputs, size_t inlen);
+#endif
+
+struct Blake2bKernel
+{
+    // Name of the regular kernel (see argon2kernels.cpp) this one goes with: it's used whenever that one is active.
+    const char* kernel;
+    MultiBufferBlake2bLong hash;
+    uint32_t width;
+};
+
+// The first entry stands for the library's scalar blake2b_long, used with every kernel without a multi-buffer version.
+static const Blake2bKernel blake2bKernels[] = {
+    { "ref", nullptr, 1 },
+#ifdef ARGON2GUI_MULTIBUFFER_AVX2
+    { "avx2", &argon2_multibuffer_blake2b_long_avx2, 4 },
+#endif
+#ifdef ARGON2GUI_MULTIBUFFER_AVX512F
+    { "avx512f", &argon2_multibuffer_blake2b_long_avx512f, 8 },
+#endif
+#ifdef ARGON2GUI_MULTIBUFFER_NEON
+    { "neon", &argon2_multibuffer_blake2b_long_neon, 2 },
+#endif
+};
+
+static const Blake2bKernel& activeBlake2bKernel()
+{
+    const char* active = argon2_active_kernel();
+
+    for (const Blake2bKernel& kernel : blake2bKernels)
+    {
+        if (strcmp(kernel.kernel, active) == 0)
+        {
+            return kernel;
+        }
+    }
+
+    return blake2bKernels[0];
+}
+
+uint32_t argon2_blake2b_width()
+{
+    return activeBlake2bKernel().width;
+}
+
+void argon2_blake2b_long_many(uint8_t* const* outputs, uint32_t outlen, const uint8_t* const* inputs, size_t inlen, size_t count)
+{
+    const Blake2bKernel& kernel = activeBlake2bKernel();
+
+    size_t i = 0;
+
+    // Groups of more than one input are worth a multi-buffer pass: a partial one is padded with its last input,
+    // whose duplicates compute (and store) exactly the same output.
+    while (kernel.hash != nullptr && i + 1 < count)
+    {
+        const uint8_t* groupInputs[16];
+        uint8_t* groupOutputs[16];
+
+        for (uint32_t lane = 0; lane < kernel.width; ++lane)
+        {
+            const size_t index = i + lane < count ? i + lane : count - 1;
+
+            groupInputs[lane] = inputs[index];
+            groupOutputs[lane] = outputs[index];
+        }
+
+        kernel.hash(groupOutputs, outlen, groupInputs, inlen);
+        i += kernel.width;
+    }
+
+    for (; i < count; ++i)
+    {
+        blake2b_long(outputs[i], outlen, inputs[i], inlen);
+    }
+}
+
+// One lane whose first two blocks are to be filled.
+struct FirstBlocksLane
+{
+    const uint8_t* blockhash;
+    const argon2_instance_t* instance;
+    uint32_t lane;
+};
+
+static void fillFirstBlocks(const std::vector<FirstBlocksLane>& lanes)
+{
+    const size_t total = 2 * lanes.size();
+
+    // The seeds are H0 || LE32(block index) || LE32(lane), like fill_first_blocks' blockhash: hashed into bytes, then loaded as blocks (load_block of core.c).
+    std::vector<uint8_t> seeds(total * ARGON2_PREHASH_SEED_LENGTH);
+    std::vector<uint8_t> bytes(total * ARGON2_BLOCK_SIZE);
+    std::vector<const uint8_t*> inputs(total);
+    std::vector<uint8_t*> outputs(total);
+
+    for (size_t k = 0; k < total; ++k)
+    {
+        uint8_t* seed = seeds.data() + k * ARGON2_PREHASH_SEED_LENGTH;
+
+        memcpy(seed, lanes[k / 2].blockhash, ARGON2_PREHASH_DIGEST_LENGTH);
+        store32(seed + ARGON2_PREHASH_DIGEST_LENGTH, static_cast<uint32_t>(k % 2));
+        store32(seed + ARGON2_PREHASH_DIGEST_LENGTH + 4, lanes[k / 2].lane);
+
+        inputs[k] = seed;
+        outputs[k] = bytes.data() + k * ARGON2_BLOCK_SIZE;
+    }
+
+    argon2_blake2b_long_many(outputs.data(), ARGON2_BLOCK_SIZE, inputs.data(), ARGON2_PREHASH_SEED_LENGTH, total);
+
+    for (size_t k = 0; k < total; ++k)
+    {
+        const argon2_instance_t* instance = lanes[k / 2].instance;
+        block* first = instance->memory + lanes[k / 2].lane * instance->lane_length + k % 2;
+
+        for (unsigned int j = 0; j < ARGON2_QWORDS_IN_BLOCK; ++j)
+        {
+            first->v[j] = load64(outputs[k] + j * sizeof(uint64_t));
+        }
+    }
+
+    clear_internal_memory(seeds.data(), seeds.size());
+    clear_internal_memory(bytes.data(), bytes.size());
+}
+
+void argon2_fill_first_blocks(const uint8_t* const* blockhashes, const argon2_instance_t* const* instances, size_t count)
+{
+    std::vector<FirstBlocksLane> lanes;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (uint32_t lane = 0; lane < instances[i]->lanes; ++lane)
+        {
+            lanes.push_back(FirstBlocksLane { blockhashes[i], instances[i], lane });
+        }
+    }
+
+    fillFirstBlocks(lanes);
+}
+
+void argon2_fill_first_blocks_of_lanes(const uint8_t* blockhash, const argon2_instance_t* instance, uint32_t firstLane, uint32_t laneStep)
+{
+    std::vector<FirstBlocksLane> lanes;
+
+    for (uint32_t lane = firstLane; lane < instance->lanes; lane += laneStep)
+    {
+        lanes.push_back(FirstBlocksLane { blockhash, instance, lane });
+    }
+
+    fillFirstBlocks(lanes);
+}
+
+void argon2_finalize_tags(const argon2_context* const* contexts, const argon2_instance_t* const* instances, size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::vector<uint8_t> blockhashBytes(count * ARGON2_BLOCK_SIZE);
+    std::vector<const uint8_t*> inputs(count);
+    std::vector<uint8_t*> outputs(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const argon2_instance_t* instance = instances[i];
+
+        block blockhash;
+        copy_block(&blockhash, instance->memory + instance->lane_length - 1);
+
+        for (uint32_t lane = 1; lane < instance->lanes; ++lane)
+        {
+            xor_block(&blockhash, instance->memory + lane * instance->lane_length + instance->lane_length - 1);
+        }
+
+        inputs[i] = blockhashBytes.data() + i * ARGON2_BLOCK_SIZE;
+        outputs[i] = static_cast<uint8_t*>(contexts[i]->out);
+
+        for (unsigned int j = 0; j < ARGON2_QWORDS_IN_BLOCK; ++j)
+        {
+            store64(blockhashBytes.data() + i * ARGON2_BLOCK_SIZE + j * sizeof(blockhash.v[j]), blockhash.v[j]);
+        }
+
+        clear_internal_memory(blockhash.v, ARGON2_BLOCK_SIZE);
+    }
+
+    argon2_blake2b_long_many(outputs.data(), contexts[0]->outlen, inputs.data(), ARGON2_BLOCK_SIZE, count);
+
+    clear_internal_memory(blockhashBytes.data(), blockhashBytes.size());
+}
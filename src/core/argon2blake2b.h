@@ -0,0 +1,32 @@
+#ifndef ARGON2BLAKE2B_H
+#define ARGON2BLAKE2B_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <argon2.h>
+
+struct Argon2_instance_t;
+
+// Multi-buffer H' (the library's variable-length hash blake2b_long, see argon2blake2bkernel.h): several inputs of the same length hashed at once,
+// one per SIMD lane of the active kernel's instruction set. The outputs are identical to blake2b_long's, bit for bit.
+
+// How many inputs the active kernel (see argon2kernels.h) hashes at once: 4 with AVX2, 8 with AVX-512F, 2 with NEON, and 1 otherwise.
+uint32_t argon2_blake2b_width();
+
+// blake2b_long(outputs[i], outlen, inputs[i], inlen) for every i < count. A lone input (or the last one of a group) goes to the library's scalar code.
+void argon2_blake2b_long_many(uint8_t* const* outputs, uint32_t outlen, const uint8_t* const* inputs, size_t inlen, size_t count);
+
+// The library's fill_first_blocks for several instances: the first two blocks of every lane of every instance, all hashed together,
+// from each instance's H0 (the ARGON2_PREHASH_DIGEST_LENGTH bytes initial_hash computes).
+void argon2_fill_first_blocks(const uint8_t* const* blockhashes, const Argon2_instance_t* const* instances, size_t count);
+
+// The same for the lanes firstLane, firstLane + laneStep, firstLane + 2 * laneStep... of a single instance: what one lane thread fills,
+// so that it's also the thread that first touches those lanes' memory (see LanePoolOptions::numaAware).
+void argon2_fill_first_blocks_of_lanes(const uint8_t* blockhash, const Argon2_instance_t* instance, uint32_t firstLane, uint32_t laneStep);
+
+// The tags the library's finalize computes from the last blocks of every lane, for several instances with the same output length,
+// all hashed together. Unlike finalize, leaves the matrices alone.
+void argon2_finalize_tags(const argon2_context* const* contexts, const Argon2_instance_t* const* instances, size_t count);
+
+#endif // ARGON2BLAKE2B_H
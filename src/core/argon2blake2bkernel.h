@@ -0,0 +1,250 @@
+#ifndef ARGON2BLAKE2BKERNEL_H
+#define ARGON2BLAKE2BKERNEL_H
+
+// Multi-buffer BLAKE2b: hashes Lanes::count independent messages of the same length at once, with word j of message i's state
+// in lane i of vector j (the layout and the lane sets of argon2multibufferkernel.h, whose note on the anonymous namespace applies here too).
+// Since the messages have the same length, the counter and the final block flag are the same in every lane: the code below is
+// blake2b.c's blake2b_compress with uint64_t swapped for a vector type. On top of it sits H' (blake2b_long), whose chain of
+// 64-byte hashes never leaves the registers: only the 32 bytes each link contributes to the output are stored.
+//
+// On top of what argon2multibufferkernel.h lists, a lane set must provide: 64-bit add and broadcast (the same word in every lane).
+
+#include <core.h>
+#include <blake2/blake2.h>
+#include <blake2/blake2-impl.h>
+
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+    const uint64_t blake2bIV[8] = {
+        UINT64_C(0x6a09e667f3bcc908), UINT64_C(0xbb67ae8584caa73b), UINT64_C(0x3c6ef372fe94f82b), UINT64_C(0xa54ff53a5f1d36f1),
+        UINT64_C(0x510e527fade682d1), UINT64_C(0x9b05688c2b3e6c1f), UINT64_C(0x1f83d9abfb41bd6b), UINT64_C(0x5be0cd19137e2179)
+    };
+
+    const uint8_t blake2bSigma[12][16] = {
+        { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+        { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+        { 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+        { 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+        { 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+        { 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+        { 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+        { 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+        { 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+        { 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },
+        { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+        { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 }
+    };
+
+    template <typename Lanes>
+    inline void blake2bG(typename Lanes::Vector& a, typename Lanes::Vector& b, typename Lanes::Vector& c, typename Lanes::Vector& d, typename Lanes::Vector x, typename Lanes::Vector y)
+    {
+        a = Lanes::add(Lanes::add(a, b), x);
+        d = Lanes::rotr32(Lanes::xor_(d, a));
+        c = Lanes::add(c, d);
+        b = Lanes::rotr24(Lanes::xor_(b, c));
+        a = Lanes::add(Lanes::add(a, b), y);
+        d = Lanes::rotr16(Lanes::xor_(d, a));
+        c = Lanes::add(c, d);
+        b = Lanes::rotr63(Lanes::xor_(b, c));
+    }
+
+    // blake2b_compress of blake2b.c: counter is the number of bytes hashed so far (this block's included).
+    template <typename Lanes>
+    inline void blake2bCompress(typename Lanes::Vector* h, const typename Lanes::Vector* m, uint64_t counter, bool last)
+    {
+        typedef typename Lanes::Vector Vector;
+
+        Vector v[16];
+
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            v[i] = h[i];
+        }
+
+        v[8] = Lanes::broadcast(blake2bIV[0]);
+        v[9] = Lanes::broadcast(blake2bIV[1]);
+        v[10] = Lanes::broadcast(blake2bIV[2]);
+        v[11] = Lanes::broadcast(blake2bIV[3]);
+        v[12] = Lanes::broadcast(blake2bIV[4] ^ counter);
+        v[13] = Lanes::broadcast(blake2bIV[5]);
+        v[14] = Lanes::broadcast(last ? ~blake2bIV[6] : blake2bIV[6]);
+        v[15] = Lanes::broadcast(blake2bIV[7]);
+
+        for (unsigned int r = 0; r < 12; ++r)
+        {
+            const uint8_t* s = blake2bSigma[r];
+
+            blake2bG<Lanes>(v[0], v[4], v[8], v[12], m[s[0]], m[s[1]]);
+            blake2bG<Lanes>(v[1], v[5], v[9], v[13], m[s[2]], m[s[3]]);
+            blake2bG<Lanes>(v[2], v[6], v[10], v[14], m[s[4]], m[s[5]]);
+            blake2bG<Lanes>(v[3], v[7], v[11], v[15], m[s[6]], m[s[7]]);
+            blake2bG<Lanes>(v[0], v[5], v[10], v[15], m[s[8]], m[s[9]]);
+            blake2bG<Lanes>(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+            blake2bG<Lanes>(v[2], v[7], v[8], v[13], m[s[12]], m[s[13]]);
+            blake2bG<Lanes>(v[3], v[4], v[9], v[14], m[s[14]], m[s[15]]);
+        }
+
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            h[i] = Lanes::xor_(h[i], Lanes::xor_(v[i], v[i + 8]));
+        }
+    }
+
+    // The state blake2b_init sets up for an unkeyed hash of outlen bytes.
+    template <typename Lanes>
+    inline void blake2bInit(typename Lanes::Vector* h, uint32_t outlen)
+    {
+        // The parameter block's first word: digest length, no key, fanout and depth 1.
+        h[0] = Lanes::broadcast(blake2bIV[0] ^ UINT64_C(0x01010000) ^ outlen);
+
+        for (unsigned int i = 1; i < 8; ++i)
+        {
+            h[i] = Lanes::broadcast(blake2bIV[i]);
+        }
+    }
+
+    // The 8 bytes at offset (a multiple of 8) of prefix || input, where the prefix is 4 bytes long and anything past the end reads as 0.
+    inline uint64_t prefixedWord(const uint8_t* prefix, const uint8_t* input, size_t inlen, size_t offset)
+    {
+        if (offset >= 4 && offset + 4 <= inlen)
+        {
+            return load64(input + offset - 4);
+        }
+
+        uint8_t bytes[8];
+
+        for (size_t b = 0; b < 8; ++b)
+        {
+            const size_t position = offset + b;
+            bytes[b] = position < 4 ? prefix[position] : (position - 4 < inlen ? input[position - 4] : 0);
+        }
+
+        return load64(bytes);
+    }
+
+    // blake2b(outlen, prefix || inputs[i]) of blake2b_long's first step (prefix being the output length), leaving the digests in h.
+    template <typename Lanes>
+    inline void blake2bPrefixed(typename Lanes::Vector* h, uint32_t outlen, const uint8_t* prefix, const uint8_t* const* inputs, size_t inlen, uint64_t* words)
+    {
+        typedef typename Lanes::Vector Vector;
+
+        const size_t length = 4 + inlen;
+
+        blake2bInit<Lanes>(h, outlen);
+
+        // Like blake2b_update, only the block holding the last byte is compressed as the last one (even when it's full).
+        for (size_t offset = 0;; offset += BLAKE2B_BLOCKBYTES)
+        {
+            const bool last = offset + BLAKE2B_BLOCKBYTES >= length;
+
+            for (unsigned int j = 0; j < 16; ++j)
+            {
+                for (unsigned int lane = 0; lane < Lanes::count; ++lane)
+                {
+                    words[j * Lanes::count + lane] = prefixedWord(prefix, inputs[lane], inlen, offset + j * sizeof(uint64_t));
+                }
+            }
+
+            Vector m[16];
+
+            for (unsigned int j = 0; j < 16; ++j)
+            {
+                m[j] = Lanes::load(words + j * Lanes::count);
+            }
+
+            blake2bCompress<Lanes>(h, m, last ? length : offset + BLAKE2B_BLOCKBYTES, last);
+
+            if (last)
+            {
+                return;
+            }
+        }
+    }
+
+    // Copies the first length bytes of every lane's digest to outputs[lane] + position.
+    template <typename Lanes>
+    inline void storeDigests(const typename Lanes::Vector* h, uint8_t* const* outputs, size_t position, size_t length, uint64_t* words)
+    {
+        for (unsigned int j = 0; j < 8; ++j)
+        {
+            Lanes::store(words + j * Lanes::count, h[j]);
+        }
+
+        for (unsigned int lane = 0; lane < Lanes::count; ++lane)
+        {
+            uint8_t digest[BLAKE2B_OUTBYTES];
+
+            for (unsigned int j = 0; j < 8; ++j)
+            {
+                store64(digest + j * sizeof(uint64_t), words[j * Lanes::count + lane]);
+            }
+
+            memcpy(outputs[lane] + position, digest, length);
+        }
+    }
+
+    // blake2b_long(outputs[i], outlen, inputs[i], inlen) for the Lanes::count inputs.
+    template <typename Lanes>
+    inline void blake2bLong(uint8_t* const* outputs, uint32_t outlen, const uint8_t* const* inputs, size_t inlen)
+    {
+        typedef typename Lanes::Vector Vector;
+
+        uint8_t prefix[sizeof(uint32_t)];
+        store32(prefix, outlen);
+
+        Vector h[8];
+        uint64_t words[16 * Lanes::count];
+
+        if (outlen <= BLAKE2B_OUTBYTES)
+        {
+            blake2bPrefixed<Lanes>(h, outlen, prefix, inputs, inlen, words);
+            storeDigests<Lanes>(h, outputs, 0, outlen, words);
+        }
+        else
+        {
+            blake2bPrefixed<Lanes>(h, BLAKE2B_OUTBYTES, prefix, inputs, inlen, words);
+            storeDigests<Lanes>(h, outputs, 0, BLAKE2B_OUTBYTES / 2, words);
+
+            size_t position = BLAKE2B_OUTBYTES / 2;
+            uint32_t toproduce = outlen - BLAKE2B_OUTBYTES / 2;
+
+            // Every following link hashes the previous one's 64 bytes: a single block, whose upper half is zero padding.
+            Vector m[16];
+
+            for (unsigned int j = 8; j < 16; ++j)
+            {
+                m[j] = Lanes::broadcast(0);
+            }
+
+            while (true)
+            {
+                const uint32_t length = std::min<uint32_t>(toproduce, BLAKE2B_OUTBYTES);
+
+                for (unsigned int j = 0; j < 8; ++j)
+                {
+                    m[j] = h[j];
+                }
+
+                blake2bInit<Lanes>(h, length);
+                blake2bCompress<Lanes>(h, m, BLAKE2B_OUTBYTES, true);
+
+                if (toproduce <= BLAKE2B_OUTBYTES)
+                {
+                    storeDigests<Lanes>(h, outputs, position, toproduce, words);
+                    break;
+                }
+
+                storeDigests<Lanes>(h, outputs, position, BLAKE2B_OUTBYTES / 2, words);
+                position += BLAKE2B_OUTBYTES / 2;
+                toproduce -= BLAKE2B_OUTBYTES / 2;
+            }
+        }
+
+        clear_internal_memory(words, sizeof(words));
+    }
+}
+
+#endif // ARGON2BLAKE2BKERNEL_H
@@ -0,0 +1,170 @@
+#include "argon2costmodel.h"
+
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+// The small matrix fits into most CPUs' last level cache, the large one into none.
+static const uint32_t smallMemoryCostKiB = 4 * 1024;
+static const uint32_t largeMemoryCostKiB = 64 * 1024;
+
+// Used for the parallel and aggregate measurements.
+static const uint32_t mediumMemoryCostKiB = 16 * 1024;
+
+// Weight of the latest observation in the correction factor's moving average.
+static const double correctionWeight = 0.25;
+
+// Median time (over a few rounds, after an untimed warm-up round) of hashing with the passed parameters, "concurrency" hashes at once.
+static double measure(Argon2Engine& engine, const Argon2Parameters& parameters, unsigned int concurrency)
+{
+    Argon2HashRequest request;
+    request.parameters = parameters;
+    request.password = "correct horse battery staple";
+
+    std::vector<double> rounds;
+
+    for (int round = 0; round <= 3; ++round)
+    {
+        std::vector<std::future<Argon2HashResult>> hashes;
+        const auto start = std::chrono::steady_clock::now();
+
+        for (unsigned int i = 0; i < concurrency; ++i)
+        {
+            hashes.push_back(engine.hash(request));
+        }
+
+        for (std::future<Argon2HashResult>& hash : hashes)
+        {
+            if (hash.get().error != ARGON2_OK)
+            {
+                return 0.0;
+            }
+        }
+
+        if (round != 0)
+        {
+            rounds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+
+    std::sort(rounds.begin(), rounds.end());
+    return rounds[rounds.size() / 2];
+}
+
+Argon2CostModel Argon2CostModel::calibrate(Argon2Engine& engine)
+{
+    Argon2CostModel model;
+
+    Argon2Parameters parameters;
+    parameters.type = Argon2_id;
+    parameters.parallelism = 1;
+    parameters.timeCost = 1;
+
+    // A tiny matrix is all overhead; the difference to three passes over the small one is pure memory traffic.
+    parameters.memoryCostKiB = 256;
+    const double tiny = measure(engine, parameters, 1);
+    const double tinyTraffic = static_cast<double>(Argon2Engine::memoryTraffic(parameters));
+
+    parameters.memoryCostKiB = smallMemoryCostKiB;
+    parameters.timeCost = 3;
+    const double small = measure(engine, parameters, 1);
+    const double smallTraffic = static_cast<double>(Argon2Engine::memoryTraffic(parameters));
+
+    if (tiny <= 0.0 || small <= tiny)
+    {
+        return model;
+    }
+
+    model.smallSecondsPerByte = (small - tiny) / (smallTraffic - tinyTraffic);
+    model.overheadSeconds = std::max(0.0, tiny - tinyTraffic * model.smallSecondsPerByte);
+
+    parameters.memoryCostKiB = largeMemoryCostKiB;
+    parameters.timeCost = 1;
+    const double large = measure(engine, parameters, 1);
+
+    model.largeSecondsPerByte = std::max(large - model.overheadSeconds, 0.0) / static_cast<double>(Argon2Engine::memoryTraffic(parameters));
+
+    if (!model.valid())
+    {
+        return model;
+    }
+
+    parameters.memoryCostKiB = mediumMemoryCostKiB;
+
+    // How much of a thread's bandwidth every additional lane thread adds.
+    const unsigned int threads = std::min(engine.cores(), 4u);
+
+    if (threads > 1)
+    {
+        const double serial = model.trafficSeconds(parameters, 1);
+
+        parameters.parallelism = threads;
+
+        const double parallel = measure(engine, parameters, 1);
+        const double speedup = serial / std::max(parallel - model.overheadSeconds, 1e-9);
+
+        model.parallelEfficiency = std::clamp((speedup - 1.0) / (threads - 1), 0.05, 1.0);
+        parameters.parallelism = 1;
+    }
+
+    // Every core hashing at once: that's where the memory bandwidth runs out, if anywhere.
+    const unsigned int concurrency = std::max(1u, std::min<unsigned int>(engine.cores(), static_cast<unsigned int>(engine.memoryBudget() / (mediumMemoryCostKiB * 1024ull))));
+    const double aggregate = measure(engine, parameters, concurrency);
+
+    model.aggregateBytesPerSecond = aggregate > 0.0 ? concurrency * static_cast<double>(Argon2Engine::memoryTraffic(parameters)) / aggregate : 0.0;
+
+    return model;
+}
+
+double Argon2CostModel::trafficSeconds(const Argon2Parameters& parameters, unsigned int threads) const
+{
+    // Interpolated on a log scale of the matrix size, constant beyond the two calibrated sizes.
+    const double position = std::clamp(std::log2(static_cast<double>(std::max(parameters.memoryCostKiB, 1u)) / smallMemoryCostKiB) / std::log2(static_cast<double>(largeMemoryCostKiB) / smallMemoryCostKiB), 0.0, 1.0);
+    const double secondsPerByte = smallSecondsPerByte + position * (largeSecondsPerByte - smallSecondsPerByte);
+    const double speedup = 1.0 + (std::max(threads, 1u) - 1) * parallelEfficiency;
+
+    return static_cast<double>(Argon2Engine::memoryTraffic(parameters)) * secondsPerByte / speedup;
+}
+
+Argon2CostPrediction Argon2CostModel::predict(const Argon2Parameters& parameters, const Argon2Engine& engine) const
+{
+    const Argon2JobCost cost = engine.hashCost(parameters);
+
+    Argon2CostPrediction prediction;
+    prediction.peakMemoryBytes = cost.memoryBytes;
+
+    if (!valid())
+    {
+        return prediction;
+    }
+
+    prediction.seconds = overheadSeconds + correction * trafficSeconds(parameters, cost.cores);
+
+    const size_t concurrentByMemory = cost.memoryBytes != 0 ? engine.memoryBudget() / cost.memoryBytes : 0;
+    const unsigned int concurrent = static_cast<unsigned int>(std::min<size_t>(engine.cores() / cost.cores, concurrentByMemory));
+
+    prediction.maxHashesPerSecond = std::max(concurrent, 1u) / prediction.seconds;
+
+    if (aggregateBytesPerSecond > 0.0)
+    {
+        prediction.maxHashesPerSecond = std::min(prediction.maxHashesPerSecond, aggregateBytesPerSecond / correction / static_cast<double>(Argon2Engine::memoryTraffic(parameters)));
+    }
+
+    return prediction;
+}
+
+void Argon2CostModel::observe(const Argon2Parameters& parameters, const Argon2Engine& engine, double seconds)
+{
+    if (!valid() || seconds <= 0.0)
+    {
+        return;
+    }
+
+    // Hashes that are mostly overhead say little about the bandwidth: every observation counts as much as its traffic term's share of the time.
+    const double traffic = trafficSeconds(parameters, engine.hashCost(parameters).cores);
+    const double ratio = std::max(seconds - overheadSeconds, 0.0) / traffic;
+    const double weight = correctionWeight * traffic / (traffic + overheadSeconds);
+
+    correction += weight * (ratio - correction);
+}
@@ -0,0 +1,54 @@
+#ifndef ARGON2COSTMODEL_H
+#define ARGON2COSTMODEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "argon2engine.h"
+
+struct Argon2CostPrediction
+{
+    double seconds = 0.0;
+
+    // Size of the memory matrix, which is what a hash's memory usage peaks at.
+    size_t peakMemoryBytes = 0;
+
+    // Throughput of the whole engine if it did nothing but hash with these parameters: as many at once as its cores and memory budget allow,
+    // capped by the memory bandwidth all cores together achieved during the calibration.
+    double maxHashesPerSecond = 0.0;
+};
+
+// Predicts what hashing with given parameters costs on an engine, without hashing. A hash's time is a fixed overhead plus its memory traffic
+// (see Argon2Engine::memoryTraffic) divided by the bandwidth its lane threads achieve together, each thread beyond the first adding
+// a fitted fraction of a single thread's bandwidth. That bandwidth drops as the matrix outgrows the caches (and the TLB's reach): it's measured
+// for a small and a large matrix and interpolated (on a log scale) in between. The coefficients are fitted by calibrate() and the predictions are
+// then kept honest by observe(): every real hash's measured time moves a correction factor (of the traffic term) towards the measured ratio.
+// Plain data, so that it can be cached (e.g. per kernel, since the kernel is what the bandwidth depends on most).
+struct Argon2CostModel
+{
+    double overheadSeconds = 0.0;
+    double smallSecondsPerByte = 0.0;
+    double largeSecondsPerByte = 0.0;
+    double parallelEfficiency = 1.0;
+    double aggregateBytesPerSecond = 0.0;
+    double correction = 1.0;
+
+    // Hashes a few matrices of up to 64 MiB on the passed engine (blocking, for about half a second) and fits the model to their timings.
+    static Argon2CostModel calibrate(Argon2Engine& engine);
+
+    bool valid() const
+    {
+        return smallSecondsPerByte > 0.0 && largeSecondsPerByte > 0.0;
+    }
+
+    Argon2CostPrediction predict(const Argon2Parameters& parameters, const Argon2Engine& engine) const;
+
+    // Feeds back how long a real hash with the passed parameters took (ideally one that ran alone on the engine).
+    void observe(const Argon2Parameters& parameters, const Argon2Engine& engine, double seconds);
+
+private:
+    // Time the memory traffic takes according to the fitted coefficients alone, without the overhead and the correction factor.
+    double trafficSeconds(const Argon2Parameters& parameters, unsigned int threads) const;
+};
+
+#endif // ARGON2COSTMODEL_H
@@ -0,0 +1,373 @@
+#include "argon2engine.h"
+#include "argon2progress.h"
+#include "argon2verify.h"
+#include "argon2multibuffer.h"
+#include "arenapool.h"
+#include "systemresources.h"
+#include "saltgenerator.h"
+#include "phcstring.h"
+#include "argon2kernels.h"
+#include "matrixfile.h"
+
+#include <core.h>
+
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+struct ProgressContext
+{
+    const Argon2ProgressCallback* callback;
+};
+
+static int onProgress(uint32_t pass, uint32_t slice, uint32_t passes, void* userData)
+{
+    const ProgressContext* context = static_cast<const ProgressContext*>(userData);
+    return (*context->callback)(pass * ARGON2_SYNC_POINTS + slice + 1, passes * ARGON2_SYNC_POINTS) ? 0 : 1;
+}
+
+// Size of the memory matrix the library actually allocates for the passed parameters
+// (at least 8 blocks per lane, rounded down to a whole number of segments).
+static size_t matrixSize(uint32_t memoryCostKiB, uint32_t parallelism)
+{
+    const uint64_t lanes = std::max<uint32_t>(parallelism, 1);
+    const uint64_t blocks = std::max<uint64_t>(memoryCostKiB, 2 * ARGON2_SYNC_POINTS * lanes);
+    const uint64_t rounded = blocks / (lanes * ARGON2_SYNC_POINTS) * (lanes * ARGON2_SYNC_POINTS);
+
+    return static_cast<size_t>(std::min<uint64_t>(rounded * ARGON2_BLOCK_SIZE, SIZE_MAX));
+}
+
+Argon2Engine::Argon2Engine(const Argon2EngineOptions& options)
+{
+    budget = options.memoryBudget != 0 ? options.memoryBudget : availableMemory() / 4 * 3;
+    coreCount = options.cores != 0 ? options.cores : availableCores();
+
+    workers.reserve(coreCount);
+
+    for (unsigned int i = 0; i < coreCount; ++i)
+    {
+        workers.emplace_back(&Argon2Engine::work, this);
+    }
+}
+
+Argon2Engine::~Argon2Engine()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    admissionChanged.notify_all();
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+Argon2JobCost Argon2Engine::hashCost(const Argon2Parameters& parameters) const
+{
+    return Argon2JobCost { matrixSize(parameters.memoryCostKiB, parameters.parallelism), std::clamp(parameters.parallelism, 1u, coreCount) };
+}
+
+uint64_t Argon2Engine::memoryTraffic(const Argon2Parameters& parameters)
+{
+    const uint64_t blocks = matrixSize(parameters.memoryCostKiB, parameters.parallelism) / ARGON2_BLOCK_SIZE;
+    const uint64_t passes = std::max<uint32_t>(parameters.timeCost, 1);
+
+    return blocks * (3 + 4 * (passes - 1)) * ARGON2_BLOCK_SIZE;
+}
+
+void Argon2Engine::enqueue(Argon2JobCost cost, std::function<void()> run)
+{
+    cost.cores = std::clamp(cost.cores, 1u, coreCount);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(Job { cost, std::move(run) });
+    }
+
+    admissionChanged.notify_all();
+}
+
+void Argon2Engine::work()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for (;;)
+    {
+        // Strict FIFO: only the job at the head of the queue is ever admitted, so a large job can't be starved by a stream of small ones.
+        admissionChanged.wait(lock, [this] { return queue.empty() ? stopping : usedMemory + queue.front().cost.memoryBytes <= budget && usedCores + queue.front().cost.cores <= coreCount; });
+
+        if (queue.empty())
+        {
+            return;
+        }
+
+        Job job = std::move(queue.front());
+        queue.pop_front();
+
+        usedMemory += job.cost.memoryBytes;
+        usedCores += job.cost.cores;
+
+        lock.unlock();
+
+        // The next job in line might fit into what's left of the budget.
+        admissionChanged.notify_all();
+
+        job.run();
+        job.run = nullptr;
+
+        lock.lock();
+
+        usedMemory -= job.cost.memoryBytes;
+        usedCores -= job.cost.cores;
+
+        admissionChanged.notify_all();
+    }
+}
+
+std::future<Argon2HashResult> Argon2Engine::hash(Argon2HashRequest request, Argon2ProgressCallback progress, std::function<void(const Argon2HashResult&)> finished)
+{
+    Argon2JobCost cost = hashCost(request.parameters);
+
+    // A matrix file is backed by the page cache, which gives memory back to the system as it needs to.
+    if (!request.matrixFile.empty())
+    {
+        cost.memoryBytes = 0;
+    }
+
+    if (cost.memoryBytes > budget)
+    {
+        secure_wipe_memory(request.password.data(), request.password.size());
+
+        const Argon2HashResult result { ARGON2_MEMORY_TOO_MUCH, std::string() };
+
+        if (finished)
+        {
+            finished(result);
+        }
+
+        std::promise<Argon2HashResult> promise;
+        promise.set_value(result);
+        return promise.get_future();
+    }
+
+    return submit(cost, [request = std::move(request), progress = std::move(progress), finished = std::move(finished), threads = cost.cores]() mutable {
+        const Argon2Parameters& parameters = request.parameters;
+
+        const Argon2TraceAttachment attachment(request.trace);
+        Argon2TraceSpan span(request.trace.get(), "hash");
+
+        if (request.trace)
+        {
+            request.trace->nameThread("Engine worker");
+            span.setArguments("\"type\":\"" + std::string(argon2_type2string(parameters.type, 0)) + "\",\"t\":" + std::to_string(parameters.timeCost) + ",\"m\":" + std::to_string(parameters.memoryCostKiB) + ",\"p\":" + std::to_string(parameters.parallelism) + ",\"threads\":" + std::to_string(std::min(parameters.parallelism, threads)) + ",\"kernel\":\"" + argon2_active_kernel() + "\"");
+        }
+
+        Argon2HashResult result { ARGON2_OK, std::string() };
+
+        if (progress && !progress(0, parameters.timeCost * ARGON2_SYNC_POINTS))
+        {
+            result.error = ARGON2_ABORTED;
+        }
+
+        if (result.error == ARGON2_OK && request.salt.empty() && !request.matrixFile.empty())
+        {
+            request.salt = Argon2MatrixFile::checkpointSalt(request.matrixFile);
+        }
+
+        if (result.error == ARGON2_OK && request.salt.empty())
+        {
+            uint8_t salt[32];
+            random_salt(salt, sizeof(salt));
+            request.salt.assign(reinterpret_cast<const char*>(salt), sizeof(salt));
+        }
+
+        if (result.error == ARGON2_OK && parameters.hashLength > 1024)
+        {
+            result.error = ARGON2_OUTPUT_TOO_LONG;
+        }
+
+        if (result.error == ARGON2_OK)
+        {
+            uint8_t out[1024];
+            char encodedHash[1024] = { 0x00 };
+
+            argon2_context context;
+            memset(&context, 0x00, sizeof(context));
+
+            context.out = out;
+            context.outlen = parameters.hashLength;
+            context.pwd = reinterpret_cast<uint8_t*>(request.password.data());
+            context.pwdlen = static_cast<uint32_t>(std::min<size_t>(request.password.size(), ARGON2_MAX_PWD_LENGTH));
+            context.salt = reinterpret_cast<uint8_t*>(request.salt.data());
+            context.saltlen = static_cast<uint32_t>(std::min<size_t>(request.salt.size(), ARGON2_MAX_SALT_LENGTH));
+            context.t_cost = parameters.timeCost;
+            context.m_cost = parameters.memoryCostKiB;
+            context.lanes = parameters.parallelism;
+            context.threads = std::min(parameters.parallelism, threads);
+            context.allocate_cbk = &argon2_arena_allocate;
+            context.free_cbk = &argon2_arena_free;
+            context.flags = ARGON2_DEFAULT_FLAGS;
+            context.version = ARGON2_VERSION_NUMBER;
+
+            if (request.password.size() > ARGON2_MAX_PWD_LENGTH)
+            {
+                result.error = ARGON2_PWD_TOO_LONG;
+            }
+            else if (request.salt.size() > ARGON2_MAX_SALT_LENGTH)
+            {
+                result.error = ARGON2_SALT_TOO_LONG;
+            }
+            else
+            {
+                ProgressContext progressContext { &progress };
+
+                // (Deleted again once the hash ends, however it ends.)
+                std::unique_ptr<Argon2MatrixFile> matrixFile;
+
+                if (!request.matrixFile.empty())
+                {
+                    matrixFile = std::make_unique<Argon2MatrixFile>(request.matrixFile, request.checkpointSeconds);
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+                result.error = argon2_progress_ctx(&context, parameters.type, progress ? &onProgress : nullptr, &progressContext, matrixFile.get());
+                result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+
+            if (result.error == ARGON2_OK && encodePhcString(parameters.type, context.version, context.m_cost, context.t_cost, context.lanes, context.salt, context.saltlen, context.out, context.outlen, encodedHash, sizeof(encodedHash)) == SIZE_MAX)
+            {
+                result.error = ARGON2_ENCODING_FAIL;
+            }
+
+            if (result.error == ARGON2_OK)
+            {
+                result.encodedHash = encodedHash;
+            }
+
+            clear_internal_memory(out, sizeof(out));
+            clear_internal_memory(encodedHash, sizeof(encodedHash));
+        }
+
+        secure_wipe_memory(request.password.data(), request.password.size());
+
+        // Whoever the finished callback hands the trace to may write it out right away.
+        span.end();
+
+        if (finished)
+        {
+            finished(result);
+        }
+
+        return result;
+    });
+}
+
+std::future<std::vector<Argon2HashResult>> Argon2Engine::hashMultiBuffer(const Argon2Parameters& parameters, std::vector<std::string> passwords)
+{
+    const size_t matrix = matrixSize(parameters.memoryCostKiB, parameters.parallelism);
+
+    // (Checking against the budget before multiplying, so that the product can't overflow.)
+    const Argon2JobCost cost { matrix > budget / std::max<size_t>(passwords.size(), 1) ? budget + 1 : matrix * passwords.size(), 1 };
+
+    if (cost.memoryBytes > budget)
+    {
+        for (std::string& password : passwords)
+        {
+            secure_wipe_memory(password.data(), password.size());
+        }
+
+        std::promise<std::vector<Argon2HashResult>> promise;
+        promise.set_value(std::vector<Argon2HashResult>(passwords.size(), Argon2HashResult { ARGON2_MEMORY_TOO_MUCH, std::string() }));
+        return promise.get_future();
+    }
+
+    return submit(cost, [parameters, passwords = std::move(passwords)]() mutable {
+        const size_t count = passwords.size();
+
+        std::vector<uint8_t> salts(count * 32);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            random_salt(salts.data() + 32 * i, 32);
+        }
+
+        std::vector<char> encodedHashes(count * 1024, 0x00);
+        std::vector<argon2_multibuffer_job> jobs(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            jobs[i] = argon2_multibuffer_job { passwords[i].data(), passwords[i].size(), salts.data() + 32 * i, 32, encodedHashes.data() + 1024 * i, 1024, ARGON2_OK };
+        }
+
+        argon2_multibuffer_hash_encoded(parameters.timeCost, parameters.memoryCostKiB, parameters.parallelism, parameters.hashLength, parameters.type, jobs.data(), static_cast<uint32_t>(count));
+
+        std::vector<Argon2HashResult> results(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            results[i].error = jobs[i].result;
+
+            if (jobs[i].result == ARGON2_OK)
+            {
+                results[i].encodedHash = jobs[i].encoded;
+            }
+
+            secure_wipe_memory(passwords[i].data(), passwords[i].size());
+        }
+
+        clear_internal_memory(encodedHashes.data(), encodedHashes.size());
+
+        return results;
+    });
+}
+
+std::future<int> Argon2Engine::verify(std::string encodedHash, std::string password, Argon2ProgressCallback progress, std::function<void(int)> finished)
+{
+    PhcString phc;
+    Argon2JobCost cost;
+
+    const bool valid = parsePhcString(encodedHash, phc);
+
+    if (valid)
+    {
+        cost = Argon2JobCost { matrixSize(phc.memoryCostKiB, phc.parallelism), std::clamp(phc.parallelism, 1u, coreCount) };
+    }
+
+    if (!valid || cost.memoryBytes > budget)
+    {
+        secure_wipe_memory(password.data(), password.size());
+
+        const int result = valid ? ARGON2_MEMORY_TOO_MUCH : ARGON2_DECODING_FAIL;
+
+        if (finished)
+        {
+            finished(result);
+        }
+
+        std::promise<int> promise;
+        promise.set_value(result);
+        return promise.get_future();
+    }
+
+    return submit(cost, [encodedHash = std::move(encodedHash), password = std::move(password), progress = std::move(progress), finished = std::move(finished), passes = phc.timeCost, threads = cost.cores]() mutable {
+        int result = ARGON2_ABORTED;
+
+        if (!progress || progress(0, passes * ARGON2_SYNC_POINTS))
+        {
+            ProgressContext progressContext { &progress };
+            result = argon2_verify_encoded(encodedHash, password.data(), password.size(), threads, &argon2_arena_allocate, &argon2_arena_free, progress ? &onProgress : nullptr, &progressContext);
+        }
+
+        secure_wipe_memory(password.data(), password.size());
+
+        if (finished)
+        {
+            finished(result);
+        }
+
+        return result;
+    });
+}
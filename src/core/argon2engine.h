@@ -0,0 +1,167 @@
+#ifndef ARGON2ENGINE_H
+#define ARGON2ENGINE_H
+
+#include <deque>
+#include <mutex>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+#include <argon2.h>
+
+#include "argon2trace.h"
+
+struct Argon2Parameters
+{
+    argon2_type type = Argon2_id;
+    uint32_t timeCost = 16;
+    uint32_t memoryCostKiB = 32 * 1024;
+    uint32_t parallelism = 2;
+    uint32_t hashLength = 64;
+};
+
+struct Argon2HashRequest
+{
+    Argon2Parameters parameters;
+    std::string password;
+
+    // Leave this empty to have the engine generate a 32-byte salt from the system's CSPRNG.
+    std::string salt;
+
+    // Set this to record the hash's phases into a trace (off by default: then tracing costs nothing but a few null checks).
+    std::shared_ptr<Argon2Trace> trace;
+
+    // Set this to keep the matrix in a file at that path instead of in memory, checkpointed every checkpointSeconds (see matrixfile.h).
+    // Such a job doesn't count against the memory budget. With an empty salt, it takes the salt of the file's checkpoint, if there's one.
+    std::string matrixFile;
+    double checkpointSeconds = 60.0;
+};
+
+struct Argon2HashResult
+{
+    int error = ARGON2_OK;
+    std::string encodedHash;
+
+    // Wall-clock time spent computing the hash (memory allocation included, queueing not), 0 if it didn't run.
+    double seconds = 0.0;
+};
+
+// What a job needs to be admitted by the engine's scheduler.
+struct Argon2JobCost
+{
+    size_t memoryBytes = 0;
+    unsigned int cores = 1;
+};
+
+// Invoked (on an engine worker thread) once right before a job starts, with slicesDone == 0, and then after every completed slice.
+// Return false to cancel the job: if it didn't start yet it won't even allocate its memory.
+typedef std::function<bool(uint32_t slicesDone, uint32_t slicesTotal)> Argon2ProgressCallback;
+
+struct Argon2EngineOptions
+{
+    // Maximum amount of memory (in bytes) that all running jobs may use together (0 means: 3/4 of the currently available memory).
+    size_t memoryBudget = 0;
+
+    // Maximum number of threads all running jobs may use together (0 means: one per available core).
+    unsigned int cores = 0;
+};
+
+// Runs Argon2 jobs on a fixed pool of worker threads, admitting them in strict submission order
+// only once both their memory matrix and their threads fit into the engine's budget.
+// That way, queueing up dozens of 128 MiB hashes can never allocate more than the budget at once
+// (which by default is derived from the memory actually available to the process, cgroup limits included).
+// All methods are thread-safe; results are delivered through futures and, optionally, a completion callback.
+class Argon2Engine
+{
+public:
+    explicit Argon2Engine(const Argon2EngineOptions& options = Argon2EngineOptions());
+
+    // Waits for all submitted jobs to complete.
+    ~Argon2Engine();
+
+    Argon2Engine(const Argon2Engine&) = delete;
+    Argon2Engine& operator=(const Argon2Engine&) = delete;
+
+    size_t memoryBudget() const
+    {
+        return budget;
+    }
+
+    unsigned int cores() const
+    {
+        return coreCount;
+    }
+
+    // How much memory and how many threads hashing with the passed parameters takes on this engine.
+    Argon2JobCost hashCost(const Argon2Parameters& parameters) const;
+
+    // Bytes the block function reads from and writes to the memory matrix over a whole hash with the passed parameters:
+    // 3 blocks per block computed during the first pass (previous and reference block in, new block out) and 4 during the next ones
+    // (the overwritten block is XORed in). Divided by Argon2HashResult::seconds, that's the memory bandwidth the hash achieved.
+    static uint64_t memoryTraffic(const Argon2Parameters& parameters);
+
+    // The finished callback (if any) is invoked on the thread that completed the job, right before the future becomes ready.
+    // Jobs that wouldn't fit into the memory budget even on an otherwise idle engine fail right away with ARGON2_MEMORY_TOO_MUCH.
+    std::future<Argon2HashResult> hash(Argon2HashRequest request, Argon2ProgressCallback progress = nullptr, std::function<void(const Argon2HashResult&)> finished = nullptr);
+
+    // Hashes several passwords with the same parameters (and a random 32-byte salt each) as a single multi-buffer job (see argon2multibuffer.h):
+    // one core computes them all at once, interleaved across its SIMD lanes. That's a throughput mode: each result is only ready once the whole group is,
+    // and the job needs the memory of all its matrices at once. Results are in the same order as the passwords.
+    std::future<std::vector<Argon2HashResult>> hashMultiBuffer(const Argon2Parameters& parameters, std::vector<std::string> passwords);
+
+    // Verifies a password against an encoded hash string: the result is ARGON2_OK, ARGON2_VERIFY_MISMATCH or another Argon2 error code.
+    std::future<int> verify(std::string encodedHash, std::string password, Argon2ProgressCallback progress = nullptr, std::function<void(int)> finished = nullptr);
+
+    // Schedules any function to run on the engine once the passed cost fits into the budget.
+    // A cost larger than the whole budget is rejected: the function never runs, and the returned future is ready right away
+    // with a std::length_error (like hash and verify, whose futures then hold ARGON2_MEMORY_TOO_MUCH).
+    template <typename Function>
+    std::future<std::invoke_result_t<Function>> submit(const Argon2JobCost& cost, Function&& function)
+    {
+        if (cost.memoryBytes > budget)
+        {
+            std::promise<std::invoke_result_t<Function>> rejected;
+            rejected.set_exception(std::make_exception_ptr(std::length_error("The job's memory cost exceeds the engine's memory budget")));
+            return rejected.get_future();
+        }
+
+        auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Function>()>>(std::forward<Function>(function));
+        std::future<std::invoke_result_t<Function>> future = task->get_future();
+
+        enqueue(cost, [task] { (*task)(); });
+
+        return future;
+    }
+
+private:
+    struct Job
+    {
+        Argon2JobCost cost;
+        std::function<void()> run;
+    };
+
+    size_t budget;
+    unsigned int coreCount;
+
+    std::mutex mutex;
+    std::condition_variable admissionChanged;
+    std::deque<Job> queue;
+    size_t usedMemory = 0;
+    unsigned int usedCores = 0;
+    bool stopping = false;
+
+    std::vector<std::thread> workers;
+
+    void enqueue(Argon2JobCost cost, std::function<void()> run);
+    void work();
+};
+
+#endif // ARGON2ENGINE_H
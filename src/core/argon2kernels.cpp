@@ -0,0 +1,245 @@
+#include "argon2kernels.h"
+
+#include <core.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+// Every kernel is the library's own ref.c or opt.c, compiled with fill_segment renamed to one of these (see CMakeLists.txt).
+void argon2_fill_segment_ref(const argon2_instance_t* instance, argon2_position_t position);
+#ifdef ARGON2GUI_KERNEL_SSE2
+void argon2_fill_segment_sse2(const argon2_instance_t* instance, argon2_position_t position);
+#endif
+#ifdef ARGON2GUI_KERNEL_SSSE3
+void argon2_fill_segment_ssse3(const argon2_instance_t* instance, argon2_position_t position);
+#endif
+#ifdef ARGON2GUI_KERNEL_AVX2
+void argon2_fill_segment_avx2(const argon2_instance_t* instance, argon2_position_t position);
+#endif
+#ifdef ARGON2GUI_KERNEL_AVX512F
+void argon2_fill_segment_avx512f(const argon2_instance_t* instance, argon2_position_t position);
+#endif
+#ifdef ARGON2GUI_KERNEL_NEON
+void argon2_fill_segment_neon(const argon2_instance_t* instance, argon2_position_t position);
+#endif
+
+enum class CpuFeature
+{
+    None,
+    Sse2,
+    Ssse3,
+    Avx2,
+    Avx512f,
+};
+
+struct Kernel
+{
+    const char* name;
+    void (*fillSegment)(const argon2_instance_t* instance, argon2_position_t position);
+    CpuFeature requirement;
+};
+
+// Ordered from the slowest to the fastest.
+static const Kernel kernels[] = {
+    { "ref", &argon2_fill_segment_ref, CpuFeature::None },
+#ifdef ARGON2GUI_KERNEL_SSE2
+    { "sse2", &argon2_fill_segment_sse2, CpuFeature::Sse2 },
+#endif
+#ifdef ARGON2GUI_KERNEL_SSSE3
+    { "ssse3", &argon2_fill_segment_ssse3, CpuFeature::Ssse3 },
+#endif
+#ifdef ARGON2GUI_KERNEL_AVX2
+    { "avx2", &argon2_fill_segment_avx2, CpuFeature::Avx2 },
+#endif
+#ifdef ARGON2GUI_KERNEL_AVX512F
+    { "avx512f", &argon2_fill_segment_avx512f, CpuFeature::Avx512f },
+#endif
+#ifdef ARGON2GUI_KERNEL_NEON
+    // NEON is part of the ARMv8-A baseline, so there's nothing to check for on ARM64.
+    { "neon", &argon2_fill_segment_neon, CpuFeature::None },
+#endif
+};
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+
+static bool cpuSupports(CpuFeature feature)
+{
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    const bool ssse3 = (info[2] & (1 << 9)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+
+    // AVX registers are only usable if the OS saves them on context switches (XCR0 bits 1-2 for YMM, 5-7 for ZMM).
+    const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    const bool ymm = (xcr0 & 0x06) == 0x06;
+    const bool zmm = (xcr0 & 0xE6) == 0xE6;
+
+    int extended[4] = { 0, 0, 0, 0 };
+
+    if (maxLeaf >= 7)
+    {
+        __cpuidex(extended, 7, 0);
+    }
+
+    switch (feature)
+    {
+        case CpuFeature::None:
+            return true;
+        case CpuFeature::Sse2:
+            return sse2;
+        case CpuFeature::Ssse3:
+            return ssse3;
+        case CpuFeature::Avx2:
+            return ymm && (extended[1] & (1 << 5)) != 0;
+        case CpuFeature::Avx512f:
+            return zmm && (extended[1] & (1 << 16)) != 0;
+    }
+
+    return false;
+}
+
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+
+static bool cpuSupports(CpuFeature feature)
+{
+    // These also check that the OS has enabled the AVX/AVX-512 register state.
+    switch (feature)
+    {
+        case CpuFeature::None:
+            return true;
+        case CpuFeature::Sse2:
+            return __builtin_cpu_supports("sse2");
+        case CpuFeature::Ssse3:
+            return __builtin_cpu_supports("ssse3");
+        case CpuFeature::Avx2:
+            return __builtin_cpu_supports("avx2");
+        case CpuFeature::Avx512f:
+            return __builtin_cpu_supports("avx512f");
+    }
+
+    return false;
+}
+
+#else
+
+static bool cpuSupports(CpuFeature feature)
+{
+    return feature == CpuFeature::None;
+}
+
+#endif
+
+static const Kernel* findKernel(const char* name)
+{
+    for (const Kernel& kernel : kernels)
+    {
+        if (strcmp(kernel.name, name) == 0 && cpuSupports(kernel.requirement))
+        {
+            return &kernel;
+        }
+    }
+
+    return nullptr;
+}
+
+static const Kernel* fastestKernel()
+{
+    for (size_t i = sizeof(kernels) / sizeof(kernels[0]); i > 0; --i)
+    {
+        if (cpuSupports(kernels[i - 1].requirement))
+        {
+            return &kernels[i - 1];
+        }
+    }
+
+    return &kernels[0];
+}
+
+static const Kernel* environmentKernel()
+{
+    static const Kernel* const kernel = [] {
+        const char* name = getenv(ARGON2_KERNEL_ENVIRONMENT_VARIABLE);
+
+        if (name == nullptr || *name == '\0' || strcmp(name, "auto") == 0)
+        {
+            return static_cast<const Kernel*>(nullptr);
+        }
+
+        const Kernel* found = findKernel(name);
+
+        if (found == nullptr)
+        {
+            fprintf(stderr, "Argon2 kernel \"%s\" (requested via %s) isn't available on this machine: using \"%s\" instead\n", name, ARGON2_KERNEL_ENVIRONMENT_VARIABLE, fastestKernel()->name);
+        }
+
+        return found;
+    }();
+
+    return kernel;
+}
+
+static std::atomic<const Kernel*>& activeKernel()
+{
+    static std::atomic<const Kernel*> kernel { environmentKernel() != nullptr ? environmentKernel() : fastestKernel() };
+    return kernel;
+}
+
+std::vector<const char*> argon2_available_kernels()
+{
+    std::vector<const char*> names;
+
+    for (const Kernel& kernel : kernels)
+    {
+        if (cpuSupports(kernel.requirement))
+        {
+            names.push_back(kernel.name);
+        }
+    }
+
+    return names;
+}
+
+const char* argon2_active_kernel()
+{
+    return activeKernel().load(std::memory_order_relaxed)->name;
+}
+
+bool argon2_kernel_overridden_by_environment()
+{
+    return environmentKernel() != nullptr;
+}
+
+bool argon2_select_kernel(const char* name)
+{
+    if (environmentKernel() != nullptr)
+    {
+        return false;
+    }
+
+    const Kernel* kernel = name == nullptr || *name == '\0' || strcmp(name, "auto") == 0 ? fastestKernel() : findKernel(name);
+
+    if (kernel == nullptr)
+    {
+        return false;
+    }
+
+    activeKernel().store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
+// This is the symbol the rest of the library (and argon2progress.cpp) calls: it forwards every segment to the active kernel.
+// One indirect call per segment (not per block) is all the dispatching costs.
+void fill_segment(const argon2_instance_t* instance, argon2_position_t position)
+{
+    activeKernel().load(std::memory_order_relaxed)->fillSegment(instance, position);
+}
@@ -0,0 +1,27 @@
+#ifndef ARGON2KERNELS_H
+#define ARGON2KERNELS_H
+
+#include <vector>
+
+// The Argon2 library's memory filling kernel (fill_segment) is compiled several times, once per instruction set level
+// (ref, sse2, ssse3, avx2 and avx512f on x86; ref and neon on ARM64), and the best one the CPU supports is picked at runtime.
+// The choice can be overridden with the ARGON2GUI_KERNEL environment variable (which takes precedence over argon2_select_kernel()).
+// All kernels produce exactly the same output, so switching between them is always safe (even while hashes are being computed).
+
+// Environment variable that forces a specific kernel (e.g. ARGON2GUI_KERNEL=ssse3).
+#define ARGON2_KERNEL_ENVIRONMENT_VARIABLE "ARGON2GUI_KERNEL"
+
+// Names of the kernels compiled into this binary that the CPU can run, from the slowest to the fastest.
+std::vector<const char*> argon2_available_kernels();
+
+// Name of the kernel currently in use.
+const char* argon2_active_kernel();
+
+// Whether the active kernel was forced through the environment variable.
+bool argon2_kernel_overridden_by_environment();
+
+// Switches to the kernel with the given name, or back to the fastest available one if name is NULL, empty or "auto".
+// Returns false (and keeps the current kernel) if there's no such kernel, the CPU doesn't support it, or the environment variable overrides it.
+bool argon2_select_kernel(const char* name);
+
+#endif // ARGON2KERNELS_H
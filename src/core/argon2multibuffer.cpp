@@ -0,0 +1,272 @@
+#include "argon2multibuffer.h"
+#include "argon2kernels.h"
+#include "argon2addresscache.h"
+#include "argon2blake2b.h"
+#include "arenapool.h"
+#include "phcstring.h"
+#include "argon2multibufferkernel.h"
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+typedef void (*MultiBufferFill)(const argon2_instance_t* const* instances, argon2_position_t position, const uint32_t* addresses);
+
+// Compiled with their own instruction set flags (see CMakeLists.txt).
+#ifdef ARGON2GUI_MULTIBUFFER_AVX2
+void argon2_multibuffer_fill_segment_avx2(const argon2_instance_t* const* instances, argon2_position_t position, const uint32_t* addresses);
+#endif
+#ifdef ARGON2GUI_MULTIBUFFER_AVX512F
+void argon2_multibuffer_fill_segment_avx512f(const argon2_instance_t* const* instances, argon2_position_t position, const uint32_t* addresses);
+#endif
+#ifdef ARGON2GUI_MULTIBUFFER_NEON
+void argon2_multibuffer_fill_segment_neon(const argon2_instance_t* const* instances, argon2_position_t position, const uint32_t* addresses);
+#endif
+
+static void fillSegmentsScalar(const argon2_instance_t* const* instances, argon2_position_t position, const uint32_t* addresses)
+{
+    fillSegments<ScalarLanes>(instances, position, addresses);
+}
+
+struct MultiBufferKernel
+{
+    // Name of the regular kernel (see argon2kernels.cpp) this one goes with: it's used whenever that one is active.
+    const char* kernel;
+    MultiBufferFill fill;
+    uint32_t width;
+};
+
+// The first entry is the fallback for every kernel without a multi-buffer version.
+static const MultiBufferKernel multiBufferKernels[] = {
+    { "ref", &fillSegmentsScalar, 1 },
+#ifdef ARGON2GUI_MULTIBUFFER_AVX2
+    { "avx2", &argon2_multibuffer_fill_segment_avx2, 4 },
+#endif
+#ifdef ARGON2GUI_MULTIBUFFER_AVX512F
+    { "avx512f", &argon2_multibuffer_fill_segment_avx512f, 8 },
+#endif
+#ifdef ARGON2GUI_MULTIBUFFER_NEON
+    { "neon", &argon2_multibuffer_fill_segment_neon, 2 },
+#endif
+};
+
+static const MultiBufferKernel& activeMultiBufferKernel()
+{
+    const char* active = argon2_active_kernel();
+
+    for (const MultiBufferKernel& kernel : multiBufferKernels)
+    {
+        if (strcmp(kernel.kernel, active) == 0)
+        {
+            return kernel;
+        }
+    }
+
+    return multiBufferKernels[0];
+}
+
+uint32_t argon2_multibuffer_width()
+{
+    return activeMultiBufferKernel().width;
+}
+
+// Validates the job's inputs, sets up its instance and computes its H0 into blockhash: what argon2_hash() and argon2_ctx() do before filling the memory,
+// minus the first blocks (see hashGroup).
+static int initializeJob(const argon2_multibuffer_job& job, uint8_t* out, const uint32_t t_cost, const uint32_t m_cost, const uint32_t parallelism, const size_t hashlen, argon2_type type, argon2_context& context, argon2_instance_t& instance, uint8_t* blockhash)
+{
+    if (job.pwdlen > ARGON2_MAX_PWD_LENGTH)
+    {
+        return ARGON2_PWD_TOO_LONG;
+    }
+
+    if (job.saltlen > ARGON2_MAX_SALT_LENGTH)
+    {
+        return ARGON2_SALT_TOO_LONG;
+    }
+
+    memset(&context, 0x00, sizeof(context));
+
+    context.out = out;
+    context.outlen = static_cast<uint32_t>(hashlen);
+    context.pwd = CONST_CAST(uint8_t*) job.pwd;
+    context.pwdlen = static_cast<uint32_t>(job.pwdlen);
+    context.salt = CONST_CAST(uint8_t*) job.salt;
+    context.saltlen = static_cast<uint32_t>(job.saltlen);
+    context.t_cost = t_cost;
+    context.m_cost = m_cost;
+    context.lanes = parallelism;
+    context.threads = parallelism;
+    context.allocate_cbk = &argon2_arena_allocate;
+    context.free_cbk = &argon2_arena_free;
+    context.flags = ARGON2_DEFAULT_FLAGS;
+    context.version = ARGON2_VERSION_NUMBER;
+
+    const int result = validate_inputs(&context);
+
+    if (result != ARGON2_OK)
+    {
+        return result;
+    }
+
+    uint32_t memory_blocks = context.m_cost;
+
+    if (memory_blocks < 2 * ARGON2_SYNC_POINTS * context.lanes)
+    {
+        memory_blocks = 2 * ARGON2_SYNC_POINTS * context.lanes;
+    }
+
+    const uint32_t segment_length = memory_blocks / (context.lanes * ARGON2_SYNC_POINTS);
+    memory_blocks = segment_length * (context.lanes * ARGON2_SYNC_POINTS);
+
+    instance.version = context.version;
+    instance.memory = NULL;
+    instance.passes = context.t_cost;
+    instance.memory_blocks = memory_blocks;
+    instance.segment_length = segment_length;
+    instance.lane_length = segment_length * ARGON2_SYNC_POINTS;
+    instance.lanes = context.lanes;
+    instance.threads = 1;
+    instance.type = type;
+    instance.print_internals = 0;
+    instance.context_ptr = &context;
+
+    const int allocated = allocate_memory(&context, reinterpret_cast<uint8_t**>(&instance.memory), instance.memory_blocks, sizeof(block));
+
+    if (allocated != ARGON2_OK)
+    {
+        return allocated;
+    }
+
+    initial_hash(blockhash, &context, instance.type);
+
+    return ARGON2_OK;
+}
+
+// Hashes up to kernel.width jobs in one pass over the memory.
+static uint32_t hashGroup(const MultiBufferKernel& kernel, const uint32_t t_cost, const uint32_t m_cost, const uint32_t parallelism, const size_t hashlen, argon2_type type, argon2_multibuffer_job* jobs, uint32_t count)
+{
+    std::vector<uint8_t> outputs(hashlen * count);
+    std::vector<argon2_context> contexts(count);
+    std::vector<argon2_instance_t> instances(count);
+    std::vector<uint8_t> blockhashes(ARGON2_PREHASH_DIGEST_LENGTH * count);
+
+    std::vector<const argon2_instance_t*> running;
+    std::vector<const uint8_t*> runningBlockhashes;
+    running.reserve(kernel.width);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint8_t* blockhash = blockhashes.data() + ARGON2_PREHASH_DIGEST_LENGTH * i;
+        jobs[i].result = initializeJob(jobs[i], outputs.data() + hashlen * i, t_cost, m_cost, parallelism, hashlen, type, contexts[i], instances[i], blockhash);
+
+        if (jobs[i].result == ARGON2_OK)
+        {
+            running.push_back(&instances[i]);
+            runningBlockhashes.push_back(blockhash);
+        }
+    }
+
+    if (!running.empty())
+    {
+        // The first two blocks of every lane of every instance are hashed together.
+        argon2_fill_first_blocks(runningBlockhashes.data(), running.data(), running.size());
+        clear_internal_memory(blockhashes.data(), blockhashes.size());
+
+        // A partial group is padded with the last instance: its duplicates compute (and store) exactly the same blocks.
+        running.resize(kernel.width, running.back());
+
+        // Shared with every other group (and thread) hashing with the same parameters.
+        const std::shared_ptr<const Argon2AddressTable> addresses = argon2_address_table(running.front());
+
+        for (uint32_t pass = 0; pass < t_cost; ++pass)
+        {
+            for (uint32_t slice = 0; slice < ARGON2_SYNC_POINTS; ++slice)
+            {
+                for (uint32_t lane = 0; lane < parallelism; ++lane)
+                {
+                    const argon2_position_t position { pass, lane, static_cast<uint8_t>(slice), 0 };
+                    kernel.fill(running.data(), position, addresses ? addresses->segment(position) : NULL);
+                }
+            }
+        }
+    }
+
+    // So are the tags.
+    std::vector<const argon2_context*> finishedContexts;
+    std::vector<argon2_instance_t*> finishedInstances;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (jobs[i].result == ARGON2_OK)
+        {
+            finishedContexts.push_back(&contexts[i]);
+            finishedInstances.push_back(&instances[i]);
+        }
+    }
+
+    argon2_arena_finalize_many(finishedContexts.data(), finishedInstances.data(), finishedContexts.size());
+
+    uint32_t failures = 0;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        argon2_multibuffer_job& job = jobs[i];
+
+        if (job.result == ARGON2_OK)
+        {
+            if (encodePhcString(type, contexts[i].version, contexts[i].m_cost, contexts[i].t_cost, contexts[i].lanes, contexts[i].salt, contexts[i].saltlen, contexts[i].out, contexts[i].outlen, job.encoded, job.encodedlen) == SIZE_MAX)
+            {
+                clear_internal_memory(job.encoded, job.encodedlen);
+                job.result = ARGON2_ENCODING_FAIL;
+            }
+        }
+
+        if (job.result != ARGON2_OK)
+        {
+            ++failures;
+        }
+    }
+
+    clear_internal_memory(outputs.data(), outputs.size());
+
+    return failures;
+}
+
+uint32_t argon2_multibuffer_hash_encoded(const uint32_t t_cost, const uint32_t m_cost, const uint32_t parallelism, const size_t hashlen, argon2_type type, argon2_multibuffer_job* jobs, uint32_t count)
+{
+    int result = ARGON2_OK;
+
+    if (hashlen > ARGON2_MAX_OUTLEN)
+    {
+        result = ARGON2_OUTPUT_TOO_LONG;
+    }
+    else if (hashlen < ARGON2_MIN_OUTLEN)
+    {
+        result = ARGON2_OUTPUT_TOO_SHORT;
+    }
+    else if (type != Argon2_d && type != Argon2_i && type != Argon2_id)
+    {
+        result = ARGON2_INCORRECT_TYPE;
+    }
+
+    if (result != ARGON2_OK)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            jobs[i].result = result;
+        }
+
+        return count;
+    }
+
+    const MultiBufferKernel& kernel = activeMultiBufferKernel();
+
+    uint32_t failures = 0;
+
+    for (uint32_t first = 0; first < count; first += kernel.width)
+    {
+        failures += hashGroup(kernel, t_cost, m_cost, parallelism, hashlen, type, jobs + first, std::min(kernel.width, count - first));
+    }
+
+    return failures;
+}
@@ -0,0 +1,37 @@
+#ifndef ARGON2MULTIBUFFER_H
+#define ARGON2MULTIBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <argon2.h>
+
+// One password to hash with argon2_multibuffer_hash_encoded().
+struct argon2_multibuffer_job
+{
+    const void* pwd;
+    size_t pwdlen;
+    const void* salt;
+    size_t saltlen;
+
+    // Receives the encoded hash string (NUL-terminated).
+    char* encoded;
+    size_t encodedlen;
+
+    // Set by argon2_multibuffer_hash_encoded() to ARGON2_OK or an Argon2 error code (which only concerns this job).
+    int result;
+};
+
+// How many hashes the active kernel (see argon2kernels.h) computes at once on a single core: 4 with AVX2, 8 with AVX-512F, 2 with NEON,
+// and 1 if it has no multi-buffer version (in which case argon2_multibuffer_hash_encoded() still works, just without any speedup).
+uint32_t argon2_multibuffer_width();
+
+// Hashes all the passed jobs with the same parameters on the calling thread, interleaving up to argon2_multibuffer_width()
+// independent Argon2 instances across the lanes of the SIMD registers. Each instance's lanes are filled one after the other,
+// so parallelism only affects the output (never the number of threads), which makes this a pure throughput mode:
+// it pays off for bulk hashing with small memory costs, where a single instance can't keep the vector units busy.
+// The encoded hashes are byte-identical to those of argon2id_hash_encoded, argon2i_hash_encoded and argon2d_hash_encoded.
+// Returns the number of jobs whose result is not ARGON2_OK.
+uint32_t argon2_multibuffer_hash_encoded(const uint32_t t_cost, const uint32_t m_cost, const uint32_t parallelism, const size_t hashlen, argon2_type type, argon2_multibuffer_job* jobs, uint32_t count);
+
+#endif // ARGON2MULTIBUFFER_H
@@ -0,0 +1,90 @@
+// AVX2 multi-buffer kernels: 4 Argon2 instances (see argon2multibufferkernel.h) or BLAKE2b messages (see argon2blake2bkernel.h) per 256-bit vector.
+
+#include "argon2multibufferkernel.h"
+#include "argon2blake2bkernel.h"
+
+#include <immintrin.h>
+
+namespace
+{
+    struct Avx2Lanes
+    {
+        typedef __m256i Vector;
+
+        static constexpr unsigned int count = 4;
+
+        static inline Vector load(const uint64_t* words)
+        {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words));
+        }
+
+        static inline void store(uint64_t* words, Vector x)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(words), x);
+        }
+
+        static inline void transpose(Vector* v)
+        {
+            const __m256i t0 = _mm256_unpacklo_epi64(v[0], v[1]);
+            const __m256i t1 = _mm256_unpackhi_epi64(v[0], v[1]);
+            const __m256i t2 = _mm256_unpacklo_epi64(v[2], v[3]);
+            const __m256i t3 = _mm256_unpackhi_epi64(v[2], v[3]);
+
+            v[0] = _mm256_permute2x128_si256(t0, t2, 0x20);
+            v[1] = _mm256_permute2x128_si256(t1, t3, 0x20);
+            v[2] = _mm256_permute2x128_si256(t0, t2, 0x31);
+            v[3] = _mm256_permute2x128_si256(t1, t3, 0x31);
+        }
+
+        static inline Vector broadcast(uint64_t word)
+        {
+            return _mm256_set1_epi64x(static_cast<long long>(word));
+        }
+
+        static inline Vector xor_(Vector x, Vector y)
+        {
+            return _mm256_xor_si256(x, y);
+        }
+
+        static inline Vector add(Vector x, Vector y)
+        {
+            return _mm256_add_epi64(x, y);
+        }
+
+        static inline Vector fBlaMka(Vector x, Vector y)
+        {
+            const __m256i product = _mm256_mul_epu32(x, y);
+            return _mm256_add_epi64(_mm256_add_epi64(x, y), _mm256_add_epi64(product, product));
+        }
+
+        static inline Vector rotr32(Vector x)
+        {
+            return _mm256_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1));
+        }
+
+        static inline Vector rotr24(Vector x)
+        {
+            return _mm256_shuffle_epi8(x, _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, 3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10));
+        }
+
+        static inline Vector rotr16(Vector x)
+        {
+            return _mm256_shuffle_epi8(x, _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, 2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9));
+        }
+
+        static inline Vector rotr63(Vector x)
+        {
+            return _mm256_xor_si256(_mm256_srli_epi64(x, 63), _mm256_add_epi64(x, x));
+        }
+    };
+}
+
+void argon2_multibuffer_fill_segment_avx2(const argon2_instance_t* const* instances, argon2_position_t position, const uint32_t* addresses)
+{
+    fillSegments<Avx2Lanes>(instances, position, addresses);
+}
+
+void argon2_multibuffer_blake2b_long_avx2(uint8_t* const* outputs, uint32_t outlen, const uint8_t* const* inputs, size_t inlen)
+{
+    blake2bLong<Avx2Lanes>(outputs, outlen, inputs, inlen);
+}
@@ -0,0 +1,113 @@
+// AVX-512 multi-buffer kernels: 8 Argon2 instances (see argon2multibufferkernel.h) or BLAKE2b messages (see argon2blake2bkernel.h) per 512-bit vector.
+
+#include "argon2multibufferkernel.h"
+#include "argon2blake2bkernel.h"
+
+#include <immintrin.h>
+
+namespace
+{
+    struct Avx512Lanes
+    {
+        typedef __m512i Vector;
+
+        static constexpr unsigned int count = 8;
+
+        static inline Vector load(const uint64_t* words)
+        {
+            return _mm512_loadu_si512(words);
+        }
+
+        static inline void store(uint64_t* words, Vector x)
+        {
+            _mm512_storeu_si512(words, x);
+        }
+
+        static inline void transpose(Vector* v)
+        {
+            // Pairs of words first: t0 = (v0[0], v1[0], v0[2], v1[2], ...), t1 = (v0[1], v1[1], v0[3], v1[3], ...), etc...
+            __m512i t[8];
+
+            for (unsigned int i = 0; i < 8; i += 2)
+            {
+                t[i] = _mm512_unpacklo_epi64(v[i], v[i + 1]);
+                t[i + 1] = _mm512_unpackhi_epi64(v[i], v[i + 1]);
+            }
+
+            // Then quads: q0 = (v0[0], v1[0], v2[0], v3[0], v0[4], v1[4], v2[4], v3[4]), q1 = the same with words 2 and 6, etc...
+            const __m512i low = _mm512_setr_epi64(0, 1, 8, 9, 4, 5, 12, 13);
+            const __m512i high = _mm512_setr_epi64(2, 3, 10, 11, 6, 7, 14, 15);
+
+            __m512i q[8];
+
+            for (unsigned int i = 0; i < 8; i += 4)
+            {
+                q[i] = _mm512_permutex2var_epi64(t[i], low, t[i + 2]);
+                q[i + 1] = _mm512_permutex2var_epi64(t[i], high, t[i + 2]);
+                q[i + 2] = _mm512_permutex2var_epi64(t[i + 1], low, t[i + 3]);
+                q[i + 3] = _mm512_permutex2var_epi64(t[i + 1], high, t[i + 3]);
+            }
+
+            // Finally, the lower halves of the quads of v0-v3 and v4-v7 (and then their upper halves) make up the transposed words.
+            v[0] = _mm512_shuffle_i64x2(q[0], q[4], 0x44);
+            v[1] = _mm512_shuffle_i64x2(q[2], q[6], 0x44);
+            v[2] = _mm512_shuffle_i64x2(q[1], q[5], 0x44);
+            v[3] = _mm512_shuffle_i64x2(q[3], q[7], 0x44);
+            v[4] = _mm512_shuffle_i64x2(q[0], q[4], 0xEE);
+            v[5] = _mm512_shuffle_i64x2(q[2], q[6], 0xEE);
+            v[6] = _mm512_shuffle_i64x2(q[1], q[5], 0xEE);
+            v[7] = _mm512_shuffle_i64x2(q[3], q[7], 0xEE);
+        }
+
+        static inline Vector broadcast(uint64_t word)
+        {
+            return _mm512_set1_epi64(static_cast<long long>(word));
+        }
+
+        static inline Vector xor_(Vector x, Vector y)
+        {
+            return _mm512_xor_si512(x, y);
+        }
+
+        static inline Vector add(Vector x, Vector y)
+        {
+            return _mm512_add_epi64(x, y);
+        }
+
+        static inline Vector fBlaMka(Vector x, Vector y)
+        {
+            const __m512i product = _mm512_mul_epu32(x, y);
+            return _mm512_add_epi64(_mm512_add_epi64(x, y), _mm512_add_epi64(product, product));
+        }
+
+        static inline Vector rotr32(Vector x)
+        {
+            return _mm512_ror_epi64(x, 32);
+        }
+
+        static inline Vector rotr24(Vector x)
+        {
+            return _mm512_ror_epi64(x, 24);
+        }
+
+        static inline Vector rotr16(Vector x)
+        {
+            return _mm512_ror_epi64(x, 16);
+        }
+
+        static inline Vector rotr63(Vector x)
+        {
+            return _mm512_ror_epi64(x, 63);
+        }
+    };
+}
+
+void argon2_multibuffer_fill_segment_avx512f(const argon2_instance_t* const* instances, argon2_position_t position, const uint32_t* addresses)
+{
+    fillSegments<Avx512Lanes>(instances, position, addresses);
+}
+
+void argon2_multibuffer_blake2b_long_avx512f(uint8_t* const* outputs, uint32_t outlen, const uint8_t* const* inputs, size_t inlen)
+{
+    blake2bLong<Avx512Lanes>(outputs, outlen, inputs, inlen);
+}
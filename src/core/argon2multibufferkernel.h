@@ -0,0 +1,315 @@
+#ifndef ARGON2MULTIBUFFERKERNEL_H
+#define ARGON2MULTIBUFFERKERNEL_H
+
+// Multi-buffer version of the library's fill_segment: it fills the same segment of several independent Argon2 instances
+// (with identical parameters) at once: word j of instance i's block sits in lane i of SIMD vector j.
+// Since every vector lane belongs to a different instance, the BLAKE2 rounds need no diagonalization shuffles at all:
+// the code below is ref.c's fill_block with uint64_t swapped for a vector type, and the only overhead is transposing
+// the blocks on their way into and out of the registers.
+//
+// This header is included by one translation unit per instruction set (each compiled with its own target flags),
+// which is why everything lives in an anonymous namespace: no inline function compiled with e.g. -mavx512f
+// may ever be merged by the linker with the baseline copy used on CPUs that lack the instructions.
+//
+// A lane set must provide: the Vector type, the number of lanes (count), load/store of count consecutive words,
+// an in-place count x count transpose, xor, fBlaMka and the four rotations used by BLAKE2b
+// (plus add and broadcast, for the multi-buffer BLAKE2b of argon2blake2bkernel.h).
+
+#include <core.h>
+
+namespace
+{
+    // One "vector" of a single 64-bit lane: used for the address blocks (which are identical in every instance)
+    // and as the portable fallback when the CPU has no multi-buffer kernel.
+    struct ScalarLanes
+    {
+        typedef uint64_t Vector;
+
+        static constexpr unsigned int count = 1;
+
+        static inline Vector load(const uint64_t* words)
+        {
+            return *words;
+        }
+
+        static inline void store(uint64_t* words, Vector x)
+        {
+            *words = x;
+        }
+
+        static inline void transpose(Vector*)
+        {
+        }
+
+        static inline Vector broadcast(uint64_t word)
+        {
+            return word;
+        }
+
+        static inline Vector xor_(Vector x, Vector y)
+        {
+            return x ^ y;
+        }
+
+        static inline Vector add(Vector x, Vector y)
+        {
+            return x + y;
+        }
+
+        static inline Vector fBlaMka(Vector x, Vector y)
+        {
+            const uint64_t m = UINT64_C(0xFFFFFFFF);
+            return x + y + 2 * ((x & m) * (y & m));
+        }
+
+        static inline Vector rotr32(Vector x)
+        {
+            return (x >> 32) | (x << 32);
+        }
+
+        static inline Vector rotr24(Vector x)
+        {
+            return (x >> 24) | (x << 40);
+        }
+
+        static inline Vector rotr16(Vector x)
+        {
+            return (x >> 16) | (x << 48);
+        }
+
+        static inline Vector rotr63(Vector x)
+        {
+            return (x >> 63) | (x << 1);
+        }
+    };
+
+    template <typename Lanes>
+    inline void blamkaG(typename Lanes::Vector& a, typename Lanes::Vector& b, typename Lanes::Vector& c, typename Lanes::Vector& d)
+    {
+        a = Lanes::fBlaMka(a, b);
+        d = Lanes::rotr32(Lanes::xor_(d, a));
+        c = Lanes::fBlaMka(c, d);
+        b = Lanes::rotr24(Lanes::xor_(b, c));
+        a = Lanes::fBlaMka(a, b);
+        d = Lanes::rotr16(Lanes::xor_(d, a));
+        c = Lanes::fBlaMka(c, d);
+        b = Lanes::rotr63(Lanes::xor_(b, c));
+    }
+
+    // BLAKE2_ROUND_NOMSG on the 16 words v[i[0]], ..., v[i[15]].
+    template <typename Lanes>
+    inline void blamkaRound(typename Lanes::Vector* v, const unsigned int (&i)[16])
+    {
+        blamkaG<Lanes>(v[i[0]], v[i[4]], v[i[8]], v[i[12]]);
+        blamkaG<Lanes>(v[i[1]], v[i[5]], v[i[9]], v[i[13]]);
+        blamkaG<Lanes>(v[i[2]], v[i[6]], v[i[10]], v[i[14]]);
+        blamkaG<Lanes>(v[i[3]], v[i[7]], v[i[11]], v[i[15]]);
+        blamkaG<Lanes>(v[i[0]], v[i[5]], v[i[10]], v[i[15]]);
+        blamkaG<Lanes>(v[i[1]], v[i[6]], v[i[11]], v[i[12]]);
+        blamkaG<Lanes>(v[i[2]], v[i[7]], v[i[8]], v[i[13]]);
+        blamkaG<Lanes>(v[i[3]], v[i[4]], v[i[9]], v[i[14]]);
+    }
+
+    // Loads words [k, k + count) of every lane's block, transposed: out[j] holds word k + j of all the lanes.
+    template <typename Lanes>
+    inline void loadWords(const block* const* blocks, unsigned int k, typename Lanes::Vector* out)
+    {
+        for (unsigned int lane = 0; lane < Lanes::count; ++lane)
+        {
+            out[lane] = Lanes::load(blocks[lane]->v + k);
+        }
+
+        Lanes::transpose(out);
+    }
+
+    // fill_block of ref.c, on Lanes::count blocks at once.
+    template <typename Lanes>
+    void fillBlocks(const block* const* prevBlocks, const block* const* refBlocks, block* const* nextBlocks, bool withXor)
+    {
+        typedef typename Lanes::Vector Vector;
+
+        Vector r[ARGON2_QWORDS_IN_BLOCK];
+        Vector tmp[ARGON2_QWORDS_IN_BLOCK];
+        Vector words[Lanes::count];
+        Vector refWords[Lanes::count];
+
+        for (unsigned int k = 0; k < ARGON2_QWORDS_IN_BLOCK; k += Lanes::count)
+        {
+            loadWords<Lanes>(prevBlocks, k, words);
+            loadWords<Lanes>(refBlocks, k, refWords);
+
+            for (unsigned int j = 0; j < Lanes::count; ++j)
+            {
+                r[k + j] = Lanes::xor_(words[j], refWords[j]);
+                tmp[k + j] = r[k + j];
+            }
+
+            if (withXor)
+            {
+                loadWords<Lanes>(const_cast<const block* const*>(nextBlocks), k, words);
+
+                for (unsigned int j = 0; j < Lanes::count; ++j)
+                {
+                    tmp[k + j] = Lanes::xor_(tmp[k + j], words[j]);
+                }
+            }
+        }
+
+        // Rows: (0, 1, ..., 15), then (16, 17, ..., 31), etc...
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            const unsigned int b = 16 * i;
+            blamkaRound<Lanes>(r, { b, b + 1, b + 2, b + 3, b + 4, b + 5, b + 6, b + 7, b + 8, b + 9, b + 10, b + 11, b + 12, b + 13, b + 14, b + 15 });
+        }
+
+        // Columns: (0, 1, 16, 17, ..., 112, 113), then (2, 3, 18, 19, ..., 114, 115), etc...
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            const unsigned int b = 2 * i;
+            blamkaRound<Lanes>(r, { b, b + 1, b + 16, b + 17, b + 32, b + 33, b + 48, b + 49, b + 64, b + 65, b + 80, b + 81, b + 96, b + 97, b + 112, b + 113 });
+        }
+
+        for (unsigned int k = 0; k < ARGON2_QWORDS_IN_BLOCK; k += Lanes::count)
+        {
+            for (unsigned int j = 0; j < Lanes::count; ++j)
+            {
+                words[j] = Lanes::xor_(tmp[k + j], r[k + j]);
+            }
+
+            Lanes::transpose(words);
+
+            for (unsigned int lane = 0; lane < Lanes::count; ++lane)
+            {
+                Lanes::store(nextBlocks[lane]->v + k, words[lane]);
+            }
+        }
+    }
+
+    inline void nextAddresses(block* addressBlock, block* inputBlock, const block* zeroBlock)
+    {
+        inputBlock->v[6]++;
+        fillBlocks<ScalarLanes>(&zeroBlock, const_cast<const block* const*>(&inputBlock), &addressBlock, false);
+        fillBlocks<ScalarLanes>(&zeroBlock, const_cast<const block* const*>(&addressBlock), &addressBlock, false);
+    }
+
+    // Whether the reference blocks of a segment are picked by the address blocks (Argon2i, and the first half pass of Argon2id)
+    // instead of by the previous block's contents.
+    inline bool dataIndependentAddressing(const argon2_instance_t* instance, const argon2_position_t& position)
+    {
+        return instance->type == Argon2_i || (instance->type == Argon2_id && position.pass == 0 && position.slice < ARGON2_SYNC_POINTS / 2);
+    }
+
+    // The address blocks only depend on the parameters and the position, never on the password or salt.
+    inline void initAddressInput(const argon2_instance_t* instance, const argon2_position_t& position, block* inputBlock, block* zeroBlock)
+    {
+        init_block_value(zeroBlock, 0);
+        init_block_value(inputBlock, 0);
+
+        inputBlock->v[0] = position.pass;
+        inputBlock->v[1] = position.lane;
+        inputBlock->v[2] = position.slice;
+        inputBlock->v[3] = instance->memory_blocks;
+        inputBlock->v[4] = instance->passes;
+        inputBlock->v[5] = instance->type;
+    }
+
+    // Offset (lane * lane_length + index) of the block referenced by the one at the passed position, given its pseudo-random value.
+    inline uint32_t referenceOffset(const argon2_instance_t* instance, const argon2_position_t& position, uint64_t pseudoRand)
+    {
+        uint32_t refLane = static_cast<uint32_t>((pseudoRand >> 32) % instance->lanes);
+
+        if (position.pass == 0 && position.slice == 0)
+        {
+            // Can't reference other lanes yet.
+            refLane = position.lane;
+        }
+
+        return refLane * instance->lane_length + index_alpha(instance, &position, pseudoRand & 0xFFFFFFFF, refLane == position.lane);
+    }
+
+    // fill_segment of ref.c, on Lanes::count instances at once. They must all share the same parameters (type, version,
+    // passes, lanes and memory size), but the same instance may be passed several times (which is how a partial group is padded):
+    // its lanes then compute identical blocks, and every store writes the exact same data.
+    // If the segment is data-independent, addresses may point to its precomputed reference offsets (see argon2addresscache.h),
+    // in which case no address block is generated at all.
+    template <typename Lanes>
+    void fillSegments(const argon2_instance_t* const* instances, argon2_position_t position, const uint32_t* addresses)
+    {
+        const argon2_instance_t* instance = instances[0];
+
+        block addressBlock;
+        block inputBlock;
+        block zeroBlock;
+
+        const bool dataIndependent = dataIndependentAddressing(instance, position);
+        const bool generateAddresses = dataIndependent && addresses == NULL;
+
+        if (generateAddresses)
+        {
+            initAddressInput(instance, position, &inputBlock, &zeroBlock);
+        }
+
+        uint32_t startingIndex = 0;
+
+        if (position.pass == 0 && position.slice == 0)
+        {
+            // The first two blocks of every lane were already generated by initialize().
+            startingIndex = 2;
+
+            if (generateAddresses)
+            {
+                nextAddresses(&addressBlock, &inputBlock, &zeroBlock);
+            }
+        }
+
+        uint32_t currOffset = position.lane * instance->lane_length + position.slice * instance->segment_length + startingIndex;
+        uint32_t prevOffset = currOffset % instance->lane_length == 0 ? currOffset + instance->lane_length - 1 : currOffset - 1;
+
+        const bool withXor = instance->version != ARGON2_VERSION_10 && position.pass != 0;
+
+        const block* prevBlocks[Lanes::count];
+        const block* refBlocks[Lanes::count];
+        block* currBlocks[Lanes::count];
+
+        for (uint32_t i = startingIndex; i < instance->segment_length; ++i, ++currOffset, ++prevOffset)
+        {
+            if (currOffset % instance->lane_length == 1)
+            {
+                prevOffset = currOffset - 1;
+            }
+
+            position.index = i;
+
+            uint32_t sharedRefOffset = 0;
+
+            if (generateAddresses)
+            {
+                if (i % ARGON2_ADDRESSES_IN_BLOCK == 0)
+                {
+                    nextAddresses(&addressBlock, &inputBlock, &zeroBlock);
+                }
+
+                sharedRefOffset = referenceOffset(instance, position, addressBlock.v[i % ARGON2_ADDRESSES_IN_BLOCK]);
+            }
+            else if (dataIndependent)
+            {
+                sharedRefOffset = addresses[i];
+            }
+
+            for (unsigned int lane = 0; lane < Lanes::count; ++lane)
+            {
+                const argon2_instance_t* current = instances[lane];
+
+                const uint32_t refOffset = dataIndependent ? sharedRefOffset : referenceOffset(current, position, current->memory[prevOffset].v[0]);
+
+                prevBlocks[lane] = current->memory + prevOffset;
+                refBlocks[lane] = current->memory + refOffset;
+                currBlocks[lane] = current->memory + currOffset;
+            }
+
+            fillBlocks<Lanes>(prevBlocks, refBlocks, currBlocks, withXor);
+        }
+    }
+}
+
+#endif // ARGON2MULTIBUFFERKERNEL_H
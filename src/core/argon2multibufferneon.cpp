@@ -0,0 +1,86 @@
+// NEON multi-buffer kernels: 2 Argon2 instances (see argon2multibufferkernel.h) or BLAKE2b messages (see argon2blake2bkernel.h) per 128-bit vector.
+
+#include "argon2multibufferkernel.h"
+#include "argon2blake2bkernel.h"
+
+#include <arm_neon.h>
+
+namespace
+{
+    struct NeonLanes
+    {
+        typedef uint64x2_t Vector;
+
+        static constexpr unsigned int count = 2;
+
+        static inline Vector load(const uint64_t* words)
+        {
+            return vld1q_u64(words);
+        }
+
+        static inline void store(uint64_t* words, Vector x)
+        {
+            vst1q_u64(words, x);
+        }
+
+        static inline void transpose(Vector* v)
+        {
+            const uint64x2_t t0 = vtrn1q_u64(v[0], v[1]);
+            const uint64x2_t t1 = vtrn2q_u64(v[0], v[1]);
+
+            v[0] = t0;
+            v[1] = t1;
+        }
+
+        static inline Vector broadcast(uint64_t word)
+        {
+            return vdupq_n_u64(word);
+        }
+
+        static inline Vector xor_(Vector x, Vector y)
+        {
+            return veorq_u64(x, y);
+        }
+
+        static inline Vector add(Vector x, Vector y)
+        {
+            return vaddq_u64(x, y);
+        }
+
+        static inline Vector fBlaMka(Vector x, Vector y)
+        {
+            const uint64x2_t product = vmull_u32(vmovn_u64(x), vmovn_u64(y));
+            return vaddq_u64(vaddq_u64(x, y), vaddq_u64(product, product));
+        }
+
+        static inline Vector rotr32(Vector x)
+        {
+            return vreinterpretq_u64_u32(vrev64q_u32(vreinterpretq_u32_u64(x)));
+        }
+
+        static inline Vector rotr24(Vector x)
+        {
+            return vsriq_n_u64(vshlq_n_u64(x, 40), x, 24);
+        }
+
+        static inline Vector rotr16(Vector x)
+        {
+            return vsriq_n_u64(vshlq_n_u64(x, 48), x, 16);
+        }
+
+        static inline Vector rotr63(Vector x)
+        {
+            return vsriq_n_u64(vshlq_n_u64(x, 1), x, 63);
+        }
+    };
+}
+
+void argon2_multibuffer_fill_segment_neon(const argon2_instance_t* const* instances, argon2_position_t position, const uint32_t* addresses)
+{
+    fillSegments<NeonLanes>(instances, position, addresses);
+}
+
+void argon2_multibuffer_blake2b_long_neon(uint8_t* const* outputs, uint32_t outlen, const uint8_t* const* inputs, size_t inlen)
+{
+    blake2bLong<NeonLanes>(outputs, outlen, inputs, inlen);
+}
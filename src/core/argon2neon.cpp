@@ -0,0 +1,270 @@
+// ARM NEON version of the library's fill_segment (the upstream sources only ship ref.c and the x86 opt.c).
+// The segment traversal is exactly the one of opt.c; only the block compression is vectorized,
+// keeping the previous block in 64 NEON registers' worth of state just like the SSE version does.
+
+#include <core.h>
+
+#include <cstring>
+
+#include <arm_neon.h>
+
+static inline uint64x2_t fBlaMka(uint64x2_t x, uint64x2_t y)
+{
+    // x + y + 2 * lo32(x) * lo32(y)
+    const uint64x2_t product = vmull_u32(vmovn_u64(x), vmovn_u64(y));
+    return vaddq_u64(vaddq_u64(x, y), vaddq_u64(product, product));
+}
+
+static inline uint64x2_t rotr32(uint64x2_t x)
+{
+    return vreinterpretq_u64_u32(vrev64q_u32(vreinterpretq_u32_u64(x)));
+}
+
+// Rotations by 24, 16 and 63 bits: shift left, then shift right and insert.
+#define ROTR64(x, n) vsriq_n_u64(vshlq_n_u64((x), 64 - (n)), (x), (n))
+
+#define G1(A0, B0, C0, D0, A1, B1, C1, D1) \
+    do                                     \
+    {                                      \
+        A0 = fBlaMka(A0, B0);              \
+        A1 = fBlaMka(A1, B1);              \
+        D0 = rotr32(veorq_u64(D0, A0));    \
+        D1 = rotr32(veorq_u64(D1, A1));    \
+        C0 = fBlaMka(C0, D0);              \
+        C1 = fBlaMka(C1, D1);              \
+        B0 = veorq_u64(B0, C0);            \
+        B1 = veorq_u64(B1, C1);            \
+        B0 = ROTR64(B0, 24);               \
+        B1 = ROTR64(B1, 24);               \
+    } while (0)
+
+#define G2(A0, B0, C0, D0, A1, B1, C1, D1) \
+    do                                     \
+    {                                      \
+        A0 = fBlaMka(A0, B0);              \
+        A1 = fBlaMka(A1, B1);              \
+        D0 = veorq_u64(D0, A0);            \
+        D1 = veorq_u64(D1, A1);            \
+        D0 = ROTR64(D0, 16);               \
+        D1 = ROTR64(D1, 16);               \
+        C0 = fBlaMka(C0, D0);              \
+        C1 = fBlaMka(C1, D1);              \
+        B0 = veorq_u64(B0, C0);            \
+        B1 = veorq_u64(B1, C1);            \
+        B0 = ROTR64(B0, 63);               \
+        B1 = ROTR64(B1, 63);               \
+    } while (0)
+
+// With the 16 words of a BLAKE2 state spread over A0 = (v0, v1), A1 = (v2, v3), B0 = (v4, v5) ... D1 = (v14, v15),
+// this moves the diagonals (v0, v5, v10, v15), (v1, v6, v11, v12), etc... into the columns, and back.
+#define DIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1) \
+    do                                              \
+    {                                               \
+        uint64x2_t t0 = vextq_u64(B0, B1, 1);       \
+        uint64x2_t t1 = vextq_u64(B1, B0, 1);       \
+        B0 = t0;                                    \
+        B1 = t1;                                    \
+        t0 = C0;                                    \
+        C0 = C1;                                    \
+        C1 = t0;                                    \
+        t0 = vextq_u64(D1, D0, 1);                  \
+        t1 = vextq_u64(D0, D1, 1);                  \
+        D0 = t0;                                    \
+        D1 = t1;                                    \
+    } while (0)
+
+#define UNDIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1) \
+    do                                                \
+    {                                                 \
+        uint64x2_t t0 = vextq_u64(B1, B0, 1);         \
+        uint64x2_t t1 = vextq_u64(B0, B1, 1);         \
+        B0 = t0;                                      \
+        B1 = t1;                                      \
+        t0 = C0;                                      \
+        C0 = C1;                                      \
+        C1 = t0;                                      \
+        t0 = vextq_u64(D0, D1, 1);                    \
+        t1 = vextq_u64(D1, D0, 1);                    \
+        D0 = t0;                                      \
+        D1 = t1;                                      \
+    } while (0)
+
+#define BLAKE2_ROUND(A0, A1, B0, B1, C0, C1, D0, D1)    \
+    do                                                  \
+    {                                                   \
+        G1(A0, B0, C0, D0, A1, B1, C1, D1);             \
+        G2(A0, B0, C0, D0, A1, B1, C1, D1);             \
+        DIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1);    \
+        G1(A0, B0, C0, D0, A1, B1, C1, D1);             \
+        G2(A0, B0, C0, D0, A1, B1, C1, D1);             \
+        UNDIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1);  \
+    } while (0)
+
+static void fill_block(uint64x2_t* state, const block* ref_block, block* next_block, int with_xor)
+{
+    uint64x2_t block_XY[ARGON2_OWORDS_IN_BLOCK];
+    unsigned int i;
+
+    if (with_xor)
+    {
+        for (i = 0; i < ARGON2_OWORDS_IN_BLOCK; i++)
+        {
+            state[i] = veorq_u64(state[i], vld1q_u64(ref_block->v + 2 * i));
+            block_XY[i] = veorq_u64(state[i], vld1q_u64(next_block->v + 2 * i));
+        }
+    }
+    else
+    {
+        for (i = 0; i < ARGON2_OWORDS_IN_BLOCK; i++)
+        {
+            block_XY[i] = state[i] = veorq_u64(state[i], vld1q_u64(ref_block->v + 2 * i));
+        }
+    }
+
+    for (i = 0; i < 8; ++i)
+    {
+        BLAKE2_ROUND(state[8 * i + 0], state[8 * i + 1], state[8 * i + 2], state[8 * i + 3], state[8 * i + 4], state[8 * i + 5], state[8 * i + 6], state[8 * i + 7]);
+    }
+
+    for (i = 0; i < 8; ++i)
+    {
+        BLAKE2_ROUND(state[8 * 0 + i], state[8 * 1 + i], state[8 * 2 + i], state[8 * 3 + i], state[8 * 4 + i], state[8 * 5 + i], state[8 * 6 + i], state[8 * 7 + i]);
+    }
+
+    for (i = 0; i < ARGON2_OWORDS_IN_BLOCK; i++)
+    {
+        state[i] = veorq_u64(state[i], block_XY[i]);
+        vst1q_u64(next_block->v + 2 * i, state[i]);
+    }
+}
+
+static void next_addresses(block* address_block, block* input_block)
+{
+    // Temporary zero-initialized blocks.
+    uint64x2_t zero_block[ARGON2_OWORDS_IN_BLOCK];
+    uint64x2_t zero2_block[ARGON2_OWORDS_IN_BLOCK];
+
+    memset(zero_block, 0, sizeof(zero_block));
+    memset(zero2_block, 0, sizeof(zero2_block));
+
+    // Increasing index counter.
+    input_block->v[6]++;
+
+    // First iteration of G.
+    fill_block(zero_block, input_block, address_block, 0);
+
+    // Second iteration of G.
+    fill_block(zero2_block, address_block, address_block, 0);
+}
+
+void argon2_fill_segment_neon(const argon2_instance_t* instance, argon2_position_t position)
+{
+    block* ref_block = NULL;
+    block* curr_block = NULL;
+    block address_block, input_block;
+    uint64_t pseudo_rand, ref_index, ref_lane;
+    uint32_t prev_offset, curr_offset;
+    uint32_t starting_index, i;
+    uint64x2_t state[ARGON2_OWORDS_IN_BLOCK];
+    int data_independent_addressing;
+
+    if (instance == NULL)
+    {
+        return;
+    }
+
+    data_independent_addressing = (instance->type == Argon2_i) || (instance->type == Argon2_id && (position.pass == 0) && (position.slice < ARGON2_SYNC_POINTS / 2));
+
+    if (data_independent_addressing)
+    {
+        init_block_value(&input_block, 0);
+
+        input_block.v[0] = position.pass;
+        input_block.v[1] = position.lane;
+        input_block.v[2] = position.slice;
+        input_block.v[3] = instance->memory_blocks;
+        input_block.v[4] = instance->passes;
+        input_block.v[5] = instance->type;
+    }
+
+    starting_index = 0;
+
+    if ((0 == position.pass) && (0 == position.slice))
+    {
+        starting_index = 2; // We have already generated the first two blocks.
+
+        // Don't forget to generate the first block of addresses:
+        if (data_independent_addressing)
+        {
+            next_addresses(&address_block, &input_block);
+        }
+    }
+
+    // Offset of the current block.
+    curr_offset = position.lane * instance->lane_length + position.slice * instance->segment_length + starting_index;
+
+    if (0 == curr_offset % instance->lane_length)
+    {
+        // Last block in this lane.
+        prev_offset = curr_offset + instance->lane_length - 1;
+    }
+    else
+    {
+        // Previous block.
+        prev_offset = curr_offset - 1;
+    }
+
+    memcpy(state, ((instance->memory + prev_offset)->v), ARGON2_BLOCK_SIZE);
+
+    for (i = starting_index; i < instance->segment_length; ++i, ++curr_offset, ++prev_offset)
+    {
+        // 1.1 Rotating prev_offset if needed.
+        if (curr_offset % instance->lane_length == 1)
+        {
+            prev_offset = curr_offset - 1;
+        }
+
+        // 1.2 Computing the index of the reference block.
+        // 1.2.1 Taking pseudo-random value from the previous block.
+        if (data_independent_addressing)
+        {
+            if (i % ARGON2_ADDRESSES_IN_BLOCK == 0)
+            {
+                next_addresses(&address_block, &input_block);
+            }
+
+            pseudo_rand = address_block.v[i % ARGON2_ADDRESSES_IN_BLOCK];
+        }
+        else
+        {
+            pseudo_rand = instance->memory[prev_offset].v[0];
+        }
+
+        // 1.2.2 Computing the lane of the reference block.
+        ref_lane = ((pseudo_rand >> 32)) % instance->lanes;
+
+        if ((position.pass == 0) && (position.slice == 0))
+        {
+            // Can not reference other lanes yet.
+            ref_lane = position.lane;
+        }
+
+        // 1.2.3 Computing the number of possible reference block within the lane.
+        position.index = i;
+        ref_index = index_alpha(instance, &position, pseudo_rand & 0xFFFFFFFF, ref_lane == position.lane);
+
+        // 2 Creating a new block.
+        ref_block = instance->memory + instance->lane_length * ref_lane + ref_index;
+        curr_block = instance->memory + curr_offset;
+
+        if (ARGON2_VERSION_10 == instance->version)
+        {
+            // Version 1.2.1 and earlier: overwrite, not XOR.
+            fill_block(state, ref_block, curr_block, 0);
+        }
+        else
+        {
+            fill_block(state, ref_block, curr_block, position.pass != 0);
+        }
+    }
+}
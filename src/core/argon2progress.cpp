@@ -0,0 +1,265 @@
+#include "argon2progress.h"
+#include "arenapool.h"
+#include "lanepool.h"
+#include "phcstring.h"
+#include "argon2trace.h"
+#include "argon2blake2b.h"
+#include "matrixfile.h"
+
+#include <core.h>
+#include <blake2/blake2.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <system_error>
+
+// Key of the digest of H0 that tells a matrix file's checkpoints apart (H0 itself never gets stored).
+static const char matrixFileKey[] = "argon2gui matrix file checkpoint";
+
+// blockhash is H0 (and room for the block and lane indices), for the first blocks of a hash that starts at the first pass.
+static int fillMemoryBlocks(argon2_instance_t* instance, const uint8_t* blockhash, argon2_progress_fptr progress_cbk, void* user_data, Argon2Trace* trace, uint32_t firstPass, Argon2MatrixFile* matrixFile)
+{
+    uint32_t pass = firstPass;
+    uint32_t slice = 0;
+
+    // Fills the current slice of every lane the passed thread is responsible for.
+    // The segments of a slice are independent from each other, so no synchronization is needed besides the barrier at the end of the slice.
+    const std::function<void(uint32_t thread)> fillSlice = [instance, blockhash, &pass, &slice, trace, firstPass](uint32_t thread) {
+        if (trace != nullptr && thread != 0 && pass == firstPass && slice == 0)
+        {
+            trace->nameThread("Lane worker");
+        }
+
+        // Each thread fills the first blocks of its own lanes, so that their memory is first touched on its node (see LanePoolOptions::numaAware).
+        // (A resumed hash has them, and more, in the checkpoint already.)
+        if (pass == 0 && slice == 0)
+        {
+            const Argon2TraceSpan span(trace, "first blocks");
+            argon2_fill_first_blocks_of_lanes(blockhash, instance, thread, instance->threads);
+        }
+
+        for (uint32_t lane = thread; lane < instance->lanes; lane += instance->threads)
+        {
+            const Argon2TraceSpan span(trace, "segment", static_cast<int>(pass), static_cast<int>(slice), static_cast<int>(lane));
+            fill_segment(instance, argon2_position_t { pass, lane, static_cast<uint8_t>(slice), 0 });
+        }
+    };
+
+    try
+    {
+        // The same workers fill every slice of every pass.
+        LaneTeam team(instance->threads);
+
+        for (; pass < instance->passes; ++pass)
+        {
+            for (slice = 0; slice < ARGON2_SYNC_POINTS; ++slice)
+            {
+                {
+                    const Argon2TraceSpan span(trace, "slice", static_cast<int>(pass), static_cast<int>(slice));
+
+                    if (instance->threads == 1)
+                    {
+                        fillSlice(0);
+                    }
+                    else
+                    {
+                        team.run(fillSlice);
+                    }
+                }
+
+                if (progress_cbk != NULL && progress_cbk(pass, slice, instance->passes, user_data) != 0)
+                {
+                    return ARGON2_ABORTED;
+                }
+            }
+
+            // (No checkpoint after the last pass: the hash is as good as done.)
+            if (matrixFile != nullptr && pass + 1 < instance->passes && matrixFile->checkpointDue())
+            {
+                const Argon2TraceSpan span(trace, "checkpoint", static_cast<int>(pass));
+                matrixFile->checkpoint(pass + 1);
+            }
+        }
+    }
+    catch (const std::system_error&)
+    {
+        return ARGON2_THREAD_FAIL;
+    }
+
+    return ARGON2_OK;
+}
+
+int argon2_progress_ctx(argon2_context* context, argon2_type type, argon2_progress_fptr progress_cbk, void* user_data, Argon2MatrixFile* matrixFile)
+{
+    // What follows mirrors argon2_ctx() (and initialize(), so that its phases can be traced separately), except for the memory filling loop
+    // (which runs on the persistent lane pool instead of spawning threads for every slice) and the deferred wiping of pooled matrices.
+
+    // Looked up once per hash: without a trace, every span below is a null check.
+    Argon2Trace* const trace = Argon2Trace::current().get();
+
+    int result = validate_inputs(context);
+
+    if (result != ARGON2_OK)
+    {
+        return result;
+    }
+
+    if (type != Argon2_d && type != Argon2_i && type != Argon2_id)
+    {
+        return ARGON2_INCORRECT_TYPE;
+    }
+
+    uint32_t memory_blocks = context->m_cost;
+
+    if (memory_blocks < 2 * ARGON2_SYNC_POINTS * context->lanes)
+    {
+        memory_blocks = 2 * ARGON2_SYNC_POINTS * context->lanes;
+    }
+
+    const uint32_t segment_length = memory_blocks / (context->lanes * ARGON2_SYNC_POINTS);
+    memory_blocks = segment_length * (context->lanes * ARGON2_SYNC_POINTS);
+
+    argon2_instance_t instance;
+    instance.version = context->version;
+    instance.memory = NULL;
+    instance.passes = context->t_cost;
+    instance.memory_blocks = memory_blocks;
+    instance.segment_length = segment_length;
+    instance.lane_length = segment_length * ARGON2_SYNC_POINTS;
+    instance.lanes = context->lanes;
+    instance.threads = context->threads > context->lanes ? context->lanes : context->threads;
+    instance.type = type;
+    instance.print_internals = 0;
+
+    instance.context_ptr = context;
+
+    // (Computed before the matrix is allocated, so that a matrix file can tell whether its checkpoint belongs to this hash.)
+    uint8_t blockhash[ARGON2_PREHASH_SEED_LENGTH];
+
+    {
+        const Argon2TraceSpan span(trace, "H0");
+        initial_hash(blockhash, context, instance.type);
+        clear_internal_memory(blockhash + ARGON2_PREHASH_DIGEST_LENGTH, ARGON2_PREHASH_SEED_LENGTH - ARGON2_PREHASH_DIGEST_LENGTH);
+    }
+
+    uint32_t firstPass = 0;
+
+    {
+        const Argon2TraceSpan span(trace, "allocate");
+
+        if (matrixFile != nullptr)
+        {
+            uint8_t identity[64];
+            blake2b(identity, sizeof(identity), blockhash, ARGON2_PREHASH_DIGEST_LENGTH, matrixFileKey, sizeof(matrixFileKey) - 1);
+
+            result = matrixFile->open(static_cast<size_t>(instance.memory_blocks) * sizeof(block), identity, context->salt, context->saltlen, firstPass);
+            instance.memory = reinterpret_cast<block*>(matrixFile->data());
+        }
+        else
+        {
+            result = allocate_memory(context, reinterpret_cast<uint8_t**>(&instance.memory), instance.memory_blocks, sizeof(block));
+        }
+    }
+
+    if (result != ARGON2_OK)
+    {
+        clear_internal_memory(blockhash, ARGON2_PREHASH_SEED_LENGTH);
+        return result;
+    }
+
+    result = fillMemoryBlocks(&instance, blockhash, progress_cbk, user_data, trace, firstPass, matrixFile);
+
+    clear_internal_memory(blockhash, ARGON2_PREHASH_SEED_LENGTH);
+
+    if (result != ARGON2_OK)
+    {
+        if (matrixFile == nullptr)
+        {
+            free_memory(context, reinterpret_cast<uint8_t*>(instance.memory), instance.memory_blocks, sizeof(block));
+        }
+
+        return result;
+    }
+
+    // (Pooled matrices are wiped by the arena pool, small ones later on its wiper thread, and matrix files when their owner removes them: that's traced there.)
+    const Argon2TraceSpan span(trace, "finalize");
+
+    if (matrixFile != nullptr)
+    {
+        const argon2_context* contexts[] = { context };
+        const argon2_instance_t* instances[] = { &instance };
+        argon2_finalize_tags(contexts, instances, 1);
+    }
+    else
+    {
+        argon2_arena_finalize(context, &instance);
+    }
+
+    return ARGON2_OK;
+}
+
+int argon2_progress_hash_encoded(const uint32_t t_cost, const uint32_t m_cost, const uint32_t parallelism, const void* pwd, const size_t pwdlen, const void* salt, const size_t saltlen, const size_t hashlen, char* encoded, const size_t encodedlen, argon2_type type, argon2_progress_fptr progress_cbk, void* user_data)
+{
+    // What follows mirrors argon2_hash().
+
+    if (pwdlen > ARGON2_MAX_PWD_LENGTH)
+    {
+        return ARGON2_PWD_TOO_LONG;
+    }
+
+    if (saltlen > ARGON2_MAX_SALT_LENGTH)
+    {
+        return ARGON2_SALT_TOO_LONG;
+    }
+
+    if (hashlen > ARGON2_MAX_OUTLEN)
+    {
+        return ARGON2_OUTPUT_TOO_LONG;
+    }
+
+    if (hashlen < ARGON2_MIN_OUTLEN)
+    {
+        return ARGON2_OUTPUT_TOO_SHORT;
+    }
+
+    uint8_t* out = static_cast<uint8_t*>(malloc(hashlen));
+
+    if (out == NULL)
+    {
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+
+    argon2_context context;
+    context.out = out;
+    context.outlen = static_cast<uint32_t>(hashlen);
+    context.pwd = CONST_CAST(uint8_t*) pwd;
+    context.pwdlen = static_cast<uint32_t>(pwdlen);
+    context.salt = CONST_CAST(uint8_t*) salt;
+    context.saltlen = static_cast<uint32_t>(saltlen);
+    context.secret = NULL;
+    context.secretlen = 0;
+    context.ad = NULL;
+    context.adlen = 0;
+    context.t_cost = t_cost;
+    context.m_cost = m_cost;
+    context.lanes = parallelism;
+    context.threads = parallelism;
+    context.allocate_cbk = NULL;
+    context.free_cbk = NULL;
+    context.flags = ARGON2_DEFAULT_FLAGS;
+    context.version = ARGON2_VERSION_NUMBER;
+
+    int result = argon2_progress_ctx(&context, type, progress_cbk, user_data);
+
+    if (result == ARGON2_OK && encoded != NULL && encodedlen > 0 && encodePhcString(type, context.version, context.m_cost, context.t_cost, context.lanes, context.salt, context.saltlen, context.out, context.outlen, encoded, encodedlen) == SIZE_MAX)
+    {
+        clear_internal_memory(encoded, encodedlen);
+        result = ARGON2_ENCODING_FAIL;
+    }
+
+    clear_internal_memory(out, hashlen);
+    free(out);
+
+    return result;
+}
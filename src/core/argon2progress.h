@@ -0,0 +1,29 @@
+#ifndef ARGON2PROGRESS_H
+#define ARGON2PROGRESS_H
+
+#include <argon2.h>
+
+// Returned by the progress-aware functions below when the progress callback asked for the hash to be aborted.
+// Deliberately kept well away from the library's own argon2_error_codes (which currently end at -35).
+#define ARGON2_ABORTED -128
+
+// Returned by argon2_progress_ctx when its matrix file holds a checkpoint of another hash (see matrixfile.h).
+#define ARGON2_CHECKPOINT_MISMATCH -129
+
+class Argon2MatrixFile;
+
+// Invoked after every completed slice (ARGON2_SYNC_POINTS times per pass).
+// Return 0 to keep going, or anything else to abort the hash computation early.
+typedef int (*argon2_progress_fptr)(uint32_t pass, uint32_t slice, uint32_t passes, void* user_data);
+
+// Same as argon2_ctx, but reports progress after every slice of every pass and can be aborted via the progress callback.
+// Passing NULL as progress callback gives the same result as calling argon2_ctx, except that the lanes are filled by the persistent
+// worker threads of the lane pool (see lanepool.h) and that matrices from the arena pool (see arenapool.h) are wiped in the background.
+// With a matrix file, the matrix lives in that file instead of the context's allocator: the hash picks up from the file's checkpoint if it has one,
+// checkpoints at pass boundaries, and leaves the file to the caller once done (see Argon2MatrixFile::remove).
+int argon2_progress_ctx(argon2_context* context, argon2_type type, argon2_progress_fptr progress_cbk, void* user_data, Argon2MatrixFile* matrixFile = nullptr);
+
+// Same as argon2id_hash_encoded, argon2i_hash_encoded and argon2d_hash_encoded (depending on the passed type), but progress-aware.
+int argon2_progress_hash_encoded(const uint32_t t_cost, const uint32_t m_cost, const uint32_t parallelism, const void* pwd, const size_t pwdlen, const void* salt, const size_t saltlen, const size_t hashlen, char* encoded, const size_t encodedlen, argon2_type type, argon2_progress_fptr progress_cbk, void* user_data);
+
+#endif // ARGON2PROGRESS_H
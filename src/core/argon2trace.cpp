@@ -0,0 +1,144 @@
+#include "argon2trace.h"
+
+#include <cstdio>
+
+static thread_local std::shared_ptr<Argon2Trace> currentTrace;
+
+// Escapes what may appear in thread names (event names are string literals).
+static std::string escape(const std::string& text)
+{
+    std::string escaped;
+
+    for (const char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped.push_back('\\');
+        }
+
+        if (static_cast<unsigned char>(c) >= 0x20)
+        {
+            escaped.push_back(c);
+        }
+    }
+
+    return escaped;
+}
+
+Argon2Trace::Argon2Trace()
+    : origin(Clock::now())
+{
+}
+
+const std::shared_ptr<Argon2Trace>& Argon2Trace::current()
+{
+    return currentTrace;
+}
+
+unsigned int Argon2Trace::threadIndex()
+{
+    const std::thread::id id = std::this_thread::get_id();
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        if (threads[i].id == id)
+        {
+            return static_cast<unsigned int>(i);
+        }
+    }
+
+    threads.push_back(Thread { id, std::string() });
+    return static_cast<unsigned int>(threads.size() - 1);
+}
+
+void Argon2Trace::nameThread(const char* name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Thread& thread = threads[threadIndex()];
+
+    if (thread.name.empty())
+    {
+        thread.name = name;
+    }
+}
+
+void Argon2Trace::record(const char* name, Clock::time_point start, Clock::time_point end, int pass, int slice, int lane, const std::string& arguments)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back(Event { name, threadIndex(), start, end, pass, slice, lane, arguments });
+}
+
+std::string Argon2Trace::json() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    char buffer[512];
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        const std::string name = threads[i].name.empty() ? "Thread " + std::to_string(i + 1) : threads[i].name;
+
+        // Keeps the threads in the order they first showed up in.
+        snprintf(buffer, sizeof(buffer), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s\"}},\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"sort_index\":%zu}},\n", i + 1, escape(name).c_str(), i + 1, i);
+        json += buffer;
+    }
+
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        const Event& event = events[i];
+
+        // Microseconds since the trace was created.
+        const double start = std::chrono::duration<double, std::micro>(event.start - origin).count();
+        const double duration = std::chrono::duration<double, std::micro>(event.end - event.start).count();
+
+        std::string arguments;
+
+        if (event.pass >= 0)
+        {
+            arguments += "\"pass\":" + std::to_string(event.pass);
+        }
+
+        if (event.slice >= 0)
+        {
+            arguments += (arguments.empty() ? "" : ",") + std::string("\"slice\":") + std::to_string(event.slice);
+        }
+
+        if (event.lane >= 0)
+        {
+            arguments += (arguments.empty() ? "" : ",") + std::string("\"lane\":") + std::to_string(event.lane);
+        }
+
+        if (!event.arguments.empty())
+        {
+            arguments += (arguments.empty() ? "" : ",") + event.arguments;
+        }
+
+        snprintf(buffer, sizeof(buffer), "{\"name\":\"%s\",\"cat\":\"argon2\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{", event.name, event.thread + 1, start, duration);
+
+        json += buffer;
+        json += arguments;
+        json += i + 1 < events.size() ? "}},\n" : "}}\n";
+    }
+
+    // (The metadata events above all end with a comma.)
+    if (events.empty() && !threads.empty())
+    {
+        json.erase(json.size() - 2, 1);
+    }
+
+    json += "]}\n";
+    return json;
+}
+
+Argon2TraceAttachment::Argon2TraceAttachment(std::shared_ptr<Argon2Trace> trace)
+    : previous(std::move(currentTrace))
+{
+    currentTrace = std::move(trace);
+}
+
+Argon2TraceAttachment::~Argon2TraceAttachment()
+{
+    currentTrace = std::move(previous);
+}
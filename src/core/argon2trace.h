@@ -0,0 +1,133 @@
+#ifndef ARGON2TRACE_H
+#define ARGON2TRACE_H
+
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+// Timeline of the phases of the hashes that record into it (see Argon2HashRequest::trace): allocation, initial hashing (H0),
+// first blocks, every lane's segment of every slice of every pass (on the thread that filled it), the slices as a whole (on the hash's own thread,
+// so that the time its lane workers spent waiting at the slice's barrier shows), finalization and the wiping of the matrix.
+// Exported as Chrome trace-event JSON, which Perfetto (ui.perfetto.dev) and chrome://tracing open. All methods are thread-safe.
+class Argon2Trace
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    Argon2Trace();
+
+    Argon2Trace(const Argon2Trace&) = delete;
+    Argon2Trace& operator=(const Argon2Trace&) = delete;
+
+    // The trace the hashes computed on the calling thread record into: none (the default) unless an Argon2TraceAttachment says otherwise.
+    static const std::shared_ptr<Argon2Trace>& current();
+
+    // Shown as the calling thread's name (the first name given to a thread sticks).
+    void nameThread(const char* name);
+
+    // A complete event on the calling thread. The pass, slice and lane are added to its arguments unless they're negative;
+    // arguments, if not empty, are more JSON object members (e.g. "\"t\": 3").
+    void record(const char* name, Clock::time_point start, Clock::time_point end, int pass = -1, int slice = -1, int lane = -1, const std::string& arguments = std::string());
+
+    std::string json() const;
+
+private:
+    struct Event
+    {
+        const char* name;
+        unsigned int thread;
+        Clock::time_point start;
+        Clock::time_point end;
+        int pass;
+        int slice;
+        int lane;
+        std::string arguments;
+    };
+
+    struct Thread
+    {
+        std::thread::id id;
+        std::string name;
+    };
+
+    const Clock::time_point origin;
+
+    mutable std::mutex mutex;
+    std::vector<Event> events;
+    std::vector<Thread> threads;
+
+    // Index of the calling thread in threads (added if it isn't in there yet). Must be called with the mutex held.
+    unsigned int threadIndex();
+};
+
+// Makes a trace the calling thread's current one (see Argon2Trace::current) for its own lifetime.
+class Argon2TraceAttachment
+{
+public:
+    explicit Argon2TraceAttachment(std::shared_ptr<Argon2Trace> trace);
+    ~Argon2TraceAttachment();
+
+    Argon2TraceAttachment(const Argon2TraceAttachment&) = delete;
+    Argon2TraceAttachment& operator=(const Argon2TraceAttachment&) = delete;
+
+private:
+    std::shared_ptr<Argon2Trace> previous;
+};
+
+// Records a complete event from its construction to its destruction. Without a trace, that's a null check and nothing else.
+class Argon2TraceSpan
+{
+public:
+    Argon2TraceSpan(Argon2Trace* trace, const char* name, int pass = -1, int slice = -1, int lane = -1)
+        : trace(trace)
+        , name(name)
+        , pass(pass)
+        , slice(slice)
+        , lane(lane)
+    {
+        if (trace != nullptr)
+        {
+            start = Argon2Trace::Clock::now();
+        }
+    }
+
+    ~Argon2TraceSpan()
+    {
+        end();
+    }
+
+    Argon2TraceSpan(const Argon2TraceSpan&) = delete;
+    Argon2TraceSpan& operator=(const Argon2TraceSpan&) = delete;
+
+    // More arguments for the event (only worth building if there's a trace).
+    void setArguments(std::string value)
+    {
+        arguments = std::move(value);
+    }
+
+    // Records the event right away (instead of on destruction).
+    void end()
+    {
+        if (trace != nullptr)
+        {
+            trace->record(name, start, Argon2Trace::Clock::now(), pass, slice, lane, arguments);
+            trace = nullptr;
+        }
+    }
+
+private:
+    Argon2Trace* trace;
+    const char* name;
+    int pass;
+    int slice;
+    int lane;
+    std::string arguments;
+    Argon2Trace::Clock::time_point start;
+};
+
+#endif // ARGON2TRACE_H
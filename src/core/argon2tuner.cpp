@@ -0,0 +1,194 @@
+#include "argon2tuner.h"
+#include "argon2progress.h"
+
+#include <chrono>
+#include <algorithm>
+
+static const size_t mebibyte = 1024 * 1024;
+
+// Give up on narrowing down one parameter after this many measurements (the best one found so far is kept).
+static const unsigned int maxMeasurementsPerSearch = 12;
+
+Argon2Tuner::Argon2Tuner(Argon2Engine& engine, const Argon2TunerOptions& options)
+    : engine(engine)
+    , options(options)
+{
+    this->options.concurrency = std::max(options.concurrency, 1u);
+    this->options.rounds = std::max(options.rounds, 1u);
+}
+
+void Argon2Tuner::cancel()
+{
+    cancelled.store(true, std::memory_order_relaxed);
+}
+
+bool Argon2Tuner::sample(const Argon2Parameters& parameters, Argon2TuningResult& result, const Argon2TunerProgressCallback& progress, double& seconds)
+{
+    Argon2HashRequest request;
+    request.parameters = parameters;
+    request.password = "correct horse battery staple";
+
+    std::vector<double> rounds;
+    const bool warmUp = parameters.memoryCostKiB != warmedUpMemoryCostKiB;
+
+    for (unsigned int round = warmUp ? 0 : 1; round <= options.rounds; ++round)
+    {
+        std::vector<std::future<Argon2HashResult>> hashes;
+        const auto start = std::chrono::steady_clock::now();
+
+        for (unsigned int i = 0; i < options.concurrency; ++i)
+        {
+            hashes.push_back(engine.hash(request, [this](uint32_t, uint32_t) { return !cancelled.load(std::memory_order_relaxed); }));
+        }
+
+        for (std::future<Argon2HashResult>& hash : hashes)
+        {
+            const int error = hash.get().error;
+
+            if (error != ARGON2_OK)
+            {
+                result.error = error;
+            }
+        }
+
+        if (result.error != ARGON2_OK)
+        {
+            return false;
+        }
+
+        // Round 0 is the warm-up.
+        if (round != 0)
+        {
+            rounds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+
+    warmedUpMemoryCostKiB = parameters.memoryCostKiB;
+
+    std::sort(rounds.begin(), rounds.end());
+    seconds = rounds[rounds.size() / 2];
+
+    result.samples.push_back(Argon2CalibrationSample { parameters, seconds });
+
+    if (progress && !progress(result.samples.back()))
+    {
+        result.error = ARGON2_ABORTED;
+        return false;
+    }
+
+    return true;
+}
+
+uint32_t Argon2Tuner::search(Argon2Parameters parameters, uint32_t Argon2Parameters::*parameter, uint32_t unit, uint32_t max, double seconds, Argon2TuningResult& result, const Argon2TunerProgressCallback& progress)
+{
+    // The largest value known to meet the target and the smallest one known to miss it.
+    uint32_t low = 0;
+    uint32_t high = max + 1;
+
+    for (unsigned int measurements = 1;; ++measurements)
+    {
+        const uint32_t value = parameters.*parameter / unit;
+
+        (seconds <= options.targetSeconds ? low : high) = value;
+
+        // Within 3% is as close as the measurements' noise allows anyway.
+        if (high - low <= std::max(1u, low / 32) || measurements == maxMeasurementsPerSearch)
+        {
+            return low;
+        }
+
+        // Latency scales with the memory traffic: predict the largest value within the target at the rate just measured.
+        const double secondsPerByte = seconds / static_cast<double>(Argon2Engine::memoryTraffic(parameters));
+        uint32_t first = low + 1;
+        uint32_t last = high - 1;
+
+        while (first < last)
+        {
+            const uint32_t middle = first + (last - first + 1) / 2;
+
+            Argon2Parameters candidate = parameters;
+            candidate.*parameter = middle * unit;
+
+            if (static_cast<double>(Argon2Engine::memoryTraffic(candidate)) * secondsPerByte <= options.targetSeconds)
+            {
+                first = middle;
+            }
+            else
+            {
+                last = middle - 1;
+            }
+        }
+
+        // The prediction can be a little off, but it's always strictly inside the bracket, which thus shrinks with every measurement.
+        parameters.*parameter = first * unit;
+
+        if (!sample(parameters, result, progress, seconds))
+        {
+            return 0;
+        }
+    }
+}
+
+Argon2TuningResult Argon2Tuner::run(const Argon2TunerProgressCallback& progress)
+{
+    Argon2TuningResult result;
+
+    size_t memoryBudget = engine.memoryBudget() / options.concurrency;
+
+    if (options.memoryBudget != 0)
+    {
+        memoryBudget = std::min(memoryBudget, options.memoryBudget);
+    }
+
+    const uint32_t maxMemoryCostMiB = static_cast<uint32_t>(std::clamp<size_t>(memoryBudget / mebibyte, 1, std::max(options.maxMemoryCostMiB, 1u)));
+
+    Argon2Parameters& parameters = result.parameters;
+    parameters.type = options.type;
+    parameters.hashLength = options.hashLength;
+    parameters.parallelism = std::clamp(engine.cores() / options.concurrency, 1u, std::max(options.maxParallelism, 1u));
+    parameters.timeCost = 1;
+    parameters.memoryCostKiB = maxMemoryCostMiB * 1024;
+
+    // Memory cost first, with a single pass.
+    if (!sample(parameters, result, progress, result.seconds))
+    {
+        return result;
+    }
+
+    const uint32_t memoryCostMiB = search(parameters, &Argon2Parameters::memoryCostKiB, 1024, maxMemoryCostMiB, result.seconds, result, progress);
+
+    if (result.error != ARGON2_OK)
+    {
+        return result;
+    }
+
+    parameters.memoryCostKiB = std::max(memoryCostMiB, 1u) * 1024;
+
+    // Then as many passes as still fit into the target with the whole memory budget.
+    uint32_t timeCost = 1;
+
+    if (memoryCostMiB == maxMemoryCostMiB && options.maxTimeCost > 1)
+    {
+        const auto first = std::find_if(result.samples.begin(), result.samples.end(), [&parameters](const Argon2CalibrationSample& sample) { return sample.parameters.memoryCostKiB == parameters.memoryCostKiB; });
+
+        timeCost = search(parameters, &Argon2Parameters::timeCost, 1, options.maxTimeCost, first->seconds, result, progress);
+
+        if (result.error != ARGON2_OK)
+        {
+            return result;
+        }
+    }
+
+    parameters.timeCost = timeCost;
+    result.metTarget = memoryCostMiB != 0;
+
+    for (const Argon2CalibrationSample& sample : result.samples)
+    {
+        if (sample.parameters.memoryCostKiB == parameters.memoryCostKiB && sample.parameters.timeCost == parameters.timeCost)
+        {
+            result.seconds = sample.seconds;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,90 @@
+#ifndef ARGON2TUNER_H
+#define ARGON2TUNER_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "argon2engine.h"
+
+struct Argon2TunerOptions
+{
+    argon2_type type = Argon2_id;
+    uint32_t hashLength = 64;
+
+    // Latency target for a single hash, from its submission to its result, while "concurrency" hashes are submitted at once.
+    double targetSeconds = 0.5;
+    unsigned int concurrency = 1;
+
+    // Memory a single hash may use, in bytes (0 means: the engine's memory budget divided by the concurrency, which is also the upper limit).
+    size_t memoryBudget = 0;
+
+    // Bounds of the search space (e.g. the GUI sliders' ranges).
+    uint32_t maxTimeCost = 128;
+    uint32_t maxMemoryCostMiB = 128;
+    uint32_t maxParallelism = 16;
+
+    // Every measurement is the median of this many rounds of "concurrency" hashes.
+    unsigned int rounds = 3;
+};
+
+struct Argon2CalibrationSample
+{
+    Argon2Parameters parameters;
+
+    // Median (over the rounds) of the time it took the slowest of the concurrent hashes to complete.
+    double seconds = 0.0;
+};
+
+struct Argon2TuningResult
+{
+    // False if the tuner was cancelled, a hash failed, or not even 1 MiB and a single pass meet the target
+    // (in which case the parameters are those cheapest ones).
+    bool metTarget = false;
+    int error = ARGON2_OK;
+
+    Argon2Parameters parameters;
+    double seconds = 0.0;
+
+    // Every measurement taken, in order.
+    std::vector<Argon2CalibrationSample> samples;
+};
+
+// Invoked after every measurement. Return false to cancel the tuning.
+typedef std::function<bool(const Argon2CalibrationSample& sample)> Argon2TunerProgressCallback;
+
+// Calibrates the Argon2 parameters on the engine's machine: searches for the strongest ones whose hashes still complete within
+// a latency target while a given number of them run at once. Memory cost comes first (it's what makes Argon2 expensive to attack
+// on GPUs and ASICs), so the time cost only goes above 1 once the memory cost is at its maximum. The parallelism is the engine's cores
+// divided by the concurrency: more lanes than that would just wait for each other's cores.
+// Latency is close to proportional to the memory traffic (see Argon2Engine::memoryTraffic), so every measurement predicts the next
+// candidate and the search usually converges in a handful of hashes per parameter, while bracketing keeps it exact despite that model.
+class Argon2Tuner
+{
+public:
+    Argon2Tuner(Argon2Engine& engine, const Argon2TunerOptions& options);
+
+    Argon2TuningResult run(const Argon2TunerProgressCallback& progress = nullptr);
+
+    // Thread-safe: aborts the hashes being measured at their next slice boundary, after which run() returns with ARGON2_ABORTED.
+    void cancel();
+
+private:
+    Argon2Engine& engine;
+    Argon2TunerOptions options;
+    std::atomic<bool> cancelled { false };
+
+    // Memory cost of the previous measurement: a new matrix size gets an untimed warm-up round that faults in its arenas.
+    uint32_t warmedUpMemoryCostKiB = 0;
+
+    // Measures the passed parameters and records the sample. Returns false (with result.error set) if a hash failed or the progress callback cancelled.
+    bool sample(const Argon2Parameters& parameters, Argon2TuningResult& result, const Argon2TunerProgressCallback& progress, double& seconds);
+
+    // Largest value (1 to max, in units) of one of the parameters whose latency meets the target, or 0 if there's none (or on failure).
+    // The passed parameters must have already been measured to take "seconds": that's where the search starts from.
+    uint32_t search(Argon2Parameters parameters, uint32_t Argon2Parameters::*parameter, uint32_t unit, uint32_t max, double seconds, Argon2TuningResult& result, const Argon2TunerProgressCallback& progress);
+};
+
+#endif // ARGON2TUNER_H
@@ -0,0 +1,88 @@
+#include "argon2verify.h"
+#include "phcstring.h"
+
+#include <core.h>
+
+#include <cstring>
+
+// Largest decoded salt and hash (tag) an encoded hash string may contain.
+static constexpr size_t maxSaltLength = 1024;
+static constexpr size_t maxHashLength = 1024;
+
+static inline bool constantTimeEquals(const uint8_t* a, const uint8_t* b, size_t length)
+{
+    uint8_t difference = 0;
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        difference |= a[i] ^ b[i];
+    }
+
+    return difference == 0;
+}
+
+int argon2_verify_encoded(std::string_view encoded, const void* pwd, size_t pwdlen, uint32_t threads, allocate_fptr allocate_cbk, deallocate_fptr free_cbk, argon2_progress_fptr progress_cbk, void* user_data)
+{
+    if (pwdlen > ARGON2_MAX_PWD_LENGTH)
+    {
+        return ARGON2_PWD_TOO_LONG;
+    }
+
+    PhcString phc;
+
+    if (!parsePhcString(encoded, phc))
+    {
+        return ARGON2_DECODING_FAIL;
+    }
+
+    uint8_t salt[maxSaltLength];
+    uint8_t expectedHash[maxHashLength];
+    uint8_t computedHash[maxHashLength];
+
+    // Whatever the outcome, none of the three is left on the stack.
+    const auto wipe = [&salt, &expectedHash, &computedHash]() {
+        clear_internal_memory(salt, sizeof(salt));
+        clear_internal_memory(expectedHash, sizeof(expectedHash));
+        clear_internal_memory(computedHash, sizeof(computedHash));
+    };
+
+    const size_t saltLength = decodeBase64(phc.salt, salt, sizeof(salt));
+    const size_t hashLength = decodeBase64(phc.hash, expectedHash, sizeof(expectedHash));
+
+    if (saltLength == SIZE_MAX || hashLength == SIZE_MAX)
+    {
+        wipe();
+        return ARGON2_DECODING_FAIL;
+    }
+
+    argon2_context context;
+    memset(&context, 0x00, sizeof(context));
+
+    context.out = computedHash;
+    context.outlen = static_cast<uint32_t>(hashLength);
+    context.pwd = pwdlen > 0 ? static_cast<uint8_t*>(const_cast<void*>(pwd)) : nullptr;
+    context.pwdlen = static_cast<uint32_t>(pwdlen);
+    context.salt = salt;
+    context.saltlen = static_cast<uint32_t>(saltLength);
+    context.t_cost = phc.timeCost;
+    context.m_cost = phc.memoryCostKiB;
+    context.lanes = phc.parallelism;
+    context.threads = threads < 1 ? 1 : threads > phc.parallelism ? phc.parallelism : threads;
+    context.version = phc.version;
+    context.allocate_cbk = allocate_cbk;
+    context.free_cbk = free_cbk;
+    context.flags = ARGON2_DEFAULT_FLAGS;
+
+    const int r = argon2_progress_ctx(&context, phc.type, progress_cbk, user_data);
+
+    if (r != ARGON2_OK)
+    {
+        wipe();
+        return r;
+    }
+
+    const bool equal = constantTimeEquals(expectedHash, computedHash, hashLength);
+    wipe();
+
+    return equal ? ARGON2_OK : ARGON2_VERIFY_MISMATCH;
+}
@@ -0,0 +1,18 @@
+#ifndef ARGON2VERIFY_H
+#define ARGON2VERIFY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "argon2progress.h"
+
+// Verifies a password against an encoded Argon2 hash string, like argon2_verify does, but:
+// the encoded hash does not need to be NUL-terminated, the Argon2 variant is taken from the string itself,
+// the amount of threads to use is up to the caller (instead of always being the parallelism parameter),
+// the memory matrix can come from custom allocation callbacks (pass NULL to use the library's default allocator)
+// and the computation reports its progress (and can be aborted) through the passed progress callback (which can be NULL too).
+// Returns ARGON2_OK if the password matches, ARGON2_VERIFY_MISMATCH if it doesn't, or any other Argon2 error code.
+int argon2_verify_encoded(std::string_view encoded, const void* pwd, size_t pwdlen, uint32_t threads, allocate_fptr allocate_cbk, deallocate_fptr free_cbk, argon2_progress_fptr progress_cbk, void* user_data);
+
+#endif // ARGON2VERIFY_H
@@ -0,0 +1,153 @@
+#include "batchhasher.h"
+#include "argon2multibuffer.h"
+
+#include <deque>
+#include <future>
+#include <string>
+#include <vector>
+
+BatchHasher::BatchHasher(Argon2Engine& engine, const BatchHasherOptions& options)
+    : engine(engine)
+    , options(options)
+{
+    if (this->options.window == 0)
+    {
+        this->options.window = static_cast<size_t>(engine.cores()) * 4 * (options.multiBuffer ? argon2_multibuffer_width() : 1);
+    }
+}
+
+uint64_t BatchHasher::run(std::istream& input, FILE* output)
+{
+    if (options.multiBuffer && argon2_multibuffer_width() > 1)
+    {
+        return runMultiBuffer(input, output);
+    }
+
+    std::deque<std::future<Argon2HashResult>> pending;
+
+    uint64_t linesWritten = 0;
+    uint64_t failures = 0;
+
+    // Results are written strictly in input order: the oldest pending line is always the next one to go out.
+    const auto writeOldest = [&] {
+        const Argon2HashResult result = pending.front().get();
+        pending.pop_front();
+
+        const uint64_t lineNumber = ++linesWritten;
+
+        if (result.error != ARGON2_OK)
+        {
+            fprintf(stderr, "Argon2 hash generation failed for line %llu: %s (error code %d)\n", static_cast<unsigned long long>(lineNumber), argon2_error_message(result.error), result.error);
+            ++failures;
+        }
+
+        fwrite(result.encodedHash.data(), 1, result.encodedHash.size(), output);
+        fputc('\n', output);
+    };
+
+    std::string password;
+
+    while (std::getline(input, password))
+    {
+        if (!password.empty() && password.back() == '\r')
+        {
+            password.pop_back();
+        }
+
+        if (pending.size() >= options.window)
+        {
+            writeOldest();
+        }
+
+        Argon2HashRequest request;
+        request.parameters = options.parameters;
+        request.password = std::move(password);
+
+        pending.push_back(engine.hash(std::move(request)));
+        password = std::string();
+    }
+
+    while (!pending.empty())
+    {
+        writeOldest();
+    }
+
+    fflush(output);
+
+    return failures;
+}
+
+uint64_t BatchHasher::runMultiBuffer(std::istream& input, FILE* output)
+{
+    const size_t width = argon2_multibuffer_width();
+
+    // Same as run(), except that the lines are hashed (and thus also queued) in groups of one multi-buffer job each.
+    std::deque<std::future<std::vector<Argon2HashResult>>> pending;
+    std::vector<std::string> group;
+    group.reserve(width);
+
+    uint64_t linesWritten = 0;
+    uint64_t failures = 0;
+
+    const auto writeOldest = [&] {
+        const std::vector<Argon2HashResult> results = pending.front().get();
+        pending.pop_front();
+
+        for (const Argon2HashResult& result : results)
+        {
+            const uint64_t lineNumber = ++linesWritten;
+
+            if (result.error != ARGON2_OK)
+            {
+                fprintf(stderr, "Argon2 hash generation failed for line %llu: %s (error code %d)\n", static_cast<unsigned long long>(lineNumber), argon2_error_message(result.error), result.error);
+                ++failures;
+            }
+
+            fwrite(result.encodedHash.data(), 1, result.encodedHash.size(), output);
+            fputc('\n', output);
+        }
+    };
+
+    const auto submitGroup = [&] {
+        if (pending.size() * width >= options.window)
+        {
+            writeOldest();
+        }
+
+        pending.push_back(engine.hashMultiBuffer(options.parameters, std::move(group)));
+        group = std::vector<std::string>();
+        group.reserve(width);
+    };
+
+    std::string password;
+
+    while (std::getline(input, password))
+    {
+        if (!password.empty() && password.back() == '\r')
+        {
+            password.pop_back();
+        }
+
+        group.push_back(std::move(password));
+        password = std::string();
+
+        if (group.size() == width)
+        {
+            submitGroup();
+        }
+    }
+
+    if (!group.empty())
+    {
+        submitGroup();
+    }
+
+    while (!pending.empty())
+    {
+        writeOldest();
+    }
+
+    fflush(output);
+
+    return failures;
+}
@@ -0,0 +1,43 @@
+#ifndef BATCHHASHER_H
+#define BATCHHASHER_H
+
+#include <cstdio>
+#include <cstdint>
+#include <istream>
+
+#include "argon2engine.h"
+
+struct BatchHasherOptions
+{
+    Argon2Parameters parameters;
+
+    // Maximum number of lines that can be in flight (read but not yet written out) at any given time.
+    // Once that many lines are pending, reading the input blocks until the oldest one has been written.
+    // This is what keeps the memory usage bounded no matter how large the input is (0 means: 4 lines per engine core, or 4 multi-buffer groups per core).
+    size_t window = 0;
+
+    // Throughput mode: hash argon2_multibuffer_width() lines at a time on each core, interleaved across its SIMD lanes
+    // (see Argon2Engine::hashMultiBuffer). Worth it for small memory costs; the hashes themselves are exactly the same as in the regular mode.
+    bool multiBuffer = false;
+};
+
+// Hashes passwords line by line (one password per line) and writes the PHC-encoded hashes to the output
+// in exactly the same order as the input, one per line. The hashes are computed concurrently on the passed engine
+// (as many at once as its memory budget and cores allow), whereas reading and writing stream through a bounded window of lines.
+class BatchHasher
+{
+public:
+    BatchHasher(Argon2Engine& engine, const BatchHasherOptions& options);
+
+    // Returns the number of lines that failed to hash (for those, an empty line is written to the output
+    // to keep it aligned with the input, and the error is reported on stderr).
+    uint64_t run(std::istream& input, FILE* output);
+
+private:
+    Argon2Engine& engine;
+    BatchHasherOptions options;
+
+    uint64_t runMultiBuffer(std::istream& input, FILE* output);
+};
+
+#endif // BATCHHASHER_H
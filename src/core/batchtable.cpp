@@ -0,0 +1,363 @@
+#include "batchtable.h"
+#include "argon2progress.h"
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+// Flush the export buffer once it grows past this size.
+static constexpr size_t exportBufferSize = 64 * 1024;
+
+// Rows copied into the export buffer per lock of the batch (so that the engine's threads are never kept waiting for long).
+static constexpr uint64_t exportRowsPerLock = 4096;
+
+BatchTable::BatchTable(BatchMode mode)
+    : batchMode(mode)
+{
+}
+
+BatchTable::~BatchTable()
+{
+    cancel();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    jobFinished.wait(lock, [this] { return inFlight == 0; });
+}
+
+std::unique_ptr<BatchTable> BatchTable::open(const char* path, BatchMode mode)
+{
+    std::unique_ptr<BatchTable> batch(new BatchTable(mode));
+
+    if (!batch->file.open(path))
+    {
+        return nullptr;
+    }
+
+    const char* data = batch->file.data();
+    const size_t size = batch->file.size();
+
+    batch->lineOffsets.push_back(0);
+
+    for (size_t offset = 0; offset < size;)
+    {
+        const char* newline = static_cast<const char*>(memchr(data + offset, '\n', size - offset));
+
+        offset = newline != nullptr ? static_cast<size_t>(newline - data) + 1 : size + 1;
+        batch->lineOffsets.push_back(offset);
+    }
+
+    batch->lineOffsets.shrink_to_fit();
+    batch->rows.resize(batch->rowCount());
+
+    return batch;
+}
+
+std::string_view BatchTable::line(uint64_t index) const
+{
+    const char* start = file.data() + lineOffsets[index];
+    size_t length = static_cast<size_t>(lineOffsets[index + 1] - lineOffsets[index] - 1);
+
+    if (length > 0 && start[length - 1] == '\r')
+    {
+        --length;
+    }
+
+    return std::string_view(start, length);
+}
+
+std::string_view BatchTable::recordHash(uint64_t index) const
+{
+    const std::string_view record = line(index);
+    return record.substr(0, std::min(record.find_first_of(" \t"), record.size()));
+}
+
+BatchRow BatchTable::row(uint64_t index) const
+{
+    BatchRow row;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const RowState& state = rows[index];
+
+    row.status = state.status;
+    row.error = state.error;
+
+    if (batchMode == BatchMode::Verify)
+    {
+        row.hash = recordHash(index);
+    }
+    else if (state.status == BatchRowStatus::Hashed)
+    {
+        row.hash.assign(chunks[state.hashOffset / chunkSize].get() + state.hashOffset % chunkSize, state.hashLength);
+    }
+
+    return row;
+}
+
+void BatchTable::start(Argon2Engine& engine, const Argon2Parameters& parameters, size_t window)
+{
+    if (feeder.joinable())
+    {
+        feeder.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        feeding = true;
+        startTime = std::chrono::steady_clock::now();
+    }
+
+    cancelled = false;
+    feeder = std::thread(&BatchTable::feed, this, std::ref(engine), parameters, window != 0 ? window : static_cast<size_t>(engine.cores()) * 4);
+}
+
+void BatchTable::cancel()
+{
+    {
+        // (Under the lock, so that the feeder can't miss it between checking for it and waiting.)
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled = true;
+    }
+
+    jobFinished.notify_all();
+
+    if (feeder.joinable())
+    {
+        feeder.join();
+    }
+}
+
+void BatchTable::feed(Argon2Engine& engine, Argon2Parameters parameters, size_t window)
+{
+    for (uint64_t index = 0; index < rowCount() && !cancelled; ++index)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            if (rows[index].status != BatchRowStatus::Queued)
+            {
+                continue;
+            }
+
+            jobFinished.wait(lock, [this, window] { return inFlight < window || cancelled; });
+
+            if (cancelled)
+            {
+                break;
+            }
+
+            ++inFlight;
+        }
+
+        const auto onProgress = [this, index](uint32_t slicesDone, uint32_t) {
+            if (cancelled)
+            {
+                return false;
+            }
+
+            if (slicesDone == 0)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                rows[index].status = BatchRowStatus::Running;
+                markChanged(index);
+            }
+
+            return true;
+        };
+
+        // (Jobs that can't run at all finish right away, on this thread: the lock mustn't be held here.)
+        if (batchMode == BatchMode::Hash)
+        {
+            Argon2HashRequest request;
+            request.parameters = parameters;
+            request.password = line(index);
+
+            engine.hash(std::move(request), onProgress, [this, index](const Argon2HashResult& result) { finish(index, result.error, result.encodedHash); });
+        }
+        else
+        {
+            const std::string_view record = line(index);
+            const std::string_view hash = recordHash(index);
+            const std::string_view password = hash.size() < record.size() ? record.substr(hash.size() + 1) : std::string_view();
+
+            engine.verify(std::string(hash), std::string(password), onProgress, [this, index](int result) { finish(index, result, std::string_view()); });
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    feeding = false;
+
+    if (inFlight == 0)
+    {
+        secondsBefore += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+}
+
+void BatchTable::finish(uint64_t index, int error, std::string_view hash)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    RowState& state = rows[index];
+    state.error = static_cast<int16_t>(error);
+
+    // Cancelled rows are done another time.
+    if (error == ARGON2_ABORTED)
+    {
+        state.status = BatchRowStatus::Queued;
+    }
+    else if (error == ARGON2_OK && batchMode == BatchMode::Hash)
+    {
+        const size_t length = std::min<size_t>(hash.size(), UINT16_MAX);
+
+        // A hash never straddles two chunks.
+        if (arenaSize % chunkSize + length > chunkSize || chunks.size() * chunkSize <= arenaSize)
+        {
+            arenaSize = chunks.size() * chunkSize;
+            chunks.push_back(std::make_unique<char[]>(chunkSize));
+        }
+
+        memcpy(chunks[arenaSize / chunkSize].get() + arenaSize % chunkSize, hash.data(), length);
+
+        state.hashOffset = arenaSize;
+        state.hashLength = static_cast<uint16_t>(length);
+        state.status = BatchRowStatus::Hashed;
+
+        arenaSize += length;
+    }
+    else if (error == ARGON2_OK)
+    {
+        state.status = BatchRowStatus::Matched;
+    }
+    else if (error == ARGON2_VERIFY_MISMATCH && batchMode == BatchMode::Verify)
+    {
+        state.status = BatchRowStatus::Mismatched;
+    }
+    else
+    {
+        state.status = BatchRowStatus::Failed;
+        ++failedRows;
+    }
+
+    if (error != ARGON2_ABORTED)
+    {
+        ++doneRows;
+    }
+
+    markChanged(index);
+
+    if (--inFlight == 0 && !feeding)
+    {
+        secondsBefore += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    jobFinished.notify_all();
+}
+
+void BatchTable::markChanged(uint64_t index)
+{
+    changedFirst = std::min(changedFirst, index);
+    changedLast = std::max(changedLast, index + 1);
+}
+
+std::pair<uint64_t, uint64_t> BatchTable::takeChanges()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (changedFirst >= changedLast)
+    {
+        return { 0, 0 };
+    }
+
+    const std::pair<uint64_t, uint64_t> changes { changedFirst, changedLast };
+
+    changedFirst = UINT64_MAX;
+    changedLast = 0;
+
+    return changes;
+}
+
+BatchTableProgress BatchTable::progress() const
+{
+    BatchTableProgress progress;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    progress.rows = rowCount();
+    progress.done = doneRows;
+    progress.failed = failedRows;
+    progress.running = feeding || inFlight > 0;
+    progress.seconds = secondsBefore;
+
+    if (progress.running)
+    {
+        progress.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    return progress;
+}
+
+bool BatchTable::exportResults(const std::function<bool(const char* data, size_t size)>& write) const
+{
+    std::string buffer;
+    buffer.reserve(exportBufferSize + 2048);
+
+    for (uint64_t first = 0; first < rowCount(); first += exportRowsPerLock)
+    {
+        const uint64_t last = std::min(first + exportRowsPerLock, rowCount());
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            for (uint64_t index = first; index < last; ++index)
+            {
+                const RowState& state = rows[index];
+
+                if (batchMode == BatchMode::Hash)
+                {
+                    if (state.status == BatchRowStatus::Hashed)
+                    {
+                        buffer.append(chunks[state.hashOffset / chunkSize].get() + state.hashOffset % chunkSize, state.hashLength);
+                    }
+
+                    buffer.push_back('\n');
+                    continue;
+                }
+
+                char line[64];
+                int length;
+
+                switch (state.status)
+                {
+                    case BatchRowStatus::Matched:
+                        length = snprintf(line, sizeof(line), "%llu\tPASS\n", static_cast<unsigned long long>(index + 1));
+                        break;
+                    case BatchRowStatus::Mismatched:
+                        length = snprintf(line, sizeof(line), "%llu\tFAIL\n", static_cast<unsigned long long>(index + 1));
+                        break;
+                    case BatchRowStatus::Failed:
+                        length = snprintf(line, sizeof(line), "%llu\tERROR %d\n", static_cast<unsigned long long>(index + 1), state.error);
+                        break;
+                    default:
+                        length = 0;
+                        break;
+                }
+
+                buffer.append(line, static_cast<size_t>(length));
+            }
+        }
+
+        if (buffer.size() >= exportBufferSize)
+        {
+            if (!write(buffer.data(), buffer.size()))
+            {
+                return false;
+            }
+
+            buffer.clear();
+        }
+    }
+
+    return buffer.empty() || write(buffer.data(), buffer.size());
+}
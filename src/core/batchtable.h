@@ -0,0 +1,155 @@
+#ifndef BATCHTABLE_H
+#define BATCHTABLE_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <condition_variable>
+
+#include "argon2engine.h"
+#include "mappedfile.h"
+
+enum class BatchMode
+{
+    // Every line is a password, hashed with the batch's parameters (and a random salt each).
+    Hash,
+
+    // Every line is an "<encoded hash> <password>" record (like --verify-batch's input).
+    Verify,
+};
+
+enum class BatchRowStatus : uint8_t
+{
+    Queued,
+    Running,
+    Hashed,
+    Matched,
+    Mismatched,
+    Failed,
+};
+
+struct BatchRow
+{
+    BatchRowStatus status = BatchRowStatus::Queued;
+
+    // The Argon2 error code of a failed row.
+    int error = ARGON2_OK;
+
+    // The encoded hash: computed in hash mode, that of the record in verify mode.
+    std::string hash;
+};
+
+struct BatchTableProgress
+{
+    uint64_t rows = 0;
+    uint64_t done = 0;
+    uint64_t failed = 0;
+
+    // Time spent processing (across every start and cancel), so that done / seconds is the batch's throughput.
+    double seconds = 0.0;
+    bool running = false;
+};
+
+// A password list (or a list of verification records) processed row by row on an engine, for a frontend to show as a table.
+// The list stays memory-mapped: a row is just the offset of its line (8 bytes), and its text is only cut out of the file when it's
+// submitted or asked for. Computed hashes go into an arena of fixed-size chunks instead of one string each. That way, a list of
+// millions of passwords takes a few dozen bytes of memory per row, and none of the table has to exist as strings of the GUI toolkit.
+//
+// Rows are submitted in order through a bounded window of jobs in flight, from a feeder thread. Results arrive on the engine's threads:
+// instead of signalling every one of them, the batch collects the range of rows that changed until the frontend takes it (see takeChanges).
+class BatchTable
+{
+public:
+    // Returns nullptr (and prints the reason to stderr) if the file can't be opened.
+    static std::unique_ptr<BatchTable> open(const char* path, BatchMode mode);
+
+    // Cancels the batch and waits for its jobs.
+    ~BatchTable();
+
+    BatchTable(const BatchTable&) = delete;
+    BatchTable& operator=(const BatchTable&) = delete;
+
+    BatchMode mode() const
+    {
+        return batchMode;
+    }
+
+    uint64_t rowCount() const
+    {
+        return lineOffsets.size() - 1;
+    }
+
+    BatchRow row(uint64_t index) const;
+
+    // Submits every row that isn't done yet to the engine (with the passed parameters in hash mode), keeping at most window of them in flight
+    // (0 means: 4 per engine core). Must not be called while the batch is running. The engine must outlive the batch, or at least its cancel.
+    void start(Argon2Engine& engine, const Argon2Parameters& parameters, size_t window = 0);
+
+    // Stops submitting rows and aborts the running ones (which go back to the queue, so that the next start picks them up again).
+    // Blocks until the feeder thread is gone, not until the aborted jobs are.
+    void cancel();
+
+    BatchTableProgress progress() const;
+
+    // The first and one past the last row whose status changed since the last call (first == last if none did).
+    std::pair<uint64_t, uint64_t> takeChanges();
+
+    // Writes the results in row order, in the format of the headless modes: one encoded hash per line in hash mode (empty for rows
+    // that failed or didn't run) and "<line number>\tPASS|FAIL|ERROR <code>" lines in verify mode (none for rows that didn't run).
+    // Returns false as soon as the sink does.
+    bool exportResults(const std::function<bool(const char* data, size_t size)>& write) const;
+
+private:
+    // Computed hashes are appended to chunks of this size, which never move once allocated.
+    static constexpr size_t chunkSize = 1024 * 1024;
+
+    struct RowState
+    {
+        uint64_t hashOffset = 0;
+        uint16_t hashLength = 0;
+        int16_t error = ARGON2_OK;
+        BatchRowStatus status = BatchRowStatus::Queued;
+    };
+
+    BatchMode batchMode;
+    MappedFile file;
+
+    // Offset of every line, followed by the size of the file (plus one if it doesn't end with a newline): line i spans [lineOffsets[i], lineOffsets[i + 1] - 1).
+    std::vector<uint64_t> lineOffsets;
+
+    mutable std::mutex mutex;
+    std::condition_variable jobFinished;
+    std::vector<RowState> rows;
+    std::vector<std::unique_ptr<char[]>> chunks;
+    uint64_t arenaSize = 0;
+    uint64_t changedFirst = UINT64_MAX;
+    uint64_t changedLast = 0;
+    uint64_t doneRows = 0;
+    uint64_t failedRows = 0;
+    size_t inFlight = 0;
+    bool feeding = false;
+
+    double secondsBefore = 0.0;
+    std::chrono::steady_clock::time_point startTime;
+
+    std::atomic<bool> cancelled { false };
+    std::thread feeder;
+
+    explicit BatchTable(BatchMode mode);
+
+    std::string_view line(uint64_t index) const;
+    std::string_view recordHash(uint64_t index) const;
+    void feed(Argon2Engine& engine, Argon2Parameters parameters, size_t window);
+    void finish(uint64_t index, int error, std::string_view hash);
+    void markChanged(uint64_t index);
+};
+
+#endif // BATCHTABLE_H
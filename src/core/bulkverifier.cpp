@@ -0,0 +1,350 @@
+#include "bulkverifier.h"
+#include "argon2verify.h"
+#include "phcstring.h"
+#include "arenapool.h"
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <condition_variable>
+
+// Flush a worker's report buffer once it grows past this size.
+static constexpr size_t reportBufferSize = 64 * 1024;
+
+struct VerifyRecord
+{
+    uint64_t offset;
+    uint64_t lineNumber;
+    uint32_t hashLength;
+    uint32_t passwordLength;
+    uint32_t group;
+};
+
+struct ParameterSet
+{
+    argon2_type type;
+    uint32_t version;
+    uint32_t memoryCostKiB;
+    uint32_t timeCost;
+    uint32_t parallelism;
+
+    bool operator<(const ParameterSet& other) const
+    {
+        return std::tie(type, version, memoryCostKiB, timeCost, parallelism) < std::tie(other.type, other.version, other.memoryCostKiB, other.timeCost, other.parallelism);
+    }
+};
+
+struct GroupStats
+{
+    ParameterSet parameters;
+    uint64_t records = 0;
+    std::atomic<uint64_t> passed { 0 };
+    std::atomic<uint64_t> failed { 0 };
+    std::atomic<uint64_t> errors { 0 };
+};
+
+static int verifyRecord(const char* data, const VerifyRecord& record)
+{
+    const char* password = data + record.offset + record.hashLength + 1;
+
+    // The parallelism comes from verifying several records at once, hence the single thread per hash.
+    // Consecutive records of a group need exactly the same amount of memory, so after the first hash of a task
+    // every matrix comes pre-faulted out of the arena pool (and goes back to it without being wiped on this thread).
+    return argon2_verify_encoded(std::string_view(data + record.offset, record.hashLength), password, record.passwordLength, 1, &argon2_arena_allocate, &argon2_arena_free, nullptr, nullptr);
+}
+
+static void appendReportLine(std::string& buffer, const uint64_t lineNumber, const int result)
+{
+    char line[64];
+    int length;
+
+    switch (result)
+    {
+        case ARGON2_OK:
+            length = snprintf(line, sizeof(line), "%llu\tPASS\n", static_cast<unsigned long long>(lineNumber));
+            break;
+        case ARGON2_VERIFY_MISMATCH:
+            length = snprintf(line, sizeof(line), "%llu\tFAIL\n", static_cast<unsigned long long>(lineNumber));
+            break;
+        default:
+            length = snprintf(line, sizeof(line), "%llu\tERROR %d\n", static_cast<unsigned long long>(lineNumber), result);
+            break;
+    }
+
+    buffer.append(line, static_cast<size_t>(length));
+}
+
+BulkVerifier::BulkVerifier(Argon2Engine& engine)
+    : engine(engine)
+{
+}
+
+BulkVerifierStats BulkVerifier::run(const char* data, size_t size, FILE* report)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+
+    BulkVerifierStats stats;
+
+    std::mutex reportMutex;
+    std::string reportBuffer;
+    reportBuffer.reserve(reportBufferSize + 64);
+
+    const auto flushReport = [&](std::string& buffer) {
+        std::lock_guard<std::mutex> lock(reportMutex);
+        fwrite(buffer.data(), 1, buffer.size(), report);
+        buffer.clear();
+    };
+
+    // First pass: split the input into records (without copying anything) and assign every record to its parameter group.
+
+    std::map<ParameterSet, uint32_t> groupIndices;
+    std::vector<VerifyRecord> records;
+
+    uint64_t lineNumber = 0;
+
+    for (size_t offset = 0; offset < size;)
+    {
+        const char* lineStart = data + offset;
+        const char* newline = static_cast<const char*>(memchr(lineStart, '\n', size - offset));
+        size_t lineLength = newline != nullptr ? static_cast<size_t>(newline - lineStart) : size - offset;
+
+        const size_t nextOffset = offset + lineLength + 1;
+        ++lineNumber;
+
+        if (lineLength > 0 && lineStart[lineLength - 1] == '\r')
+        {
+            --lineLength;
+        }
+
+        if (lineLength == 0)
+        {
+            offset = nextOffset;
+            continue;
+        }
+
+        ++stats.records;
+
+        size_t hashLength = 0;
+
+        while (hashLength < lineLength && lineStart[hashLength] != ' ' && lineStart[hashLength] != '\t')
+        {
+            ++hashLength;
+        }
+
+        const size_t passwordLength = hashLength < lineLength ? lineLength - hashLength - 1 : 0;
+
+        PhcString phc;
+
+        if (hashLength > UINT32_MAX || passwordLength > UINT32_MAX || !parsePhcString(std::string_view(lineStart, hashLength), phc))
+        {
+            ++stats.errors;
+            appendReportLine(reportBuffer, lineNumber, ARGON2_DECODING_FAIL);
+
+            if (reportBuffer.size() >= reportBufferSize)
+            {
+                flushReport(reportBuffer);
+            }
+
+            offset = nextOffset;
+            continue;
+        }
+
+        const ParameterSet parameters { phc.type, phc.version, phc.memoryCostKiB, phc.timeCost, phc.parallelism };
+        const auto group = groupIndices.emplace(parameters, static_cast<uint32_t>(groupIndices.size())).first;
+
+        records.push_back(VerifyRecord { offset, lineNumber, static_cast<uint32_t>(hashLength), static_cast<uint32_t>(passwordLength), group->second });
+
+        offset = nextOffset;
+    }
+
+    flushReport(reportBuffer);
+
+    // Counting sort of the records by group, so that consecutive records share their parameter set.
+
+    const size_t groupCount = groupIndices.size();
+    std::unique_ptr<GroupStats[]> groups(new GroupStats[groupCount]);
+
+    for (const auto& [parameters, index] : groupIndices)
+    {
+        groups[index].parameters = parameters;
+    }
+
+    for (const VerifyRecord& record : records)
+    {
+        ++groups[record.group].records;
+    }
+
+    std::vector<size_t> groupOffsets(groupCount + 1, 0);
+
+    for (size_t i = 0; i < groupCount; ++i)
+    {
+        groupOffsets[i + 1] = groupOffsets[i] + groups[i].records;
+    }
+
+    {
+        std::vector<VerifyRecord> sorted(records.size());
+
+        for (const VerifyRecord& record : records)
+        {
+            sorted[groupOffsets[record.group]++] = record;
+        }
+
+        records.swap(sorted);
+    }
+
+    stats.groups = groupCount;
+
+    // Second pass: verify. Every group is split into up to one task per engine core, each claiming small chunks of the group's records.
+    // The tasks are admitted group after group, as many at once as the engine's memory budget allows for that group's memory cost.
+
+    static constexpr size_t chunkSize = 8;
+
+    std::unique_ptr<std::atomic<size_t>[]> cursors(new std::atomic<size_t>[groupCount]);
+    std::atomic<uint64_t> verified { 0 };
+
+    std::mutex progressMutex;
+    std::condition_variable progressChanged;
+    bool finished = false;
+
+    std::vector<std::future<void>> tasks;
+
+    for (size_t i = 0, first = 0; i < groupCount; first += groups[i].records, ++i)
+    {
+        const ParameterSet& parameters = groups[i].parameters;
+
+        Argon2JobCost cost = engine.hashCost(Argon2Parameters { parameters.type, parameters.timeCost, parameters.memoryCostKiB, parameters.parallelism, 0 });
+        cost.cores = 1;
+
+        const size_t last = first + groups[i].records;
+
+        // Like Argon2Engine::verify, records whose matrix wouldn't fit into the budget even on an idle engine fail right away.
+        if (cost.memoryBytes > engine.memoryBudget())
+        {
+            for (size_t j = first; j < last; ++j)
+            {
+                appendReportLine(reportBuffer, records[j].lineNumber, ARGON2_MEMORY_TOO_MUCH);
+
+                if (reportBuffer.size() >= reportBufferSize)
+                {
+                    flushReport(reportBuffer);
+                }
+            }
+
+            flushReport(reportBuffer);
+
+            groups[i].errors += groups[i].records;
+            verified += groups[i].records;
+            continue;
+        }
+
+        const size_t taskCount = std::min<size_t>(engine.cores(), (groups[i].records + chunkSize - 1) / chunkSize);
+
+        cursors[i] = first;
+
+        for (size_t t = 0; t < taskCount; ++t)
+        {
+            tasks.push_back(engine.submit(cost, [&, i, last] {
+                std::string buffer;
+                buffer.reserve(reportBufferSize + 64);
+
+                for (;;)
+                {
+                    const size_t chunkStart = cursors[i].fetch_add(chunkSize);
+
+                    if (chunkStart >= last)
+                    {
+                        break;
+                    }
+
+                    const size_t chunkEnd = std::min(chunkStart + chunkSize, last);
+
+                    for (size_t j = chunkStart; j < chunkEnd; ++j)
+                    {
+                        const VerifyRecord& record = records[j];
+                        const int r = verifyRecord(data, record);
+
+                        GroupStats& group = groups[record.group];
+
+                        switch (r)
+                        {
+                            case ARGON2_OK:
+                                ++group.passed;
+                                break;
+                            case ARGON2_VERIFY_MISMATCH:
+                                ++group.failed;
+                                break;
+                            default:
+                                ++group.errors;
+                                break;
+                        }
+
+                        appendReportLine(buffer, record.lineNumber, r);
+
+                        if (buffer.size() >= reportBufferSize)
+                        {
+                            flushReport(buffer);
+                        }
+                    }
+
+                    verified += chunkEnd - chunkStart;
+                }
+
+                flushReport(buffer);
+            }));
+        }
+    }
+
+    std::thread progressReporter([&] {
+        std::unique_lock<std::mutex> lock(progressMutex);
+
+        while (!progressChanged.wait_for(lock, std::chrono::seconds(1), [&] { return finished; }))
+        {
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            const uint64_t done = verified.load();
+
+            fprintf(stderr, "Verified %llu / %zu records (%.1f records/s)\n", static_cast<unsigned long long>(done), records.size(), static_cast<double>(done) / seconds);
+        }
+    });
+
+    for (std::future<void>& task : tasks)
+    {
+        task.wait();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(progressMutex);
+        finished = true;
+    }
+
+    progressChanged.notify_one();
+    progressReporter.join();
+
+    fflush(report);
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    for (size_t i = 0; i < groupCount; ++i)
+    {
+        const GroupStats& group = groups[i];
+
+        stats.passed += group.passed;
+        stats.failed += group.failed;
+        stats.errors += group.errors;
+
+        fprintf(stderr, "%s v=%u m=%u,t=%u,p=%u: %llu records, %llu passed, %llu failed, %llu errors\n", argon2_type2string(group.parameters.type, 0), group.parameters.version, group.parameters.memoryCostKiB, group.parameters.timeCost, group.parameters.parallelism, static_cast<unsigned long long>(group.records), static_cast<unsigned long long>(group.passed.load()), static_cast<unsigned long long>(group.failed.load()), static_cast<unsigned long long>(group.errors.load()));
+    }
+
+    fprintf(stderr, "Verified %llu records in %.3f s (%.1f records/s): %llu passed, %llu failed, %llu errors, %llu parameter groups\n", static_cast<unsigned long long>(stats.records), stats.seconds, stats.seconds > 0.0 ? static_cast<double>(stats.records) / stats.seconds : 0.0, static_cast<unsigned long long>(stats.passed), static_cast<unsigned long long>(stats.failed), static_cast<unsigned long long>(stats.errors), static_cast<unsigned long long>(stats.groups));
+
+    return stats;
+}
@@ -0,0 +1,36 @@
+#ifndef BULKVERIFIER_H
+#define BULKVERIFIER_H
+
+#include <cstdio>
+#include <cstdint>
+
+#include "argon2engine.h"
+
+struct BulkVerifierStats
+{
+    uint64_t records = 0;
+    uint64_t passed = 0;
+    uint64_t failed = 0;
+    uint64_t errors = 0;
+    uint64_t groups = 0;
+    double seconds = 0.0;
+};
+
+// Verifies (encoded hash, password) records in bulk, straight out of a memory-mapped dump.
+// Every line of the input is one record: the encoded Argon2 hash, one space or tab, and then the password (everything up to the end of the line).
+// Records are parsed in place, grouped by identical (variant, version, m, t, p) and each group is verified in parallel on the passed engine,
+// with the hashes of a group reusing pooled, pre-faulted memory matrices (see arenapool.h).
+class BulkVerifier
+{
+public:
+    explicit BulkVerifier(Argon2Engine& engine);
+
+    // Writes one "<line number>\tPASS|FAIL|ERROR <code>" line per record to the report as soon as the record has been verified
+    // (grouped by parameter set, so not necessarily in input order), followed by a summary per parameter group on stderr.
+    BulkVerifierStats run(const char* data, size_t size, FILE* report);
+
+private:
+    Argon2Engine& engine;
+};
+
+#endif // BULKVERIFIER_H
@@ -0,0 +1,217 @@
+#include "daemonprotocol.h"
+
+#include <cstring>
+
+static void putUint8(std::string& output, uint8_t value)
+{
+    output.push_back(static_cast<char>(value));
+}
+
+static void putUint32(std::string& output, uint32_t value)
+{
+    const char bytes[4] = { static_cast<char>(value), static_cast<char>(value >> 8), static_cast<char>(value >> 16), static_cast<char>(value >> 24) };
+    output.append(bytes, sizeof(bytes));
+}
+
+static void putUint64(std::string& output, uint64_t value)
+{
+    putUint32(output, static_cast<uint32_t>(value));
+    putUint32(output, static_cast<uint32_t>(value >> 32));
+}
+
+static void putBytes(std::string& output, const std::string& value)
+{
+    putUint32(output, static_cast<uint32_t>(value.size()));
+    output.append(value);
+}
+
+// Bounds-checked reader over a frame body: once a read runs past the end, every further read fails too.
+struct FrameReader
+{
+    const uint8_t* position;
+    const uint8_t* end;
+    bool ok = true;
+
+    bool available(size_t n)
+    {
+        ok = ok && static_cast<size_t>(end - position) >= n;
+        return ok;
+    }
+
+    uint8_t uint8()
+    {
+        return available(1) ? *position++ : 0;
+    }
+
+    uint32_t uint32()
+    {
+        if (!available(4))
+        {
+            return 0;
+        }
+
+        const uint32_t value = static_cast<uint32_t>(position[0]) | static_cast<uint32_t>(position[1]) << 8 | static_cast<uint32_t>(position[2]) << 16 | static_cast<uint32_t>(position[3]) << 24;
+        position += 4;
+        return value;
+    }
+
+    uint64_t uint64()
+    {
+        const uint64_t low = uint32();
+        return low | static_cast<uint64_t>(uint32()) << 32;
+    }
+
+    std::string bytes()
+    {
+        const uint32_t length = uint32();
+
+        if (!available(length))
+        {
+            return std::string();
+        }
+
+        std::string value(reinterpret_cast<const char*>(position), length);
+        position += length;
+        return value;
+    }
+};
+
+// Checks that a complete frame is available and returns a reader over its body (or sets frameSize to 0 or -1, see decodeDaemonRequest).
+static bool beginFrame(const char* data, size_t size, ptrdiff_t& frameSize, FrameReader& reader)
+{
+    if (size < 4)
+    {
+        frameSize = 0;
+        return false;
+    }
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    const uint32_t bodySize = static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 | static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+
+    if (bodySize > DAEMON_MAX_FRAME_SIZE)
+    {
+        frameSize = -1;
+        return false;
+    }
+
+    if (size - 4 < bodySize)
+    {
+        frameSize = 0;
+        return false;
+    }
+
+    frameSize = static_cast<ptrdiff_t>(bodySize) + 4;
+    reader.position = bytes + 4;
+    reader.end = bytes + 4 + bodySize;
+    return true;
+}
+
+static void finishFrame(std::string& output, size_t frameStart)
+{
+    const uint32_t bodySize = static_cast<uint32_t>(output.size() - frameStart - 4);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        output[frameStart + i] = static_cast<char>(bodySize >> (8 * i));
+    }
+}
+
+void encodeDaemonRequest(const DaemonRequest& request, std::string& output)
+{
+    const size_t frameStart = output.size();
+    putUint32(output, 0);
+
+    putUint8(output, request.opcode);
+    putUint64(output, request.id);
+
+    if (request.opcode == DAEMON_OPCODE_HASH)
+    {
+        putUint8(output, request.parameters.type == Argon2_id ? 0 : request.parameters.type == Argon2_i ? 1 : 2);
+        putUint32(output, request.parameters.timeCost);
+        putUint32(output, request.parameters.memoryCostKiB);
+        putUint32(output, request.parameters.parallelism);
+        putUint32(output, request.parameters.hashLength);
+        putBytes(output, request.password);
+        putBytes(output, request.salt);
+    }
+    else
+    {
+        putBytes(output, request.encodedHash);
+        putBytes(output, request.password);
+    }
+
+    finishFrame(output, frameStart);
+}
+
+void encodeDaemonResponse(const DaemonResponse& response, std::string& output)
+{
+    const size_t frameStart = output.size();
+    putUint32(output, 0);
+
+    putUint64(output, response.id);
+    putUint32(output, static_cast<uint32_t>(response.error));
+    putBytes(output, response.encodedHash);
+
+    finishFrame(output, frameStart);
+}
+
+ptrdiff_t decodeDaemonRequest(const char* data, size_t size, DaemonRequest& request)
+{
+    ptrdiff_t frameSize;
+    FrameReader reader;
+
+    if (!beginFrame(data, size, frameSize, reader))
+    {
+        return frameSize;
+    }
+
+    request.opcode = reader.uint8();
+    request.id = reader.uint64();
+
+    switch (request.opcode)
+    {
+        case DAEMON_OPCODE_HASH: {
+            const uint8_t type = reader.uint8();
+
+            // The wire uses the same IDs as the GUI's algorithm radio buttons (0 = id, 1 = i, 2 = d).
+            if (type > 2)
+            {
+                return -1;
+            }
+
+            request.parameters.type = type == 0 ? Argon2_id : type == 1 ? Argon2_i : Argon2_d;
+            request.parameters.timeCost = reader.uint32();
+            request.parameters.memoryCostKiB = reader.uint32();
+            request.parameters.parallelism = reader.uint32();
+            request.parameters.hashLength = reader.uint32();
+            request.password = reader.bytes();
+            request.salt = reader.bytes();
+            break;
+        }
+        case DAEMON_OPCODE_VERIFY:
+            request.encodedHash = reader.bytes();
+            request.password = reader.bytes();
+            break;
+        default:
+            return -1;
+    }
+
+    return reader.ok && reader.position == reader.end ? frameSize : -1;
+}
+
+ptrdiff_t decodeDaemonResponse(const char* data, size_t size, DaemonResponse& response)
+{
+    ptrdiff_t frameSize;
+    FrameReader reader;
+
+    if (!beginFrame(data, size, frameSize, reader))
+    {
+        return frameSize;
+    }
+
+    response.id = reader.uint64();
+    response.error = static_cast<int32_t>(reader.uint32());
+    response.encodedHash = reader.bytes();
+
+    return reader.ok && reader.position == reader.end ? frameSize : -1;
+}
@@ -0,0 +1,55 @@
+#ifndef DAEMONPROTOCOL_H
+#define DAEMONPROTOCOL_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "argon2engine.h"
+
+// Wire format spoken over the hashing daemon's Unix domain socket.
+// Every message is a frame: a little-endian uint32 holding the size of the rest of the frame, followed by the body.
+// Integers are little-endian throughout and byte strings are prefixed with their uint32 length.
+//
+// Request body:  uint8 opcode, uint64 request ID, and then
+//   DAEMON_OPCODE_HASH:    uint8 type (0 = id, 1 = i, 2 = d), uint32 t, uint32 m (KiB), uint32 p, uint32 hash length, bytes password, bytes salt (empty = random)
+//   DAEMON_OPCODE_VERIFY:  bytes encoded hash, bytes password
+//
+// Response body: uint64 request ID, int32 Argon2 error code (ARGON2_OK, ARGON2_VERIFY_MISMATCH, ...), bytes encoded hash (empty for verifications and errors)
+//
+// Clients may send as many requests as they like without waiting for the responses (pipelining);
+// responses come back in completion order, so they need to be matched up by request ID.
+
+#define DAEMON_OPCODE_HASH 1
+#define DAEMON_OPCODE_VERIFY 2
+
+// Frames larger than this are a protocol violation (the daemon drops the connection).
+#define DAEMON_MAX_FRAME_SIZE (64 * 1024)
+
+struct DaemonRequest
+{
+    uint8_t opcode = DAEMON_OPCODE_HASH;
+    uint64_t id = 0;
+    Argon2Parameters parameters;
+    std::string password;
+    std::string salt;
+    std::string encodedHash;
+};
+
+struct DaemonResponse
+{
+    uint64_t id = 0;
+    int32_t error = 0;
+    std::string encodedHash;
+};
+
+// Append one complete frame to the output buffer.
+void encodeDaemonRequest(const DaemonRequest& request, std::string& output);
+void encodeDaemonResponse(const DaemonResponse& response, std::string& output);
+
+// Decode the frame at the start of the input buffer.
+// Returns the size of the frame (to be consumed by the caller) on success, 0 if the buffer doesn't contain a complete frame yet, or -1 if the frame is malformed.
+ptrdiff_t decodeDaemonRequest(const char* data, size_t size, DaemonRequest& request);
+ptrdiff_t decodeDaemonResponse(const char* data, size_t size, DaemonResponse& response);
+
+#endif // DAEMONPROTOCOL_H
@@ -0,0 +1,417 @@
+#include "hashdaemon.h"
+#include "daemonprotocol.h"
+
+#include <core.h>
+
+#include <cstdio>
+
+#ifdef _WIN32
+
+HashDaemon::HashDaemon(Argon2Engine& engine, const HashDaemonOptions& options)
+    : engine(engine)
+    , options(options)
+{
+}
+
+HashDaemon::~HashDaemon()
+{
+}
+
+int HashDaemon::run()
+{
+    fprintf(stderr, "The hashing daemon is only available on POSIX systems\n");
+    return 1;
+}
+
+void HashDaemon::stop()
+{
+}
+
+#else
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // SIGPIPE needs to be ignored by the caller on platforms without this flag.
+#endif
+
+struct DaemonConnection
+{
+    // Owned by the event loop thread.
+    int fd = -1;
+    bool readClosed = false;
+    std::string input;
+    std::string pendingOutput;
+
+    // Shared with the engine threads completing this connection's requests.
+    std::mutex mutex;
+    std::string output;
+    size_t inFlight = 0;
+};
+
+static bool setNonBlocking(int fd)
+{
+    const int flags = fcntl(fd, F_GETFL, 0);
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1 && fcntl(fd, F_SETFD, FD_CLOEXEC) != -1;
+}
+
+HashDaemon::HashDaemon(Argon2Engine& engine, const HashDaemonOptions& options)
+    : engine(engine)
+    , options(options)
+{
+    if (pipe(wakeFds) != 0 || !setNonBlocking(wakeFds[0]) || !setNonBlocking(wakeFds[1]))
+    {
+        fprintf(stderr, "Couldn't create the daemon's wake-up pipe: %s\n", strerror(errno));
+    }
+}
+
+HashDaemon::~HashDaemon()
+{
+    for (int fd : wakeFds)
+    {
+        if (fd != -1)
+        {
+            close(fd);
+        }
+    }
+}
+
+void HashDaemon::stop()
+{
+    stopRequested = true;
+
+    if (wakeFds[1] != -1)
+    {
+        const ssize_t r = write(wakeFds[1], "", 1);
+        (void)r; // If the pipe is full, the event loop is going to wake up anyway.
+    }
+}
+
+static int openListeningSocket(const std::string& path)
+{
+    sockaddr_un address;
+    memset(&address, 0x00, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "Invalid socket path \"%s\" (must be between 1 and %zu characters long)\n", path.c_str(), sizeof(address.sun_path) - 1);
+        return -1;
+    }
+
+    memcpy(address.sun_path, path.data(), path.size());
+
+    // Replace a stale socket left behind by a previous instance, but never anything that isn't a socket.
+    struct stat status;
+
+    if (lstat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+    {
+        unlink(path.c_str());
+    }
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd == -1)
+    {
+        fprintf(stderr, "Couldn't create the daemon socket: %s\n", strerror(errno));
+        return -1;
+    }
+
+    if (!setNonBlocking(fd) || bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        fprintf(stderr, "Couldn't listen on \"%s\": %s\n", path.c_str(), strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static void closeConnection(DaemonConnection& connection)
+{
+    if (connection.fd != -1)
+    {
+        close(connection.fd);
+        connection.fd = -1;
+    }
+
+    secure_wipe_memory(connection.input.data(), connection.input.size());
+    connection.input.clear();
+    connection.pendingOutput.clear();
+}
+
+int HashDaemon::run()
+{
+    if (wakeFds[0] == -1)
+    {
+        return 1;
+    }
+
+    int listenFd = openListeningSocket(options.socketPath);
+
+    if (listenFd == -1)
+    {
+        return 1;
+    }
+
+    fprintf(stderr, "Listening on %s (memory budget: %zu MiB, cores: %u)\n", options.socketPath.c_str(), engine.memoryBudget() / (1024 * 1024), engine.cores());
+
+    const int wakeFd = wakeFds[1];
+
+    // Completion callbacks run on the engine's threads: they queue the response on the connection and wake up the event loop.
+    // The in-flight counter is only decremented once the wake-up byte has been written, so that the loop
+    // (and with it the pipe) can never go away while a callback is still about to use it.
+    const auto respond = [wakeFd](const std::shared_ptr<DaemonConnection>& connection, const DaemonResponse& response) {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+
+        encodeDaemonResponse(response, connection->output);
+
+        const ssize_t r = write(wakeFd, "", 1);
+        (void)r;
+
+        --connection->inFlight;
+    };
+
+    // Decodes and submits as many buffered requests as the connection's in-flight limit allows.
+    // Returns false on a protocol violation.
+    const auto processInput = [&](const std::shared_ptr<DaemonConnection>& connection) {
+        size_t consumed = 0;
+        bool ok = true;
+
+        for (;;)
+        {
+            {
+                std::lock_guard<std::mutex> lock(connection->mutex);
+
+                if (connection->inFlight >= options.maxInFlightPerConnection)
+                {
+                    break;
+                }
+            }
+
+            DaemonRequest request;
+            const ptrdiff_t frameSize = decodeDaemonRequest(connection->input.data() + consumed, connection->input.size() - consumed, request);
+
+            if (frameSize <= 0)
+            {
+                ok = frameSize == 0;
+                break;
+            }
+
+            consumed += static_cast<size_t>(frameSize);
+
+            {
+                std::lock_guard<std::mutex> lock(connection->mutex);
+                ++connection->inFlight;
+            }
+
+            const uint64_t id = request.id;
+
+            if (request.opcode == DAEMON_OPCODE_HASH)
+            {
+                Argon2HashRequest hashRequest;
+                hashRequest.parameters = request.parameters;
+                hashRequest.password = std::move(request.password);
+                hashRequest.salt = std::move(request.salt);
+
+                engine.hash(std::move(hashRequest), nullptr, [respond, connection, id](const Argon2HashResult& result) {
+                    respond(connection, DaemonResponse { id, result.error, result.encodedHash });
+                });
+            }
+            else
+            {
+                engine.verify(std::move(request.encodedHash), std::move(request.password), nullptr, [respond, connection, id](int result) {
+                    respond(connection, DaemonResponse { id, result, std::string() });
+                });
+            }
+        }
+
+        // The consumed frames contained passwords: don't leave them lying around in the buffer's spare capacity.
+        secure_wipe_memory(connection->input.data(), consumed);
+        connection->input.erase(0, consumed);
+
+        return ok;
+    };
+
+    std::vector<std::shared_ptr<DaemonConnection>> connections;
+    std::vector<pollfd> pollFds;
+
+    char buffer[64 * 1024];
+
+    for (;;)
+    {
+        const bool stopping = stopRequested;
+
+        if (stopping && listenFd != -1)
+        {
+            close(listenFd);
+            unlink(options.socketPath.c_str());
+            listenFd = -1;
+        }
+
+        pollFds.clear();
+        pollFds.push_back(pollfd { wakeFds[0], POLLIN, 0 });
+        pollFds.push_back(pollfd { listenFd, POLLIN, 0 });
+
+        for (size_t i = 0; i < connections.size();)
+        {
+            DaemonConnection& connection = *connections[i];
+
+            // Requests held back by the in-flight limit might fit now.
+            if (connection.fd != -1 && !stopping && !processInput(connections[i]))
+            {
+                fprintf(stderr, "Malformed request frame: dropping the connection\n");
+                closeConnection(connection);
+            }
+
+            size_t inFlight;
+            {
+                std::lock_guard<std::mutex> lock(connection.mutex);
+
+                if (connection.fd != -1)
+                {
+                    connection.pendingOutput.append(connection.output);
+                }
+
+                connection.output.clear();
+                inFlight = connection.inFlight;
+            }
+
+            const bool done = connection.fd == -1 || ((connection.readClosed || stopping) && connection.pendingOutput.empty());
+
+            if (done && inFlight == 0)
+            {
+                closeConnection(connection);
+                connections.erase(connections.begin() + static_cast<ptrdiff_t>(i));
+                continue;
+            }
+
+            short events = 0;
+
+            if (connection.fd != -1 && !connection.pendingOutput.empty())
+            {
+                events |= POLLOUT;
+            }
+
+            if (connection.fd != -1 && !stopping && !connection.readClosed && inFlight < options.maxInFlightPerConnection)
+            {
+                events |= POLLIN;
+            }
+
+            // Nothing to wait for on the socket (e.g. a client that hung up while its requests are still running): poll() would report
+            // its POLLHUP over and over again, so it's left out (a negative descriptor is ignored) until there's output to send.
+            pollFds.push_back(pollfd { events != 0 ? connection.fd : -1, events, 0 });
+            ++i;
+        }
+
+        if (stopping && connections.empty())
+        {
+            break;
+        }
+
+        if (poll(pollFds.data(), static_cast<nfds_t>(pollFds.size()), -1) < 0 && errno != EINTR)
+        {
+            fprintf(stderr, "poll() failed: %s\n", strerror(errno));
+            break;
+        }
+
+        if (pollFds[0].revents & POLLIN)
+        {
+            while (read(wakeFds[0], buffer, sizeof(buffer)) > 0)
+            {
+            }
+        }
+
+        for (size_t i = 0; i < connections.size(); ++i)
+        {
+            const std::shared_ptr<DaemonConnection>& connection = connections[i];
+            const short revents = pollFds[i + 2].revents;
+
+            if (connection->fd == -1 || revents == 0)
+            {
+                continue;
+            }
+
+            if (revents & POLLOUT)
+            {
+                const ssize_t n = send(connection->fd, connection->pendingOutput.data(), connection->pendingOutput.size(), MSG_NOSIGNAL);
+
+                if (n > 0)
+                {
+                    connection->pendingOutput.erase(0, static_cast<size_t>(n));
+                }
+                else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                {
+                    closeConnection(*connection);
+                    continue;
+                }
+            }
+
+            if (!connection->readClosed && (revents & (POLLIN | POLLHUP | POLLERR)))
+            {
+                const ssize_t n = recv(connection->fd, buffer, sizeof(buffer), 0);
+
+                if (n > 0)
+                {
+                    connection->input.append(buffer, static_cast<size_t>(n));
+                    secure_wipe_memory(buffer, static_cast<size_t>(n));
+                }
+                else if (n == 0)
+                {
+                    connection->readClosed = true;
+                }
+                else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                {
+                    closeConnection(*connection);
+                    continue;
+                }
+            }
+        }
+
+        if (listenFd != -1 && (pollFds[1].revents & POLLIN))
+        {
+            for (;;)
+            {
+                const int fd = accept(listenFd, nullptr, nullptr);
+
+                if (fd == -1)
+                {
+                    break;
+                }
+
+                if (!setNonBlocking(fd))
+                {
+                    close(fd);
+                    continue;
+                }
+
+                std::shared_ptr<DaemonConnection> connection = std::make_shared<DaemonConnection>();
+                connection->fd = fd;
+                connections.push_back(std::move(connection));
+            }
+        }
+    }
+
+    if (listenFd != -1)
+    {
+        close(listenFd);
+        unlink(options.socketPath.c_str());
+    }
+
+    return 0;
+}
+
+#endif // _WIN32
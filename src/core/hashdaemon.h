@@ -0,0 +1,51 @@
+#ifndef HASHDAEMON_H
+#define HASHDAEMON_H
+
+#include <atomic>
+#include <string>
+#include <cstddef>
+
+#include "argon2engine.h"
+
+struct HashDaemonOptions
+{
+    // Filesystem path of the Unix domain socket to listen on (an existing socket file at that path is replaced).
+    std::string socketPath;
+
+    // Maximum number of requests a single connection may have in flight: once reached, the daemon stops reading
+    // from that connection until some of its responses have been sent (the client's writes then block, which is the backpressure).
+    size_t maxInFlightPerConnection = 256;
+};
+
+// Serves hash and verify requests (see daemonprotocol.h) over a Unix domain socket.
+// Every connection can pipeline any number of requests; all of them run on the shared engine, and responses are sent back as soon as they're done.
+// Only available on POSIX systems.
+class HashDaemon
+{
+public:
+    HashDaemon(Argon2Engine& engine, const HashDaemonOptions& options);
+    ~HashDaemon();
+
+    HashDaemon(const HashDaemon&) = delete;
+    HashDaemon& operator=(const HashDaemon&) = delete;
+
+    // Listens and serves requests until stop() is called. After that, no new connections or requests are accepted,
+    // but the requests already in flight are still completed and answered before this returns.
+    // Returns 0 on a clean shutdown, or 1 if the socket couldn't be set up (the reason is printed to stderr).
+    int run();
+
+    // Async-signal-safe: may be called from a signal handler or any thread.
+    void stop();
+
+private:
+    Argon2Engine& engine;
+    HashDaemonOptions options;
+
+    // Set by stop(), which needs to be async-signal-safe (hence no mutex, just a lock-free atomic and the self-pipe).
+    std::atomic<bool> stopRequested { false };
+
+    // Self-pipe used to wake up the event loop (on completed requests and on stop()).
+    int wakeFds[2] = { -1, -1 };
+};
+
+#endif // HASHDAEMON_H
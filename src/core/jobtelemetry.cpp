@@ -0,0 +1,276 @@
+#include "jobtelemetry.h"
+#include "argon2progress.h"
+#include "argon2kernels.h"
+#include "lanepool.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdarg>
+#include <algorithm>
+
+// Number of measured jobs running right now.
+static std::atomic<unsigned int> runningJobs { 0 };
+
+static void appendFormat(std::string& text, const char* format, ...)
+{
+    char buffer[512];
+
+    va_list arguments;
+    va_start(arguments, format);
+    const int length = vsnprintf(buffer, sizeof(buffer), format, arguments);
+    va_end(arguments);
+
+    if (length > 0)
+    {
+        text.append(buffer, std::min<size_t>(static_cast<size_t>(length), sizeof(buffer) - 1));
+    }
+}
+
+static const char* resultLabel(int error)
+{
+    switch (error)
+    {
+        case ARGON2_OK:
+            return "ok";
+        case ARGON2_VERIFY_MISMATCH:
+            return "mismatch";
+        case ARGON2_ABORTED:
+            return "cancelled";
+        default:
+            return "error";
+    }
+}
+
+Argon2JobMeter::Argon2JobMeter(const char* operation, const Argon2Parameters& parameters, unsigned int threads)
+{
+    telemetry.operation = operation;
+    telemetry.parameters = parameters;
+    telemetry.threads = threads;
+}
+
+void Argon2JobMeter::start()
+{
+    const LanePoolOptions lanes = LanePool::shared().configuration();
+
+    telemetry.kernel = argon2_active_kernel();
+    telemetry.pinnedThreads = lanes.pinThreads;
+    telemetry.numaAware = lanes.numaAware;
+    telemetry.concurrentJobs = runningJobs.fetch_add(1);
+
+    // Resetting the peak while other jobs run would hide theirs: then this job's peak delta can include an earlier one.
+    if (telemetry.concurrentJobs == 0)
+    {
+        resetPeakResidentBytes();
+    }
+
+    started = true;
+    startUsage = resourceUsage();
+    startTime = std::chrono::steady_clock::now();
+}
+
+Argon2JobTelemetry Argon2JobMeter::finish(int error)
+{
+    telemetry.error = error;
+    telemetry.finishedAt = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    if (!started)
+    {
+        telemetry.kernel = argon2_active_kernel();
+        return telemetry;
+    }
+
+    telemetry.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    const ResourceUsage usage = resourceUsage();
+
+    runningJobs.fetch_sub(1);
+    started = false;
+
+    telemetry.cpuSeconds = std::max(usage.cpuSeconds - startUsage.cpuSeconds, 0.0);
+    telemetry.peakRssDeltaBytes = usage.peakResidentBytes > startUsage.residentBytes ? usage.peakResidentBytes - startUsage.residentBytes : 0;
+    telemetry.minorFaults = usage.minorFaults - startUsage.minorFaults;
+    telemetry.majorFaults = usage.majorFaults - startUsage.majorFaults;
+    telemetry.voluntaryContextSwitches = usage.voluntaryContextSwitches - startUsage.voluntaryContextSwitches;
+    telemetry.involuntaryContextSwitches = usage.involuntaryContextSwitches - startUsage.involuntaryContextSwitches;
+
+    return telemetry;
+}
+
+Argon2TelemetryLog::Argon2TelemetryLog(size_t capacity)
+    : capacity(std::max<size_t>(capacity, 1))
+{
+}
+
+const std::vector<double>& Argon2TelemetryLog::bucketBounds()
+{
+    static const std::vector<double> bounds { 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0, 60.0 };
+    return bounds;
+}
+
+static size_t bucketIndex(double seconds)
+{
+    const std::vector<double>& bounds = Argon2TelemetryLog::bucketBounds();
+    return static_cast<size_t>(std::lower_bound(bounds.begin(), bounds.end(), seconds) - bounds.begin());
+}
+
+void Argon2TelemetryLog::record(const Argon2JobTelemetry& telemetry)
+{
+    if (jobs.size() == capacity)
+    {
+        jobs.pop_front();
+    }
+
+    jobs.push_back(telemetry);
+
+    Totals& total = totals[std::make_pair(std::string(telemetry.operation), telemetry.kernel)];
+
+    ++total.results[resultLabel(telemetry.error)];
+
+    // The resource counters and the histogram only cover the jobs that actually ran.
+    if (telemetry.wallSeconds <= 0.0)
+    {
+        return;
+    }
+
+    if (total.buckets.empty())
+    {
+        total.buckets.resize(bucketBounds().size() + 1);
+    }
+
+    ++total.buckets[bucketIndex(telemetry.wallSeconds)];
+    ++total.count;
+
+    total.wallSeconds += telemetry.wallSeconds;
+    total.cpuSeconds += telemetry.cpuSeconds;
+    total.lastPeakRssDeltaBytes = telemetry.peakRssDeltaBytes;
+    total.minorFaults += telemetry.minorFaults;
+    total.majorFaults += telemetry.majorFaults;
+    total.voluntaryContextSwitches += telemetry.voluntaryContextSwitches;
+    total.involuntaryContextSwitches += telemetry.involuntaryContextSwitches;
+}
+
+std::vector<size_t> Argon2TelemetryLog::recentHistogram() const
+{
+    std::vector<size_t> histogram(bucketBounds().size() + 1);
+
+    for (const Argon2JobTelemetry& telemetry : jobs)
+    {
+        if (telemetry.wallSeconds > 0.0)
+        {
+            ++histogram[bucketIndex(telemetry.wallSeconds)];
+        }
+    }
+
+    return histogram;
+}
+
+std::string Argon2TelemetryLog::prometheus() const
+{
+    std::string text;
+
+    appendFormat(text, "# HELP argon2gui_jobs_total Hash and verify jobs by result (ok, mismatch, cancelled or error).\n# TYPE argon2gui_jobs_total counter\n");
+
+    for (const auto& [key, total] : totals)
+    {
+        for (const auto& [result, count] : total.results)
+        {
+            appendFormat(text, "argon2gui_jobs_total{operation=\"%s\",kernel=\"%s\",result=\"%s\"} %llu\n", key.first.c_str(), key.second.c_str(), result.c_str(), static_cast<unsigned long long>(count));
+        }
+    }
+
+    appendFormat(text, "# HELP argon2gui_job_duration_seconds Wall time of the jobs that ran.\n# TYPE argon2gui_job_duration_seconds histogram\n");
+
+    for (const auto& [key, total] : totals)
+    {
+        if (total.count == 0)
+        {
+            continue;
+        }
+
+        uint64_t cumulative = 0;
+
+        for (size_t i = 0; i < bucketBounds().size(); ++i)
+        {
+            cumulative += total.buckets[i];
+            appendFormat(text, "argon2gui_job_duration_seconds_bucket{operation=\"%s\",kernel=\"%s\",le=\"%g\"} %llu\n", key.first.c_str(), key.second.c_str(), bucketBounds()[i], static_cast<unsigned long long>(cumulative));
+        }
+
+        appendFormat(text, "argon2gui_job_duration_seconds_bucket{operation=\"%s\",kernel=\"%s\",le=\"+Inf\"} %llu\n", key.first.c_str(), key.second.c_str(), static_cast<unsigned long long>(total.count));
+        appendFormat(text, "argon2gui_job_duration_seconds_sum{operation=\"%s\",kernel=\"%s\"} %.9g\n", key.first.c_str(), key.second.c_str(), total.wallSeconds);
+        appendFormat(text, "argon2gui_job_duration_seconds_count{operation=\"%s\",kernel=\"%s\"} %llu\n", key.first.c_str(), key.second.c_str(), static_cast<unsigned long long>(total.count));
+    }
+
+    appendFormat(text, "# HELP argon2gui_job_cpu_seconds_total CPU time (user and system, all threads) the process spent while jobs ran.\n# TYPE argon2gui_job_cpu_seconds_total counter\n");
+
+    for (const auto& [key, total] : totals)
+    {
+        if (total.count != 0)
+        {
+            appendFormat(text, "argon2gui_job_cpu_seconds_total{operation=\"%s\",kernel=\"%s\"} %.9g\n", key.first.c_str(), key.second.c_str(), total.cpuSeconds);
+        }
+    }
+
+    appendFormat(text, "# HELP argon2gui_job_page_faults_total Page faults of the process while jobs ran.\n# TYPE argon2gui_job_page_faults_total counter\n");
+
+    for (const auto& [key, total] : totals)
+    {
+        if (total.count != 0)
+        {
+            appendFormat(text, "argon2gui_job_page_faults_total{operation=\"%s\",kernel=\"%s\",type=\"minor\"} %llu\n", key.first.c_str(), key.second.c_str(), static_cast<unsigned long long>(total.minorFaults));
+            appendFormat(text, "argon2gui_job_page_faults_total{operation=\"%s\",kernel=\"%s\",type=\"major\"} %llu\n", key.first.c_str(), key.second.c_str(), static_cast<unsigned long long>(total.majorFaults));
+        }
+    }
+
+    appendFormat(text, "# HELP argon2gui_job_context_switches_total Context switches of the process while jobs ran.\n# TYPE argon2gui_job_context_switches_total counter\n");
+
+    for (const auto& [key, total] : totals)
+    {
+        if (total.count != 0)
+        {
+            appendFormat(text, "argon2gui_job_context_switches_total{operation=\"%s\",kernel=\"%s\",type=\"voluntary\"} %llu\n", key.first.c_str(), key.second.c_str(), static_cast<unsigned long long>(total.voluntaryContextSwitches));
+            appendFormat(text, "argon2gui_job_context_switches_total{operation=\"%s\",kernel=\"%s\",type=\"involuntary\"} %llu\n", key.first.c_str(), key.second.c_str(), static_cast<unsigned long long>(total.involuntaryContextSwitches));
+        }
+    }
+
+    appendFormat(text, "# HELP argon2gui_job_peak_rss_delta_bytes How far the last job that ran raised the peak resident set size.\n# TYPE argon2gui_job_peak_rss_delta_bytes gauge\n");
+
+    for (const auto& [key, total] : totals)
+    {
+        if (total.count != 0)
+        {
+            appendFormat(text, "argon2gui_job_peak_rss_delta_bytes{operation=\"%s\",kernel=\"%s\"} %llu\n", key.first.c_str(), key.second.c_str(), static_cast<unsigned long long>(total.lastPeakRssDeltaBytes));
+        }
+    }
+
+    return text;
+}
+
+std::string Argon2TelemetryLog::jsonLine(const Argon2JobTelemetry& telemetry)
+{
+    std::string line;
+
+    appendFormat(line, "{ \"finished_at\": %.3f, \"operation\": \"%s\", \"result\": \"%s\", \"error\": %d, \"variant\": \"%s\", \"t\": %u, \"m_kib\": %u, \"p\": %u, \"hash_length\": %u, ",
+        telemetry.finishedAt, telemetry.operation, resultLabel(telemetry.error), telemetry.error, argon2_type2string(telemetry.parameters.type, 1),
+        telemetry.parameters.timeCost, telemetry.parameters.memoryCostKiB, telemetry.parameters.parallelism, telemetry.parameters.hashLength);
+
+    appendFormat(line, "\"kernel\": \"%s\", \"threads\": %u, \"pinned_threads\": %s, \"numa_aware\": %s, \"concurrent_jobs\": %u, \"wall_s\": %.6f, \"cpu_s\": %.6f, \"peak_rss_delta_bytes\": %llu, ",
+        telemetry.kernel.c_str(), telemetry.threads, telemetry.pinnedThreads ? "true" : "false", telemetry.numaAware ? "true" : "false", telemetry.concurrentJobs, telemetry.wallSeconds, telemetry.cpuSeconds, static_cast<unsigned long long>(telemetry.peakRssDeltaBytes));
+
+    appendFormat(line, "\"minor_faults\": %llu, \"major_faults\": %llu, \"voluntary_context_switches\": %llu, \"involuntary_context_switches\": %llu }\n",
+        static_cast<unsigned long long>(telemetry.minorFaults), static_cast<unsigned long long>(telemetry.majorFaults),
+        static_cast<unsigned long long>(telemetry.voluntaryContextSwitches), static_cast<unsigned long long>(telemetry.involuntaryContextSwitches));
+
+    return line;
+}
+
+std::string Argon2TelemetryLog::jsonLines() const
+{
+    std::string lines;
+
+    for (const Argon2JobTelemetry& telemetry : jobs)
+    {
+        lines += jsonLine(telemetry);
+    }
+
+    return lines;
+}
@@ -0,0 +1,121 @@
+#ifndef JOBTELEMETRY_H
+#define JOBTELEMETRY_H
+
+#include <map>
+#include <deque>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "argon2engine.h"
+#include "systemresources.h"
+
+// What a single hash or verify job cost, as measured by an Argon2JobMeter.
+// The resource counters are process-wide: those of the jobs that ran at the same time (see concurrentJobs) are included.
+struct Argon2JobTelemetry
+{
+    // "hash" or "verify".
+    const char* operation = "hash";
+    int error = ARGON2_OK;
+
+    // When the job finished, in seconds since the Unix epoch.
+    double finishedAt = 0.0;
+
+    Argon2Parameters parameters;
+    std::string kernel;
+    unsigned int threads = 1;
+
+    // The lane pool's thread placement (see LanePoolOptions).
+    bool pinnedThreads = false;
+    bool numaAware = false;
+
+    // Number of other measured jobs that were running when this one started.
+    unsigned int concurrentJobs = 0;
+
+    // Everything below stays 0 for jobs that never started (rejected, or cancelled while still queued).
+    double wallSeconds = 0.0;
+    double cpuSeconds = 0.0;
+
+    // How far the peak resident set size rose above the resident set size at the job's start
+    // (so a matrix that the arena pool had kept from an earlier job doesn't count again).
+    uint64_t peakRssDeltaBytes = 0;
+
+    uint64_t minorFaults = 0;
+    uint64_t majorFaults = 0;
+    uint64_t voluntaryContextSwitches = 0;
+    uint64_t involuntaryContextSwitches = 0;
+};
+
+// Measures one job from its engine callbacks, which run on the worker thread that runs the job:
+// start() from the progress callback's first invocation (right before the job starts), finish() from the finished callback.
+class Argon2JobMeter
+{
+public:
+    Argon2JobMeter(const char* operation, const Argon2Parameters& parameters, unsigned int threads);
+
+    void start();
+
+    // Also fine to call without start(), for jobs that never ran.
+    Argon2JobTelemetry finish(int error);
+
+private:
+    Argon2JobTelemetry telemetry;
+    ResourceUsage startUsage;
+    std::chrono::steady_clock::time_point startTime;
+    bool started = false;
+};
+
+// The telemetry of every measured job: the most recent ones, for a rolling view, and totals per operation and kernel since the start,
+// for Prometheus (whose counters must never go down). Not thread-safe: meant to be fed from a single thread (e.g. the GUI's).
+class Argon2TelemetryLog
+{
+public:
+    explicit Argon2TelemetryLog(size_t capacity = 1000);
+
+    // Upper bounds (in seconds) of the wall time histogram's buckets: 5 ms to a minute, plus an implicit +Inf one.
+    static const std::vector<double>& bucketBounds();
+
+    void record(const Argon2JobTelemetry& telemetry);
+
+    const std::deque<Argon2JobTelemetry>& recent() const
+    {
+        return jobs;
+    }
+
+    // Wall times of the recent jobs that ran, per bucket (not cumulative), with the last element counting those beyond the last bound.
+    std::vector<size_t> recentHistogram() const;
+
+    // Totals in the Prometheus text exposition format (0.0.4), all metrics prefixed with "argon2gui_".
+    std::string prometheus() const;
+
+    // The recent jobs, one JSON object per line, oldest first.
+    std::string jsonLines() const;
+
+    static std::string jsonLine(const Argon2JobTelemetry& telemetry);
+
+private:
+    struct Totals
+    {
+        std::vector<uint64_t> buckets;
+        std::map<std::string, uint64_t> results;
+        uint64_t count = 0;
+        double wallSeconds = 0.0;
+        double cpuSeconds = 0.0;
+        uint64_t lastPeakRssDeltaBytes = 0;
+        uint64_t minorFaults = 0;
+        uint64_t majorFaults = 0;
+        uint64_t voluntaryContextSwitches = 0;
+        uint64_t involuntaryContextSwitches = 0;
+    };
+
+    size_t capacity;
+    std::deque<Argon2JobTelemetry> jobs;
+
+    // Keyed by operation and kernel.
+    std::map<std::pair<std::string, std::string>, Totals> totals;
+};
+
+#endif // JOBTELEMETRY_H
@@ -0,0 +1,303 @@
+#include "lanepool.h"
+#include "systemresources.h"
+
+#include <barrier>
+#include <algorithm>
+
+#if defined(_WIN32)
+#define WIN32_NO_STATUS
+#include <windows.h>
+#undef WIN32_NO_STATUS
+#elif defined(__linux__)
+#include <sched.h>
+#include <pthread.h>
+#endif
+
+struct LaneTeamState
+{
+    explicit LaneTeamState(uint32_t members)
+        : start(members)
+        , end(members)
+    {
+    }
+
+    // Every slice is one start phase and one end phase. A null body at the start barrier disbands the team.
+    std::barrier<> start;
+    std::barrier<> end;
+    const std::function<void(uint32_t thread)>* body = nullptr;
+
+    // The CPUs the calling thread (member 0) ran on before the team bound it to a node, if it did.
+    std::vector<unsigned int> callerCpus;
+};
+
+// Returns the CPUs the thread was allowed to run on before (none if that can't be told).
+static std::vector<unsigned int> bindCurrentThread(const std::vector<unsigned int>& cpus)
+{
+    std::vector<unsigned int> previous;
+
+#if defined(_WIN32)
+    DWORD_PTR mask = 0;
+
+    for (unsigned int cpu : cpus)
+    {
+        mask |= static_cast<DWORD_PTR>(1) << (cpu % (sizeof(DWORD_PTR) * 8));
+    }
+
+    const DWORD_PTR previousMask = SetThreadAffinityMask(GetCurrentThread(), mask);
+
+    for (unsigned int cpu = 0; cpu < sizeof(DWORD_PTR) * 8; ++cpu)
+    {
+        if (previousMask & (static_cast<DWORD_PTR>(1) << cpu))
+        {
+            previous.push_back(cpu);
+        }
+    }
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+    {
+        for (unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+            {
+                previous.push_back(cpu);
+            }
+        }
+    }
+
+    CPU_ZERO(&set);
+
+    for (unsigned int cpu : cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    // macOS has no thread to core pinning (only affinity tags, which are mere hints).
+    (void)cpus;
+#endif
+
+    return previous;
+}
+
+LanePool& LanePool::shared()
+{
+    static LanePool pool;
+    return pool;
+}
+
+LanePool::LanePool()
+    : nodes(numaNodes())
+{
+}
+
+LanePool::~LanePool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    for (const std::unique_ptr<Worker>& worker : workers)
+    {
+        worker->assigned.notify_one();
+    }
+
+    for (const std::unique_ptr<Worker>& worker : workers)
+    {
+        worker->thread.join();
+    }
+}
+
+void LanePool::configure(const LanePoolOptions& newOptions)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    options = newOptions;
+    ++placementGeneration;
+}
+
+LanePoolOptions LanePool::configuration()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return options;
+}
+
+size_t LanePool::size()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return workers.size();
+}
+
+std::vector<unsigned int> LanePool::recruit(const std::shared_ptr<LaneTeamState>& team, uint32_t count)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Under NUMA placement, member i of a team goes to node (firstNode + i) % nodes.size(), member 0 included.
+    // Every team starts one node further than the previous one, so that concurrent small teams don't all crowd the same nodes.
+    const bool spread = options.numaAware && nodes.size() > 1;
+    const size_t firstNode = spread ? nextTeamNode++ % nodes.size() : 0;
+
+    // Members are only assigned once all of them are found, so that a worker that can't be created leaves none waiting for a team that never runs.
+    std::vector<Worker*> members;
+
+    try
+    {
+        for (uint32_t i = 1; i <= count; ++i)
+        {
+            // The newest idle worker, or (under NUMA placement) the newest one on the member's node.
+            size_t found = idle.size();
+
+            for (;;)
+            {
+                for (size_t j = idle.size(); j > 0 && found == idle.size(); --j)
+                {
+                    if (!spread || idle[j - 1]->number % nodes.size() == (firstNode + i) % nodes.size())
+                    {
+                        found = j - 1;
+                    }
+                }
+
+                if (found != idle.size())
+                {
+                    break;
+                }
+
+                // The first worker goes to the second core (or NUMA node): the first one is left to the threads that call into the pool.
+                // (Workers created for another node than the wanted one stay idle, for the next teams.)
+                std::unique_ptr<Worker> worker = std::make_unique<Worker>();
+                worker->number = static_cast<unsigned int>(workers.size() + 1);
+                worker->thread = std::thread(&LanePool::work, this, worker.get());
+
+                idle.push_back(worker.get());
+                workers.push_back(std::move(worker));
+                found = idle.size();
+            }
+
+            members.push_back(idle[found]);
+            idle.erase(idle.begin() + static_cast<std::ptrdiff_t>(found));
+        }
+    }
+    catch (...)
+    {
+        idle.insert(idle.end(), members.begin(), members.end());
+        throw;
+    }
+
+    for (uint32_t i = 1; i <= count; ++i)
+    {
+        Worker* worker = members[i - 1];
+
+        worker->team = team;
+        worker->index = i;
+        worker->assigned.notify_one();
+    }
+
+    return spread ? nodes[firstNode] : std::vector<unsigned int>();
+}
+
+void LanePool::work(Worker* worker)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for (;;)
+    {
+        worker->assigned.wait(lock, [this, worker] { return stopping || worker->team != nullptr; });
+
+        if (worker->team == nullptr)
+        {
+            return;
+        }
+
+        if (worker->placement != placementGeneration)
+        {
+            bindCurrentThread(placement(worker->number));
+            worker->placement = placementGeneration;
+        }
+
+        // Holding its own reference, so that the team's barriers outlive this worker's last use of them.
+        const std::shared_ptr<LaneTeamState> team = worker->team;
+        const uint32_t index = worker->index;
+
+        lock.unlock();
+
+        for (;;)
+        {
+            team->start.arrive_and_wait();
+
+            if (team->body == nullptr)
+            {
+                break;
+            }
+
+            (*team->body)(index);
+
+            team->end.arrive_and_wait();
+        }
+
+        lock.lock();
+
+        worker->team = nullptr;
+        idle.push_back(worker);
+    }
+}
+
+std::vector<unsigned int> LanePool::placement(unsigned int number) const
+{
+    if (options.numaAware && nodes.size() > 1)
+    {
+        const std::vector<unsigned int>& node = nodes[number % nodes.size()];
+        return options.pinThreads ? std::vector<unsigned int> { node[number / nodes.size() % node.size()] } : node;
+    }
+
+    std::vector<unsigned int> cpus;
+
+    for (const std::vector<unsigned int>& node : nodes)
+    {
+        cpus.insert(cpus.end(), node.begin(), node.end());
+    }
+
+    // Unpinned workers may run on any CPU: that also undoes a previous configuration's pinning.
+    return options.pinThreads ? std::vector<unsigned int> { cpus[number % cpus.size()] } : cpus;
+}
+
+LaneTeam::LaneTeam(uint32_t threads)
+    : state(std::make_shared<LaneTeamState>(std::max(threads, 1u)))
+{
+    if (threads > 1)
+    {
+        const std::vector<unsigned int> node = LanePool::shared().recruit(state, threads - 1);
+
+        if (!node.empty())
+        {
+            state->callerCpus = bindCurrentThread(node);
+        }
+    }
+}
+
+LaneTeam::~LaneTeam()
+{
+    state->body = nullptr;
+    state->start.arrive_and_wait();
+
+    if (!state->callerCpus.empty())
+    {
+        bindCurrentThread(state->callerCpus);
+    }
+}
+
+void LaneTeam::run(const std::function<void(uint32_t thread)>& body)
+{
+    // The barrier's phase completion orders this write before the workers' reads.
+    state->body = &body;
+    state->start.arrive_and_wait();
+
+    body(0);
+
+    state->end.arrive_and_wait();
+}
@@ -0,0 +1,108 @@
+#ifndef LANEPOOL_H
+#define LANEPOOL_H
+
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+struct LanePoolOptions
+{
+    // Pin every worker thread to its own CPU core (round-robin, in creation order), so that lanes don't migrate between cores mid-hash.
+    bool pinThreads = false;
+
+    // Spread the worker threads across the NUMA nodes (round-robin, in creation order) and keep each of them on the CPUs of its node
+    // (on a single one of them if pinThreads is set as well). Teams are then recruited round-robin by node, and the calling thread
+    // (member 0) is bound to its node for as long as its team exists. Since every lane is filled by the same team member for the whole hash,
+    // first blocks included, and since large matrices are faulted in by whichever thread first touches them, each lane's memory then ends
+    // up on the node of the thread that fills it. Matrices smaller than ArenaPoolOptions::firstTouchBytes are still faulted in (and reused)
+    // by the arena pool, wherever the allocating thread runs: lower that threshold to place them as well. No effect on machines with a single NUMA node.
+    bool numaAware = false;
+};
+
+struct LaneTeamState;
+
+// Process-wide pool of persistent worker threads that fill the lanes of multi-threaded hashes.
+// The library's fill_memory_blocks_mt creates and joins one OS thread per lane for every slice of every pass;
+// here, a hash borrows its workers once (see LaneTeam), synchronizes them with barriers at every slice and hands them back when done.
+// The pool grows on demand (the engine's scheduler is what bounds the number of threads running at once) and never shrinks.
+class LanePool
+{
+public:
+    static LanePool& shared();
+
+    LanePool(const LanePool&) = delete;
+    LanePool& operator=(const LanePool&) = delete;
+
+    // Idle workers apply the new placement before they join their next team.
+    void configure(const LanePoolOptions& options);
+
+    LanePoolOptions configuration();
+
+    // Number of worker threads created so far.
+    size_t size();
+
+private:
+    friend class LaneTeam;
+
+    struct Worker
+    {
+        std::thread thread;
+        std::condition_variable assigned;
+        std::shared_ptr<LaneTeamState> team;
+        uint32_t index = 0;
+
+        // 1 for the first worker created, 2 for the second one, and so on.
+        unsigned int number = 0;
+
+        // The placementGeneration this worker last applied.
+        uint64_t placement = 0;
+    };
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<Worker*> idle;
+    bool stopping = false;
+
+    LanePoolOptions options;
+    uint64_t placementGeneration = 0;
+    size_t nextTeamNode = 0;
+    const std::vector<std::vector<unsigned int>> nodes;
+
+    LanePool();
+    ~LanePool();
+
+    // Returns the CPUs of the node the calling thread is to run on as the team's member 0 (none without NUMA placement).
+    // Throws std::system_error if a new worker thread can't be created.
+    std::vector<unsigned int> recruit(const std::shared_ptr<LaneTeamState>& team, uint32_t count);
+    void work(Worker* worker);
+
+    // The CPUs the passed worker may run on under the current options.
+    std::vector<unsigned int> placement(unsigned int number) const;
+};
+
+// A group of threads (the calling one included) that fill the slices of one hash together.
+class LaneTeam
+{
+public:
+    // Borrows threads - 1 workers from the shared pool. Throws std::system_error if new worker threads are needed but can't be created.
+    explicit LaneTeam(uint32_t threads);
+
+    // Hands the workers back to the pool (and the calling thread its previous CPUs).
+    ~LaneTeam();
+
+    LaneTeam(const LaneTeam&) = delete;
+    LaneTeam& operator=(const LaneTeam&) = delete;
+
+    // Runs body(thread) on every member of the team at once, the calling thread being thread 0,
+    // and returns once all of them are done (the barrier at the end of a slice).
+    void run(const std::function<void(uint32_t thread)>& body);
+
+private:
+    std::shared_ptr<LaneTeamState> state;
+};
+
+#endif // LANEPOOL_H
@@ -0,0 +1,141 @@
+#include "mappedfile.h"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#define WIN32_NO_STATUS
+#include <windows.h>
+#undef WIN32_NO_STATUS
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const char* path)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "Couldn't open \"%s\" (error %lu)\n", path, GetLastError());
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        fprintf(stderr, "Couldn't determine the size of \"%s\" (error %lu)\n", path, GetLastError());
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    length = static_cast<size_t>(fileSize.QuadPart);
+
+    if (length == 0)
+    {
+        return true;
+    }
+
+    mappingHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    if (mappingHandle == NULL)
+    {
+        fprintf(stderr, "Couldn't map \"%s\" into memory (error %lu)\n", path, GetLastError());
+        close();
+        return false;
+    }
+
+    mapping = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+#else
+    const int fd = ::open(path, O_RDONLY);
+
+    if (fd == -1)
+    {
+        perror(path);
+        return false;
+    }
+
+    struct stat fileStatus;
+
+    if (fstat(fd, &fileStatus) != 0)
+    {
+        perror(path);
+        ::close(fd);
+        return false;
+    }
+
+    length = static_cast<size_t>(fileStatus.st_size);
+
+    if (length == 0)
+    {
+        ::close(fd);
+        return true;
+    }
+
+    void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (address == MAP_FAILED)
+    {
+        perror(path);
+        length = 0;
+        return false;
+    }
+
+    madvise(address, length, MADV_WILLNEED);
+
+    mapping = static_cast<const char*>(address);
+#endif
+
+    if (mapping == nullptr)
+    {
+        fprintf(stderr, "Couldn't map \"%s\" into memory\n", path);
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (mapping != nullptr)
+    {
+        UnmapViewOfFile(mapping);
+    }
+
+    if (mappingHandle != nullptr)
+    {
+        CloseHandle(mappingHandle);
+    }
+
+    if (fileHandle != nullptr)
+    {
+        CloseHandle(fileHandle);
+    }
+
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+#else
+    if (mapping != nullptr)
+    {
+        munmap(const_cast<char*>(mapping), length);
+    }
+#endif
+
+    mapping = nullptr;
+    length = 0;
+}
@@ -0,0 +1,599 @@
+#include "matrixfile.h"
+#include "argon2progress.h"
+
+#include <vector>
+#include <cerrno>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_NO_STATUS
+#include <windows.h>
+#undef WIN32_NO_STATUS
+typedef HANDLE FileHandle;
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+typedef int FileHandle;
+#endif
+
+// The checkpoint file starts with the headers of both slots, followed by their matrices.
+struct CheckpointHeader
+{
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t completedPasses;
+    uint64_t matrixBytes;
+    uint8_t identity[64];
+    uint32_t saltLength;
+    uint8_t salt[Argon2MatrixFile::maxStoredSaltLength];
+};
+
+static_assert(sizeof(CheckpointHeader) <= Argon2MatrixFile::headerSize, "A checkpoint header must fit into its slot");
+
+static const char checkpointMagic[8] = { 'A', '2', 'G', 'U', 'I', 'C', 'K', 'P' };
+static const uint32_t checkpointFormatVersion = 1;
+
+// Reads and writes go through chunks of this size (which Windows needs anyway: ReadFile and WriteFile take 32-bit sizes).
+static const size_t chunkSize = 16 * 1024 * 1024;
+
+static uint64_t headerOffset(unsigned int slot)
+{
+    return static_cast<uint64_t>(slot) * Argon2MatrixFile::headerSize;
+}
+
+static uint64_t matrixOffset(unsigned int slot, size_t bytes)
+{
+    return 2 * Argon2MatrixFile::headerSize + static_cast<uint64_t>(slot) * bytes;
+}
+
+static void reportError(const char* what, const std::string& path)
+{
+#ifdef _WIN32
+    fprintf(stderr, "%s \"%s\" (error %lu)\n", what, path.c_str(), GetLastError());
+#else
+    fprintf(stderr, "%s \"%s\": %s\n", what, path.c_str(), strerror(errno));
+#endif
+}
+
+static bool writeAt(FileHandle file, const uint8_t* data, size_t size, uint64_t offset)
+{
+    while (size > 0)
+    {
+        const size_t chunk = std::min(size, chunkSize);
+
+#ifdef _WIN32
+        OVERLAPPED position = {};
+        position.Offset = static_cast<DWORD>(offset);
+        position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        DWORD written = 0;
+
+        if (!WriteFile(file, data, static_cast<DWORD>(chunk), &written, &position) || written == 0)
+        {
+            return false;
+        }
+#else
+        const ssize_t written = pwrite(file, data, chunk, static_cast<off_t>(offset));
+
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (written <= 0)
+        {
+            return false;
+        }
+#endif
+
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+
+    return true;
+}
+
+static bool readAt(FileHandle file, uint8_t* data, size_t size, uint64_t offset)
+{
+    while (size > 0)
+    {
+        const size_t chunk = std::min(size, chunkSize);
+
+#ifdef _WIN32
+        OVERLAPPED position = {};
+        position.Offset = static_cast<DWORD>(offset);
+        position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        DWORD read = 0;
+
+        if (!ReadFile(file, data, static_cast<DWORD>(chunk), &read, &position) || read == 0)
+        {
+            return false;
+        }
+#else
+        const ssize_t read = pread(file, data, chunk, static_cast<off_t>(offset));
+
+        if (read < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (read <= 0)
+        {
+            return false;
+        }
+#endif
+
+        data += read;
+        size -= static_cast<size_t>(read);
+        offset += static_cast<uint64_t>(read);
+    }
+
+    return true;
+}
+
+static bool syncFile(FileHandle file)
+{
+#ifdef _WIN32
+    return FlushFileBuffers(file) != 0;
+#elif defined(__linux__)
+    return fdatasync(file) == 0;
+#else
+    return fsync(file) == 0;
+#endif
+}
+
+static uint64_t fileSize(FileHandle file)
+{
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    return GetFileSizeEx(file, &size) ? static_cast<uint64_t>(size.QuadPart) : 0;
+#else
+    struct stat status;
+    return fstat(file, &status) == 0 ? static_cast<uint64_t>(status.st_size) : 0;
+#endif
+}
+
+static bool resizeFile(FileHandle file, uint64_t size)
+{
+#ifdef _WIN32
+    LARGE_INTEGER position;
+    position.QuadPart = static_cast<LONGLONG>(size);
+    return SetFilePointerEx(file, position, NULL, FILE_BEGIN) && SetEndOfFile(file);
+#else
+    return ftruncate(file, static_cast<off_t>(size)) == 0;
+#endif
+}
+
+// Tells the kernel that a range of a file won't be needed again any time soon, so that streaming a checkpoint
+// through the page cache doesn't push the matrix itself out of it (Windows has no such hint).
+static void dropFromCache(FileHandle file, uint64_t offset, size_t size)
+{
+#if defined(__linux__)
+    posix_fadvise(file, static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_DONTNEED);
+#else
+    (void)file;
+    (void)offset;
+    (void)size;
+#endif
+}
+
+// Overwrites the whole file with zeros, flushes that to disk and truncates it. Written through the file rather than a mapping,
+// so that pages the kernel already evicted aren't read back in just to be zeroed.
+static bool overwriteWithZeros(FileHandle file)
+{
+    static const std::vector<uint8_t> zeros(chunkSize);
+
+    const uint64_t size = fileSize(file);
+
+    for (uint64_t offset = 0; offset < size; offset += chunkSize)
+    {
+        if (!writeAt(file, zeros.data(), static_cast<size_t>(std::min<uint64_t>(size - offset, chunkSize)), offset))
+        {
+            return false;
+        }
+
+        dropFromCache(file, offset, chunkSize);
+    }
+
+    return syncFile(file) && resizeFile(file, 0);
+}
+
+// Both slots' headers (the ones that can't be read come back zeroed, i.e. invalid).
+static void readHeaders(FileHandle file, CheckpointHeader (&headers)[2])
+{
+    memset(headers, 0x00, sizeof(headers));
+
+    if (fileSize(file) < matrixOffset(0, 0))
+    {
+        return;
+    }
+
+    for (unsigned int slot = 0; slot < 2; ++slot)
+    {
+        if (!readAt(file, reinterpret_cast<uint8_t*>(&headers[slot]), sizeof(CheckpointHeader), headerOffset(slot)))
+        {
+            memset(&headers[slot], 0x00, sizeof(CheckpointHeader));
+        }
+    }
+}
+
+static bool isValid(const CheckpointHeader& header)
+{
+    return memcmp(header.magic, checkpointMagic, sizeof(checkpointMagic)) == 0 && header.formatVersion == checkpointFormatVersion && header.completedPasses > 0 && header.saltLength <= Argon2MatrixFile::maxStoredSaltLength;
+}
+
+// The slot holding the latest checkpoint, or -1 if neither is valid.
+static int latestSlot(const CheckpointHeader (&headers)[2])
+{
+    int latest = -1;
+
+    for (unsigned int slot = 0; slot < 2; ++slot)
+    {
+        if (isValid(headers[slot]) && (latest < 0 || headers[slot].completedPasses > headers[latest].completedPasses))
+        {
+            latest = static_cast<int>(slot);
+        }
+    }
+
+    return latest;
+}
+
+Argon2MatrixFile::Argon2MatrixFile(std::string path, double checkpointSeconds)
+    : matrixPath(std::move(path))
+    , checkpointPath(matrixPath + ".checkpoint")
+    , checkpointSeconds(checkpointSeconds)
+{
+}
+
+Argon2MatrixFile::~Argon2MatrixFile()
+{
+    remove();
+}
+
+std::string Argon2MatrixFile::checkpointSalt(const std::string& path)
+{
+    const std::string checkpoint = path + ".checkpoint";
+    CheckpointHeader headers[2];
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(checkpoint.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return std::string();
+    }
+
+    readHeaders(file, headers);
+    CloseHandle(file);
+#else
+    const int file = ::open(checkpoint.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (file == -1)
+    {
+        return std::string();
+    }
+
+    readHeaders(file, headers);
+    ::close(file);
+#endif
+
+    const int slot = latestSlot(headers);
+    return slot < 0 ? std::string() : std::string(reinterpret_cast<const char*>(headers[slot].salt), headers[slot].saltLength);
+}
+
+int Argon2MatrixFile::open(size_t bytes, const uint8_t* identity, const uint8_t* salt, size_t saltlen, uint32_t& completedPasses)
+{
+    close();
+    completedPasses = 0;
+
+#ifdef _WIN32
+    // Opened without sharing: that's what keeps two hashes from using the same matrix file.
+    matrixHandle = CreateFileA(matrixPath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+
+    if (matrixHandle == INVALID_HANDLE_VALUE)
+    {
+        matrixHandle = nullptr;
+        reportError(GetLastError() == ERROR_SHARING_VIOLATION ? "Another hash is using the matrix file" : "Couldn't open the matrix file", matrixPath);
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+
+    checkpointHandle = CreateFileA(checkpointPath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    if (checkpointHandle == INVALID_HANDLE_VALUE)
+    {
+        checkpointHandle = nullptr;
+        reportError("Couldn't open the checkpoint file", checkpointPath);
+        close();
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+
+    const FileHandle matrixFile = matrixHandle;
+    const FileHandle checkpointFile = checkpointHandle;
+#else
+    matrixDescriptor = ::open(matrixPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+
+    if (matrixDescriptor == -1)
+    {
+        reportError("Couldn't open the matrix file", matrixPath);
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+
+    // The lock is what keeps two hashes from using the same matrix file (it goes away with the process, should it be killed).
+    if (flock(matrixDescriptor, LOCK_EX | LOCK_NB) != 0)
+    {
+        reportError("Another hash is using the matrix file", matrixPath);
+        close();
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+
+    checkpointDescriptor = ::open(checkpointPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+
+    if (checkpointDescriptor == -1)
+    {
+        reportError("Couldn't open the checkpoint file", checkpointPath);
+        close();
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+
+    const FileHandle matrixFile = matrixDescriptor;
+    const FileHandle checkpointFile = checkpointDescriptor;
+#endif
+
+    // A checkpoint of another hash (or of a format this version can't read) is left alone: it may well be resumed later on.
+    CheckpointHeader headers[2];
+    readHeaders(checkpointFile, headers);
+
+    for (const CheckpointHeader& existing : headers)
+    {
+        if (memcmp(existing.magic, checkpointMagic, sizeof(checkpointMagic)) == 0 && (!isValid(existing) || existing.matrixBytes != bytes || memcmp(existing.identity, identity, sizeof(existing.identity)) != 0))
+        {
+            close();
+            return ARGON2_CHECKPOINT_MISMATCH;
+        }
+    }
+
+    if (!resizeFile(matrixFile, bytes))
+    {
+        reportError("Couldn't resize the matrix file", matrixPath);
+        close();
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+
+#ifdef _WIN32
+    mappingHandle = CreateFileMappingA(matrixHandle, NULL, PAGE_READWRITE, static_cast<DWORD>(static_cast<uint64_t>(bytes) >> 32), static_cast<DWORD>(bytes), NULL);
+    mapping = mappingHandle != nullptr ? static_cast<uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, bytes)) : nullptr;
+
+    if (mapping == nullptr)
+    {
+        reportError("Couldn't map the matrix file into memory", matrixPath);
+        close();
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+#else
+#ifdef __linux__
+    // Reserves the blocks up front: running out of disk space then fails here, instead of with a SIGBUS in the middle of the hash.
+    const int allocated = posix_fallocate(matrixDescriptor, 0, static_cast<off_t>(bytes));
+
+    if (allocated != 0 && allocated != EOPNOTSUPP && allocated != EINVAL)
+    {
+        errno = allocated;
+        reportError("Couldn't allocate disk space for the matrix file", matrixPath);
+        close();
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+#endif
+
+    void* address = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, matrixDescriptor, 0);
+
+    if (address == MAP_FAILED)
+    {
+        reportError("Couldn't map the matrix file into memory", matrixPath);
+        close();
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+
+    // The reference blocks are all over the matrix: read-ahead would only evict pages that are still needed.
+    madvise(address, bytes, MADV_RANDOM);
+
+    mapping = static_cast<uint8_t*>(address);
+#endif
+
+    length = bytes;
+
+    const int slot = latestSlot(headers);
+
+    if (slot >= 0)
+    {
+#if defined(__linux__)
+        posix_fadvise(checkpointFile, static_cast<off_t>(matrixOffset(static_cast<unsigned int>(slot), bytes)), static_cast<off_t>(bytes), POSIX_FADV_SEQUENTIAL);
+#endif
+
+        if (!readAt(checkpointFile, mapping, bytes, matrixOffset(static_cast<unsigned int>(slot), bytes)))
+        {
+            reportError("Couldn't read the checkpoint", checkpointPath);
+            close();
+            return ARGON2_MEMORY_ALLOCATION_ERROR;
+        }
+
+        dropFromCache(checkpointFile, matrixOffset(static_cast<unsigned int>(slot), bytes), bytes);
+
+        completedPasses = headers[slot].completedPasses;
+        nextSlot = 1 - static_cast<unsigned int>(slot);
+    }
+    else
+    {
+        nextSlot = 0;
+    }
+
+    CheckpointHeader ours;
+    memset(&ours, 0x00, sizeof(ours));
+    memcpy(ours.magic, checkpointMagic, sizeof(checkpointMagic));
+    ours.formatVersion = checkpointFormatVersion;
+    ours.matrixBytes = bytes;
+    memcpy(ours.identity, identity, sizeof(ours.identity));
+
+    if (saltlen <= maxStoredSaltLength)
+    {
+        ours.saltLength = static_cast<uint32_t>(saltlen);
+        memcpy(ours.salt, salt, saltlen);
+    }
+
+    header.assign(headerSize, '\0');
+    memcpy(&header[0], &ours, sizeof(ours));
+
+    lastCheckpoint = std::chrono::steady_clock::now();
+    return ARGON2_OK;
+}
+
+bool Argon2MatrixFile::checkpointDue() const
+{
+    return mapping != nullptr && std::chrono::duration<double>(std::chrono::steady_clock::now() - lastCheckpoint).count() >= checkpointSeconds;
+}
+
+bool Argon2MatrixFile::checkpoint(uint32_t completedPasses)
+{
+    if (mapping == nullptr)
+    {
+        return false;
+    }
+
+#ifdef _WIN32
+    const FileHandle file = checkpointHandle;
+#else
+    const FileHandle file = checkpointDescriptor;
+#endif
+
+    lastCheckpoint = std::chrono::steady_clock::now();
+
+    const unsigned int slot = nextSlot;
+    const std::string invalid(headerSize, '\0');
+
+    std::string valid = header;
+    memcpy(&valid[offsetof(CheckpointHeader, completedPasses)], &completedPasses, sizeof(completedPasses));
+
+    // The slot's header is invalidated (and that flushed) before its matrix gets overwritten, and only written back once the matrix is on disk:
+    // whenever the process gets killed, the slot is either complete or ignored.
+    const bool written = writeAt(file, reinterpret_cast<const uint8_t*>(invalid.data()), headerSize, headerOffset(slot)) && syncFile(file)
+        && writeAt(file, mapping, length, matrixOffset(slot, length)) && syncFile(file)
+        && writeAt(file, reinterpret_cast<const uint8_t*>(valid.data()), headerSize, headerOffset(slot)) && syncFile(file);
+
+    dropFromCache(file, matrixOffset(slot, length), length);
+
+    if (!written)
+    {
+        reportError("Couldn't write a checkpoint to", checkpointPath);
+        return false;
+    }
+
+    nextSlot = 1 - slot;
+    return true;
+}
+
+void Argon2MatrixFile::close()
+{
+#ifdef _WIN32
+    if (mapping != nullptr)
+    {
+        UnmapViewOfFile(mapping);
+    }
+
+    if (mappingHandle != nullptr)
+    {
+        CloseHandle(mappingHandle);
+    }
+
+    if (matrixHandle != nullptr)
+    {
+        CloseHandle(matrixHandle);
+    }
+
+    if (checkpointHandle != nullptr)
+    {
+        CloseHandle(checkpointHandle);
+    }
+
+    matrixHandle = nullptr;
+    mappingHandle = nullptr;
+    checkpointHandle = nullptr;
+#else
+    if (mapping != nullptr)
+    {
+        munmap(mapping, length);
+    }
+
+    if (matrixDescriptor != -1)
+    {
+        ::close(matrixDescriptor);
+    }
+
+    if (checkpointDescriptor != -1)
+    {
+        ::close(checkpointDescriptor);
+    }
+
+    matrixDescriptor = -1;
+    checkpointDescriptor = -1;
+#endif
+
+    mapping = nullptr;
+    length = 0;
+}
+
+void Argon2MatrixFile::remove()
+{
+    // Only files this object opened (and locked) are deleted.
+    if (mapping == nullptr)
+    {
+        close();
+        return;
+    }
+
+    // Unmapped first: the matrix's dirty pages stay in the page cache, where the zeros then overwrite them.
+#ifdef _WIN32
+    UnmapViewOfFile(mapping);
+    CloseHandle(mappingHandle);
+    mappingHandle = nullptr;
+
+    const bool matrixWiped = overwriteWithZeros(matrixHandle);
+    const bool checkpointWiped = overwriteWithZeros(checkpointHandle);
+#else
+    munmap(mapping, length);
+
+    const bool matrixWiped = overwriteWithZeros(matrixDescriptor);
+    const bool checkpointWiped = overwriteWithZeros(checkpointDescriptor);
+#endif
+
+    mapping = nullptr;
+
+    if (!matrixWiped)
+    {
+        reportError("Couldn't overwrite the matrix file", matrixPath);
+    }
+
+    if (!checkpointWiped)
+    {
+        reportError("Couldn't overwrite the checkpoint file", checkpointPath);
+    }
+
+    // (On Windows, files can only be deleted once closed; elsewhere, closing releases the lock, so that comes last.)
+#ifdef _WIN32
+    close();
+
+    DeleteFileA(matrixPath.c_str());
+    DeleteFileA(checkpointPath.c_str());
+#else
+    ::unlink(checkpointPath.c_str());
+    ::unlink(matrixPath.c_str());
+
+    close();
+#endif
+}
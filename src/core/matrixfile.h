@@ -0,0 +1,86 @@
+#ifndef MATRIXFILE_H
+#define MATRIXFILE_H
+
+#include <chrono>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// A hash's memory matrix in a memory-mapped file instead of anonymous memory, for parameters whose matrix doesn't fit into RAM
+// or whose hash runs long enough to be worth resuming: the page cache holds what it can, the kernel writes the rest back to the file.
+//
+// At pass boundaries, the matrix is checkpointed (at most once every checkpointSeconds) into <path>.checkpoint, which has two slots
+// used in turn: a checkpoint being written never touches the previous one, so a job killed at any point (even halfway through a checkpoint)
+// resumes from the last complete one when it's run again with the same path, password, salt and parameters (see argon2_progress_ctx).
+// That takes up to three times the matrix size on disk.
+//
+// Once the hash ends (however it ends, short of the process being killed), both files are overwritten with zeros, flushed to disk and deleted.
+// That's as far as a program can go: copy-on-write filesystems and SSDs may keep old copies of the blocks, so keep matrix files
+// for sensitive passwords on an encrypted volume. Checkpoints are only meant to be resumed on the machine that wrote them.
+class Argon2MatrixFile
+{
+public:
+    // Size of each checkpoint slot's header (the matrix follows it).
+    static constexpr size_t headerSize = 4096;
+
+    // Longest salt stored with a checkpoint (see checkpointSalt).
+    static constexpr size_t maxStoredSaltLength = 1024;
+
+    explicit Argon2MatrixFile(std::string path, double checkpointSeconds = 60.0);
+
+    // Deletes the files (see remove).
+    ~Argon2MatrixFile();
+
+    Argon2MatrixFile(const Argon2MatrixFile&) = delete;
+    Argon2MatrixFile& operator=(const Argon2MatrixFile&) = delete;
+
+    // The salt stored with the latest checkpoint at path, if there's one: a job that doesn't bring its own salt needs it to resume.
+    static std::string checkpointSalt(const std::string& path);
+
+    // Locks the file against other hashes, maps a matrix of the passed size into memory and, if there's a checkpoint with the same identity
+    // (a digest of the hash's H0, which covers all of its inputs and parameters), loads it. Returns ARGON2_OK (completedPasses being the number
+    // of passes the checkpoint had completed, 0 without one), ARGON2_CHECKPOINT_MISMATCH (leaving the files alone) or ARGON2_MEMORY_ALLOCATION_ERROR.
+    int open(size_t bytes, const uint8_t* identity, const uint8_t* salt, size_t saltlen, uint32_t& completedPasses);
+
+    uint8_t* data() const
+    {
+        return mapping;
+    }
+
+    // Whether checkpointSeconds have passed since the last checkpoint (or since open).
+    bool checkpointDue() const;
+
+    // Copies the matrix into the older checkpoint slot. Must be called between passes (with no lane being filled).
+    // A failed checkpoint is reported on stderr: the hash goes on, resumable from the previous one.
+    bool checkpoint(uint32_t completedPasses);
+
+    // Overwrites the matrix and the checkpoints with zeros, flushes them and deletes both files.
+    void remove();
+
+private:
+    std::string matrixPath;
+    std::string checkpointPath;
+    double checkpointSeconds;
+    std::chrono::steady_clock::time_point lastCheckpoint;
+
+    uint8_t* mapping = nullptr;
+    size_t length = 0;
+
+    // Header of this hash's checkpoints (but for the number of completed passes).
+    std::string header;
+    unsigned int nextSlot = 0;
+
+#ifdef _WIN32
+    void* matrixHandle = nullptr;
+    void* mappingHandle = nullptr;
+    void* checkpointHandle = nullptr;
+#else
+    int matrixDescriptor = -1;
+    int checkpointDescriptor = -1;
+#endif
+
+    // Unmaps and closes everything, leaving the files as they are.
+    void close();
+};
+
+#endif // MATRIXFILE_H
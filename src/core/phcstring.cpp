@@ -0,0 +1,518 @@
+#include "phcstring.h"
+
+#include <bit>
+#include <array>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHCSTRING_SSE2
+typedef __m128i SextetVector;
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define PHCSTRING_NEON
+typedef uint8x16_t SextetVector;
+#endif
+
+static inline bool consume(std::string_view& input, std::string_view prefix)
+{
+    if (input.substr(0, prefix.size()) != prefix)
+    {
+        return false;
+    }
+
+    input.remove_prefix(prefix.size());
+    return true;
+}
+
+static inline bool consumeDecimal(std::string_view& input, uint32_t& value)
+{
+    size_t i = 0;
+    uint64_t accumulator = 0;
+
+    while (i < input.size() && input[i] >= '0' && input[i] <= '9')
+    {
+        accumulator = accumulator * 10 + static_cast<uint64_t>(input[i] - '0');
+
+        if (accumulator > UINT32_MAX)
+        {
+            return false;
+        }
+
+        ++i;
+    }
+
+    // No digits at all, or a leading zero (only "0" itself is allowed).
+    if (i == 0 || (input[0] == '0' && i != 1))
+    {
+        return false;
+    }
+
+    value = static_cast<uint32_t>(accumulator);
+    input.remove_prefix(i);
+    return true;
+}
+
+// Value of every base64 character, 0xFF for anything else.
+static constexpr std::array<uint8_t, 256> base64Values = [] {
+    std::array<uint8_t, 256> values {};
+    values.fill(0xFF);
+
+    for (unsigned int i = 0; i < 26; ++i)
+    {
+        values['A' + i] = static_cast<uint8_t>(i);
+        values['a' + i] = static_cast<uint8_t>(26 + i);
+    }
+
+    for (unsigned int i = 0; i < 10; ++i)
+    {
+        values['0' + i] = static_cast<uint8_t>(52 + i);
+    }
+
+    values['+'] = 62;
+    values['/'] = 63;
+
+    return values;
+}();
+
+static inline unsigned int base64Value(const char c)
+{
+    return base64Values[static_cast<unsigned char>(c)];
+}
+
+static const char base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+#if defined(PHCSTRING_SSE2) || defined(PHCSTRING_NEON)
+
+// Both SSE2 and NEON lack a cheap way to pack the 3 bytes of every 32-bit lane together (that's a pshufb, or a vld4/vst3 on 64 characters):
+// the lanes go through memory instead, most significant byte first.
+static inline void storeTriplets(const uint32_t* words, uint8_t* output)
+{
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        output[3 * i] = static_cast<uint8_t>(words[i] >> 16);
+        output[3 * i + 1] = static_cast<uint8_t>(words[i] >> 8);
+        output[3 * i + 2] = static_cast<uint8_t>(words[i]);
+    }
+}
+
+static inline void loadTriplets(const uint8_t* input, uint32_t* words)
+{
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        words[i] = static_cast<uint32_t>(input[3 * i]) << 16 | static_cast<uint32_t>(input[3 * i + 1]) << 8 | input[3 * i + 2];
+    }
+}
+
+#endif
+
+#if defined(PHCSTRING_SSE2)
+
+// Translates 16 characters into their 6-bit values. Returns how many of them (from the first one on) are base64 characters.
+static inline unsigned int translate(const char* input, __m128i& sextets)
+{
+    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+
+    // Signed comparisons: bytes >= 0x80 are negative, and thus in none of the ranges.
+    const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('Z' + 1)));
+    const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('z' + 1)));
+    const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    const __m128i plus = _mm_cmpeq_epi8(c, _mm_set1_epi8('+'));
+    const __m128i slash = _mm_cmpeq_epi8(c, _mm_set1_epi8('/'));
+
+    __m128i offset = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+    offset = _mm_or_si128(offset, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+    offset = _mm_or_si128(offset, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+    offset = _mm_or_si128(offset, _mm_and_si128(plus, _mm_set1_epi8(62 - '+')));
+    offset = _mm_or_si128(offset, _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+
+    sextets = _mm_add_epi8(c, offset);
+
+    const __m128i valid = _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, plus)), slash);
+    return static_cast<unsigned int>(std::countr_one(static_cast<unsigned int>(_mm_movemask_epi8(valid))));
+}
+
+// Decodes 16 base64 characters into 12 bytes. Returns false (leaving the output untouched) if any of them isn't a base64 character.
+static inline bool decodeBlock(const char* input, uint8_t* output)
+{
+    __m128i sextets;
+
+    if (translate(input, sextets) != 16)
+    {
+        return false;
+    }
+
+    // Pairs of sextets into 12 bits (the first one being the most significant), then pairs of those into 24 bits.
+    const __m128i pairs = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(sextets, _mm_set1_epi16(0x00FF)), 6), _mm_srli_epi16(sextets, 8));
+    const __m128i quads = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(pairs, _mm_set1_epi32(0xFFFF)), 12), _mm_srli_epi32(pairs, 16));
+
+    uint32_t words[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(words), quads);
+    storeTriplets(words, output);
+
+    return true;
+}
+
+// Encodes 12 bytes into 16 base64 characters.
+static inline void encodeBlock(const uint8_t* input, char* output)
+{
+    uint32_t words[4];
+    loadTriplets(input, words);
+
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words));
+    const __m128i mask = _mm_set1_epi32(0x3F);
+
+    // The most significant sextet of every 24 bits goes into the lane's first byte.
+    __m128i sextets = _mm_srli_epi32(v, 18);
+    sextets = _mm_or_si128(sextets, _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v, 12), mask), 8));
+    sextets = _mm_or_si128(sextets, _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v, 6), mask), 16));
+    sextets = _mm_or_si128(sextets, _mm_slli_epi32(_mm_and_si128(v, mask), 24));
+
+    // 'A' + x, then 'a' + x - 26 from 26 on, '0' + x - 52 from 52 on, '+' for 62 and '/' for 63.
+    __m128i offset = _mm_set1_epi8('A');
+    offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(sextets, _mm_set1_epi8(25)), _mm_set1_epi8(('a' - 26) - 'A')));
+    offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(sextets, _mm_set1_epi8(51)), _mm_set1_epi8(('0' - 52) - ('a' - 26))));
+    offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(sextets, _mm_set1_epi8(61)), _mm_set1_epi8(('+' - 62) - ('0' - 52))));
+    offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpeq_epi8(sextets, _mm_set1_epi8(63)), _mm_set1_epi8(('/' - 63) - ('+' - 62))));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_add_epi8(sextets, offset));
+}
+
+#elif defined(PHCSTRING_NEON)
+
+static inline uint8x16_t inRange(uint8x16_t c, char first, char last)
+{
+    return vandq_u8(vcgeq_u8(c, vdupq_n_u8(static_cast<uint8_t>(first))), vcleq_u8(c, vdupq_n_u8(static_cast<uint8_t>(last))));
+}
+
+// Translates 16 characters into their 6-bit values. Returns how many of them (from the first one on) are base64 characters.
+static inline unsigned int translate(const char* input, uint8x16_t& sextets)
+{
+    const uint8x16_t c = vld1q_u8(reinterpret_cast<const uint8_t*>(input));
+
+    const uint8x16_t upper = inRange(c, 'A', 'Z');
+    const uint8x16_t lower = inRange(c, 'a', 'z');
+    const uint8x16_t digit = inRange(c, '0', '9');
+    const uint8x16_t plus = vceqq_u8(c, vdupq_n_u8('+'));
+    const uint8x16_t slash = vceqq_u8(c, vdupq_n_u8('/'));
+
+    uint8x16_t offset = vandq_u8(upper, vdupq_n_u8(static_cast<uint8_t>(-'A')));
+    offset = vorrq_u8(offset, vandq_u8(lower, vdupq_n_u8(static_cast<uint8_t>(26 - 'a'))));
+    offset = vorrq_u8(offset, vandq_u8(digit, vdupq_n_u8(static_cast<uint8_t>(52 - '0'))));
+    offset = vorrq_u8(offset, vandq_u8(plus, vdupq_n_u8(static_cast<uint8_t>(62 - '+'))));
+    offset = vorrq_u8(offset, vandq_u8(slash, vdupq_n_u8(static_cast<uint8_t>(63 - '/'))));
+
+    sextets = vaddq_u8(c, offset);
+
+    // NEON has no movemask: narrowing shifts turn the 16 byte masks into 16 nibbles of a 64-bit word.
+    const uint8x16_t valid = vorrq_u8(vorrq_u8(vorrq_u8(upper, lower), vorrq_u8(digit, plus)), slash);
+    const uint64_t nibbles = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(valid), 4)), 0);
+
+    return static_cast<unsigned int>(std::countr_one(nibbles)) / 4;
+}
+
+// Decodes 16 base64 characters into 12 bytes. Returns false (leaving the output untouched) if any of them isn't a base64 character.
+static inline bool decodeBlock(const char* input, uint8_t* output)
+{
+    uint8x16_t bytes;
+
+    if (translate(input, bytes) != 16)
+    {
+        return false;
+    }
+
+    const uint16x8_t sextets = vreinterpretq_u16_u8(bytes);
+
+    // Pairs of sextets into 12 bits (the first one being the most significant), then pairs of those into 24 bits.
+    const uint32x4_t pairs = vreinterpretq_u32_u16(vorrq_u16(vshlq_n_u16(vandq_u16(sextets, vdupq_n_u16(0x00FF)), 6), vshrq_n_u16(sextets, 8)));
+    const uint32x4_t quads = vorrq_u32(vshlq_n_u32(vandq_u32(pairs, vdupq_n_u32(0xFFFF)), 12), vshrq_n_u32(pairs, 16));
+
+    uint32_t words[4];
+    vst1q_u32(words, quads);
+    storeTriplets(words, output);
+
+    return true;
+}
+
+// Encodes 12 bytes into 16 base64 characters.
+static inline void encodeBlock(const uint8_t* input, char* output)
+{
+    uint32_t words[4];
+    loadTriplets(input, words);
+
+    const uint32x4_t v = vld1q_u32(words);
+    const uint32x4_t mask = vdupq_n_u32(0x3F);
+
+    // The most significant sextet of every 24 bits goes into the lane's first byte.
+    uint32x4_t lanes = vshrq_n_u32(v, 18);
+    lanes = vorrq_u32(lanes, vshlq_n_u32(vandq_u32(vshrq_n_u32(v, 12), mask), 8));
+    lanes = vorrq_u32(lanes, vshlq_n_u32(vandq_u32(vshrq_n_u32(v, 6), mask), 16));
+    lanes = vorrq_u32(lanes, vshlq_n_u32(vandq_u32(v, mask), 24));
+
+    const uint8x16_t sextets = vreinterpretq_u8_u32(lanes);
+
+    // 'A' + x, then 'a' + x - 26 from 26 on, '0' + x - 52 from 52 on, '+' for 62 and '/' for 63.
+    uint8x16_t offset = vdupq_n_u8('A');
+    offset = vaddq_u8(offset, vandq_u8(vcgtq_u8(sextets, vdupq_n_u8(25)), vdupq_n_u8(static_cast<uint8_t>(('a' - 26) - 'A'))));
+    offset = vaddq_u8(offset, vandq_u8(vcgtq_u8(sextets, vdupq_n_u8(51)), vdupq_n_u8(static_cast<uint8_t>(('0' - 52) - ('a' - 26)))));
+    offset = vaddq_u8(offset, vandq_u8(vcgtq_u8(sextets, vdupq_n_u8(61)), vdupq_n_u8(static_cast<uint8_t>(('+' - 62) - ('0' - 52)))));
+    offset = vaddq_u8(offset, vandq_u8(vceqq_u8(sextets, vdupq_n_u8(63)), vdupq_n_u8(static_cast<uint8_t>(('/' - 63) - ('+' - 62)))));
+
+    vst1q_u8(reinterpret_cast<uint8_t*>(output), vaddq_u8(sextets, offset));
+}
+
+#endif
+
+size_t decodeBase64(std::string_view input, uint8_t* output, size_t outputSize)
+{
+    size_t length = 0;
+
+#if defined(PHCSTRING_SSE2) || defined(PHCSTRING_NEON)
+    // 16 characters are exactly 12 bytes: the scalar loop below then picks up the rest (or the invalid block) with an empty accumulator.
+    while (input.size() >= 16 && outputSize - length >= 12 && decodeBlock(input.data(), output + length))
+    {
+        input.remove_prefix(16);
+        length += 12;
+    }
+#endif
+
+    unsigned int accumulator = 0;
+    unsigned int accumulatorBits = 0;
+
+    for (const char c : input)
+    {
+        const unsigned int value = base64Value(c);
+
+        if (value == 0xFF)
+        {
+            return SIZE_MAX;
+        }
+
+        accumulator = (accumulator << 6) | value;
+        accumulatorBits += 6;
+
+        if (accumulatorBits >= 8)
+        {
+            accumulatorBits -= 8;
+
+            if (length >= outputSize)
+            {
+                return SIZE_MAX;
+            }
+
+            output[length++] = static_cast<uint8_t>(accumulator >> accumulatorBits);
+        }
+    }
+
+    if (accumulatorBits > 4 || (accumulator & ((1u << accumulatorBits) - 1)) != 0)
+    {
+        return SIZE_MAX;
+    }
+
+    return length;
+}
+
+size_t encodeBase64(const uint8_t* input, size_t inputSize, char* output, size_t outputSize)
+{
+    const size_t outputLength = inputSize / 3 * 4 + (inputSize % 3 != 0 ? inputSize % 3 + 1 : 0);
+
+    if (outputLength > outputSize)
+    {
+        return SIZE_MAX;
+    }
+
+    size_t i = 0;
+
+#if defined(PHCSTRING_SSE2) || defined(PHCSTRING_NEON)
+    for (; inputSize - i >= 12; i += 12)
+    {
+        encodeBlock(input + i, output);
+        output += 16;
+    }
+#endif
+
+    unsigned int accumulator = 0;
+    unsigned int accumulatorBits = 0;
+
+    for (; i < inputSize; ++i)
+    {
+        accumulator = (accumulator << 8) | input[i];
+        accumulatorBits += 8;
+
+        while (accumulatorBits >= 6)
+        {
+            accumulatorBits -= 6;
+            *output++ = base64Alphabet[(accumulator >> accumulatorBits) & 0x3F];
+        }
+    }
+
+    if (accumulatorBits > 0)
+    {
+        *output++ = base64Alphabet[(accumulator << (6 - accumulatorBits)) & 0x3F];
+    }
+
+    return outputLength;
+}
+
+static inline std::string_view consumeBase64(std::string_view& input)
+{
+    size_t i = 0;
+
+#if defined(PHCSTRING_SSE2) || defined(PHCSTRING_NEON)
+    for (; input.size() - i >= 16; i += 16)
+    {
+        SextetVector sextets;
+        const unsigned int valid = translate(input.data() + i, sextets);
+
+        if (valid != 16)
+        {
+            i += valid;
+
+            const std::string_view field = input.substr(0, i);
+            input.remove_prefix(i);
+            return field;
+        }
+    }
+#endif
+
+    while (i < input.size() && base64Value(input[i]) != 0xFF)
+    {
+        ++i;
+    }
+
+    const std::string_view field = input.substr(0, i);
+    input.remove_prefix(i);
+    return field;
+}
+
+bool parsePhcString(std::string_view input, PhcString& output)
+{
+    if (consume(input, "$argon2id"))
+    {
+        output.type = Argon2_id;
+    }
+    else if (consume(input, "$argon2i"))
+    {
+        output.type = Argon2_i;
+    }
+    else if (consume(input, "$argon2d"))
+    {
+        output.type = Argon2_d;
+    }
+    else
+    {
+        return false;
+    }
+
+    output.version = ARGON2_VERSION_10;
+
+    if (consume(input, "$v=") && !consumeDecimal(input, output.version))
+    {
+        return false;
+    }
+
+    if (!consume(input, "$m=") || !consumeDecimal(input, output.memoryCostKiB)
+        || !consume(input, ",t=") || !consumeDecimal(input, output.timeCost)
+        || !consume(input, ",p=") || !consumeDecimal(input, output.parallelism))
+    {
+        return false;
+    }
+
+    if (!consume(input, "$"))
+    {
+        return false;
+    }
+
+    output.salt = consumeBase64(input);
+
+    if (!consume(input, "$"))
+    {
+        return false;
+    }
+
+    output.hash = consumeBase64(input);
+
+    return input.empty();
+}
+
+static inline bool append(char*& output, const char* end, std::string_view text)
+{
+    if (static_cast<size_t>(end - output) < text.size())
+    {
+        return false;
+    }
+
+    memcpy(output, text.data(), text.size());
+    output += text.size();
+    return true;
+}
+
+static inline bool appendDecimal(char*& output, const char* end, uint32_t value)
+{
+    char digits[10];
+    size_t count = 0;
+
+    do
+    {
+        digits[sizeof(digits) - ++count] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    return append(output, end, std::string_view(digits + sizeof(digits) - count, count));
+}
+
+static inline bool appendBase64(char*& output, const char* end, const uint8_t* input, size_t inputSize)
+{
+    const size_t length = encodeBase64(input, inputSize, output, static_cast<size_t>(end - output));
+
+    if (length == SIZE_MAX)
+    {
+        return false;
+    }
+
+    output += length;
+    return true;
+}
+
+size_t encodePhcString(argon2_type type, uint32_t version, uint32_t memoryCostKiB, uint32_t timeCost, uint32_t parallelism, const uint8_t* salt, size_t saltLength, const uint8_t* hash, size_t hashLength, char* output, size_t outputSize)
+{
+    std::string_view prefix;
+
+    switch (type)
+    {
+        case Argon2_id:
+            prefix = "$argon2id$v=";
+            break;
+        case Argon2_i:
+            prefix = "$argon2i$v=";
+            break;
+        case Argon2_d:
+            prefix = "$argon2d$v=";
+            break;
+        default:
+            return SIZE_MAX;
+    }
+
+    if (outputSize == 0)
+    {
+        return SIZE_MAX;
+    }
+
+    char* position = output;
+
+    // Leaving room for the NUL terminator.
+    const char* end = output + outputSize - 1;
+
+    if (!append(position, end, prefix) || !appendDecimal(position, end, version)
+        || !append(position, end, "$m=") || !appendDecimal(position, end, memoryCostKiB)
+        || !append(position, end, ",t=") || !appendDecimal(position, end, timeCost)
+        || !append(position, end, ",p=") || !appendDecimal(position, end, parallelism)
+        || !append(position, end, "$") || !appendBase64(position, end, salt, saltLength)
+        || !append(position, end, "$") || !appendBase64(position, end, hash, hashLength))
+    {
+        return SIZE_MAX;
+    }
+
+    *position = '\0';
+    return static_cast<size_t>(position - output);
+}
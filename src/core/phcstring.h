@@ -0,0 +1,43 @@
+#ifndef PHCSTRING_H
+#define PHCSTRING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include <argon2.h>
+
+// The individual fields of an encoded Argon2 hash string
+// ($argon2id$v=19$m=65536,t=16,p=2$<base64 salt>$<base64 hash>),
+// parsed without copying anything: salt and hash still point into the original string (and are still base64-encoded).
+struct PhcString
+{
+    argon2_type type = Argon2_id;
+    uint32_t version = ARGON2_VERSION_10;
+    uint32_t memoryCostKiB = 0;
+    uint32_t timeCost = 0;
+    uint32_t parallelism = 0;
+    std::string_view salt;
+    std::string_view hash;
+};
+
+// Parses an encoded Argon2 hash string with the exact same rules as the library's decode_string()
+// (the "$v=" field is optional and defaults to 0x10, decimals must not have leading zeros, base64 is unpadded, etc...).
+// The input does not need to be NUL-terminated. Returns false if the string is malformed.
+bool parsePhcString(std::string_view encoded, PhcString& output);
+
+// Decodes unpadded base64 into the passed output buffer (rejecting any non-canonical trailing bits just like the library does).
+// Returns the number of decoded bytes, or SIZE_MAX if the input is invalid or the output buffer too small.
+// Whole 16-character blocks are decoded with SSE2 (x86) or NEON (ARM64) where available.
+size_t decodeBase64(std::string_view input, uint8_t* output, size_t outputSize);
+
+// Encodes the passed bytes as unpadded base64, without NUL terminator (whole 12-byte blocks vectorized like in decodeBase64).
+// Returns the number of characters written, or SIZE_MAX if the output buffer is too small.
+size_t encodeBase64(const uint8_t* input, size_t inputSize, char* output, size_t outputSize);
+
+// Writes the encoded hash string for the passed parameters, salt and hash into output, NUL-terminated:
+// byte for byte what the library's encode_string() produces, minus the context validation (and without any intermediate copy).
+// Returns the string's length (NUL terminator excluded), or SIZE_MAX if the output buffer is too small.
+size_t encodePhcString(argon2_type type, uint32_t version, uint32_t memoryCostKiB, uint32_t timeCost, uint32_t parallelism, const uint8_t* salt, size_t saltLength, const uint8_t* hash, size_t hashLength, char* output, size_t outputSize);
+
+#endif // PHCSTRING_H
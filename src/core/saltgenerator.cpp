@@ -0,0 +1,206 @@
+#include "saltgenerator.h"
+
+#include <core.h>
+#include <blake2/blake2.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#if defined(_WIN32)
+#define WIN32_NO_STATUS
+#include <windows.h>
+#undef WIN32_NO_STATUS
+#include <bcrypt.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/random.h>
+#endif
+#endif
+
+static const size_t refillSize = 4096;
+
+// Incremented in every forked child, whose copies of the per-thread buffers must then not be used anymore.
+static std::atomic<uint64_t> forkGeneration { 0 };
+
+struct SaltBuffer
+{
+    // The bytes not handed out yet are the last "available" ones.
+    uint8_t bytes[refillSize];
+    size_t available = 0;
+    uint64_t generation = 0;
+
+    ~SaltBuffer()
+    {
+        secure_wipe_memory(bytes, sizeof(bytes));
+    }
+};
+
+static thread_local SaltBuffer buffer;
+
+#if !defined(_WIN32)
+
+static bool readDevUrandom(uint8_t* output, size_t size)
+{
+    const int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    size_t done = 0;
+
+    while (done < size)
+    {
+        const ssize_t n = read(fd, output + done, size - done);
+
+        if (n <= 0 && errno != EINTR)
+        {
+            break;
+        }
+
+        done += n > 0 ? static_cast<size_t>(n) : 0;
+    }
+
+    close(fd);
+    return done == size;
+}
+
+#endif
+
+static bool osRandom(uint8_t* output, size_t size)
+{
+#if defined(_WIN32)
+    return BCRYPT_SUCCESS(BCryptGenRandom(NULL, output, static_cast<ULONG>(size), BCRYPT_USE_SYSTEM_PREFERRED_RNG));
+#elif defined(__linux__)
+    size_t done = 0;
+
+    while (done < size)
+    {
+        const ssize_t n = getrandom(output + done, size - done, 0);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            // Kernels older than 3.17 have no getrandom().
+            return errno == ENOSYS && readDevUrandom(output + done, size - done);
+        }
+
+        done += static_cast<size_t>(n);
+    }
+
+    return true;
+#elif defined(__APPLE__)
+    // getentropy() serves at most 256 bytes per call.
+    for (size_t done = 0; done < size; done += 256)
+    {
+        if (getentropy(output + done, std::min<size_t>(size - done, 256)) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+#else
+    return readDevUrandom(output, size);
+#endif
+}
+
+static void osRandomOrWarn(uint8_t* output, size_t size)
+{
+    if (!osRandom(output, size))
+    {
+        fprintf(stderr, "Argon2UI: Warning! Failed to read %zu bytes from the OS's random number generator\n", size);
+    }
+}
+
+void random_salt(uint8_t* salt, size_t length)
+{
+    if (salt == NULL || length == 0)
+    {
+        return;
+    }
+
+#if !defined(_WIN32)
+    static const bool forkHandlerRegistered = pthread_atfork(NULL, NULL, [] { forkGeneration.fetch_add(1, std::memory_order_relaxed); }) == 0;
+    (void)forkHandlerRegistered;
+#endif
+
+    // Large requests wouldn't gain anything from the buffer.
+    if (length > refillSize / 4)
+    {
+        osRandomOrWarn(salt, length);
+        return;
+    }
+
+    SaltBuffer& local = buffer;
+    const uint64_t generation = forkGeneration.load(std::memory_order_relaxed);
+
+    if (local.generation != generation)
+    {
+        local.available = 0;
+        local.generation = generation;
+    }
+
+    if (local.available < length)
+    {
+        // The few bytes left over are simply overwritten.
+        if (!osRandom(local.bytes, refillSize))
+        {
+            secure_wipe_memory(local.bytes, refillSize);
+            local.available = 0;
+
+            osRandomOrWarn(salt, length);
+            return;
+        }
+
+        local.available = refillSize;
+    }
+
+    uint8_t* bytes = local.bytes + refillSize - local.available;
+
+    memcpy(salt, bytes, length);
+    secure_wipe_memory(bytes, length);
+
+    local.available -= length;
+}
+
+EntropyPool::EntropyPool()
+{
+    random_salt(state, sizeof(state));
+}
+
+EntropyPool::~EntropyPool()
+{
+    secure_wipe_memory(state, sizeof(state));
+}
+
+void EntropyPool::mix(const void* data, size_t size)
+{
+    const int64_t timestamp = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+
+    blake2b_state blake;
+    blake2b_init(&blake, sizeof(state));
+    blake2b_update(&blake, state, sizeof(state));
+    blake2b_update(&blake, &timestamp, sizeof(timestamp));
+    blake2b_update(&blake, data, size);
+    blake2b_final(&blake, state, sizeof(state));
+}
+
+void EntropyPool::extract(uint8_t* output, size_t size)
+{
+    // Keyed with the pool, over a counter.
+    blake2b(output, std::min(size, sizeof(state)), &extracted, sizeof(extracted), state, sizeof(state));
+    ++extracted;
+}
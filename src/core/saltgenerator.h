@@ -0,0 +1,36 @@
+#ifndef SALTGENERATOR_H
+#define SALTGENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Fills salt with length bytes from the OS's CSPRNG (getrandom on Linux, getentropy on macOS, BCryptGenRandom on Windows).
+// Short requests are served from a per-thread buffer that's refilled 4 KiB at a time, so handing out a 32-byte salt takes
+// no lock, no file descriptor and, on average, 1/128th of a system call. Bytes are wiped from the buffer as they're handed out,
+// and a forked child process never hands out the bytes that were buffered by its parent.
+void random_salt(uint8_t* salt, size_t length);
+
+// Fixed-size pool of user-provided entropy (e.g. UI interactions), mixed in with BLAKE2b along with a high-resolution timestamp.
+// It's seeded from the OS's CSPRNG, never allocates and always takes 64 bytes.
+class EntropyPool
+{
+public:
+    EntropyPool();
+
+    // Wipes the pool.
+    ~EntropyPool();
+
+    EntropyPool(const EntropyPool&) = delete;
+    EntropyPool& operator=(const EntropyPool&) = delete;
+
+    void mix(const void* data, size_t size);
+
+    // Derives up to 64 bytes from the pool's current state (the state itself is never handed out: every call returns different bytes).
+    void extract(uint8_t* output, size_t size);
+
+private:
+    uint8_t state[64];
+    uint64_t extracted = 0;
+};
+
+#endif // SALTGENERATOR_H
@@ -0,0 +1,449 @@
+#include "systemresources.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+
+#if defined(_WIN32)
+#define WIN32_NO_STATUS
+#include <windows.h>
+#undef WIN32_NO_STATUS
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/sysctl.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+#endif
+
+#ifdef __linux__
+
+// Path of this process' cgroup relative to the cgroup filesystem's mount point
+// (the line starting with "0::" in /proc/self/cgroup for cgroup v2, or the one for the passed v1 controller).
+static std::string cgroupPath(const char* controller)
+{
+    std::ifstream file("/proc/self/cgroup");
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        const size_t firstColon = line.find(':');
+        const size_t secondColon = line.find(':', firstColon + 1);
+
+        if (firstColon == std::string::npos || secondColon == std::string::npos)
+        {
+            continue;
+        }
+
+        const std::string controllers = line.substr(firstColon + 1, secondColon - firstColon - 1);
+
+        if (controller == nullptr ? controllers.empty() : ("," + controllers + ",").find(std::string(",") + controller + ",") != std::string::npos)
+        {
+            return line.substr(secondColon + 1);
+        }
+    }
+
+    return std::string();
+}
+
+// Reads the first whitespace-separated value of a cgroup file, walking up the hierarchy from the process' own cgroup
+// (limits set on a parent cgroup apply as well, and the own cgroup directory might not even be visible inside a container).
+static std::string readCgroupValue(const std::string& mountPoint, std::string path, const char* fileName)
+{
+    for (;;)
+    {
+        std::ifstream file(mountPoint + path + "/" + fileName);
+        std::string value;
+
+        if (file >> value)
+        {
+            return value;
+        }
+
+        if (path.empty() || path == "/")
+        {
+            return std::string();
+        }
+
+        const size_t slash = path.find_last_of('/');
+        path = slash == 0 || slash == std::string::npos ? std::string("/") : path.substr(0, slash);
+    }
+}
+
+static uint64_t parseBytes(const std::string& value)
+{
+    if (value.empty() || value == "max")
+    {
+        return UINT64_MAX;
+    }
+
+    const unsigned long long bytes = strtoull(value.c_str(), nullptr, 10);
+
+    // cgroup v1 reports "no limit" as a huge page-aligned number close to INT64_MAX.
+    return bytes == 0 || bytes >= (UINT64_C(1) << 62) ? UINT64_MAX : static_cast<uint64_t>(bytes);
+}
+
+static uint64_t cgroupMemoryHeadroom()
+{
+    const std::string v2 = cgroupPath(nullptr);
+
+    if (!v2.empty())
+    {
+        const uint64_t limit = parseBytes(readCgroupValue("/sys/fs/cgroup", v2, "memory.max"));
+        const uint64_t current = parseBytes(readCgroupValue("/sys/fs/cgroup", v2, "memory.current"));
+
+        if (limit != UINT64_MAX)
+        {
+            return current != UINT64_MAX && current < limit ? limit - current : 0;
+        }
+    }
+
+    const std::string v1 = cgroupPath("memory");
+
+    if (!v1.empty())
+    {
+        const uint64_t limit = parseBytes(readCgroupValue("/sys/fs/cgroup/memory", v1, "memory.limit_in_bytes"));
+        const uint64_t usage = parseBytes(readCgroupValue("/sys/fs/cgroup/memory", v1, "memory.usage_in_bytes"));
+
+        if (limit != UINT64_MAX)
+        {
+            return usage != UINT64_MAX && usage < limit ? limit - usage : 0;
+        }
+    }
+
+    return UINT64_MAX;
+}
+
+static uint64_t memInfoAvailable()
+{
+    std::ifstream file("/proc/meminfo");
+    std::string key;
+    uint64_t value = 0;
+    std::string unit;
+
+    while (file >> key >> value)
+    {
+        std::getline(file, unit);
+
+        if (key == "MemAvailable:")
+        {
+            return value * 1024;
+        }
+    }
+
+    return UINT64_MAX;
+}
+
+static double cgroupCpuQuota()
+{
+    const std::string v2 = cgroupPath(nullptr);
+
+    if (!v2.empty())
+    {
+        std::ifstream file("/sys/fs/cgroup" + v2 + "/cpu.max");
+        std::string quota;
+        double period = 0.0;
+
+        if (file >> quota >> period && quota != "max" && period > 0.0)
+        {
+            return std::stod(quota) / period;
+        }
+    }
+
+    const std::string v1 = cgroupPath("cpu");
+
+    if (!v1.empty())
+    {
+        const double quota = std::atof(readCgroupValue("/sys/fs/cgroup/cpu", v1, "cpu.cfs_quota_us").c_str());
+        const double period = std::atof(readCgroupValue("/sys/fs/cgroup/cpu", v1, "cpu.cfs_period_us").c_str());
+
+        if (quota > 0.0 && period > 0.0)
+        {
+            return quota / period;
+        }
+    }
+
+    return 0.0;
+}
+
+// Parses a sysfs CPU or node list, such as "0-3,8-11".
+static std::vector<unsigned int> parseList(const std::string& list)
+{
+    std::vector<unsigned int> values;
+    size_t start = 0;
+
+    while (start < list.size())
+    {
+        size_t end = list.find(',', start);
+
+        if (end == std::string::npos)
+        {
+            end = list.size();
+        }
+
+        const std::string range = list.substr(start, end - start);
+        const size_t dash = range.find('-');
+
+        const unsigned long first = strtoul(range.c_str(), nullptr, 10);
+        const unsigned long last = dash == std::string::npos ? first : strtoul(range.c_str() + dash + 1, nullptr, 10);
+
+        for (unsigned long value = first; value <= last; ++value)
+        {
+            values.push_back(static_cast<unsigned int>(value));
+        }
+
+        start = end + 1;
+    }
+
+    return values;
+}
+
+#endif // __linux__
+
+size_t availableMemory()
+{
+#if defined(_WIN32)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    return GlobalMemoryStatusEx(&status) ? static_cast<size_t>(status.ullAvailPhys) : SIZE_MAX;
+#elif defined(__APPLE__)
+    vm_statistics64_data_t statistics;
+    mach_msg_type_number_t count = HOST_VM_INFO64_COUNT;
+
+    if (host_statistics64(mach_host_self(), HOST_VM_INFO64, reinterpret_cast<host_info64_t>(&statistics), &count) != KERN_SUCCESS)
+    {
+        return SIZE_MAX;
+    }
+
+    return static_cast<size_t>(statistics.free_count + statistics.inactive_count + statistics.purgeable_count) * static_cast<size_t>(vm_page_size);
+#elif defined(__linux__)
+    const uint64_t available = std::min(memInfoAvailable(), cgroupMemoryHeadroom());
+    return available > SIZE_MAX ? SIZE_MAX : static_cast<size_t>(available);
+#else
+    return SIZE_MAX;
+#endif
+}
+
+unsigned int availableCores()
+{
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+
+#ifdef __linux__
+    cpu_set_t affinity;
+
+    if (sched_getaffinity(0, sizeof(affinity), &affinity) == 0)
+    {
+        cores = std::max(1u, std::min(cores, static_cast<unsigned int>(CPU_COUNT(&affinity))));
+    }
+
+    const double quota = cgroupCpuQuota();
+
+    if (quota > 0.0)
+    {
+        cores = std::max(1u, std::min(cores, static_cast<unsigned int>(std::ceil(quota))));
+    }
+#endif
+
+    return cores;
+}
+
+std::vector<std::vector<unsigned int>> numaNodes()
+{
+    std::vector<std::vector<unsigned int>> nodes;
+
+#if defined(_WIN32)
+    ULONG highestNode = 0;
+
+    if (GetNumaHighestNodeNumber(&highestNode))
+    {
+        for (ULONG node = 0; node <= highestNode; ++node)
+        {
+            // Only covers the processor group of the calling thread (i.e. the first 64 logical processors, for most processes).
+            ULONGLONG mask = 0;
+
+            if (!GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask))
+            {
+                continue;
+            }
+
+            std::vector<unsigned int> cpus;
+
+            for (unsigned int cpu = 0; cpu < 64; ++cpu)
+            {
+                if ((mask >> cpu) & 1)
+                {
+                    cpus.push_back(cpu);
+                }
+            }
+
+            if (!cpus.empty())
+            {
+                nodes.push_back(std::move(cpus));
+            }
+        }
+    }
+#elif defined(__linux__)
+    cpu_set_t affinity;
+    const bool haveAffinity = sched_getaffinity(0, sizeof(affinity), &affinity) == 0;
+
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string nodeList;
+
+    if (online >> nodeList)
+    {
+        for (unsigned int node : parseList(nodeList))
+        {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            std::string cpuList;
+            std::vector<unsigned int> cpus;
+
+            if (file >> cpuList)
+            {
+                for (unsigned int cpu : parseList(cpuList))
+                {
+                    if (!haveAffinity || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &affinity)))
+                    {
+                        cpus.push_back(cpu);
+                    }
+                }
+            }
+
+            if (!cpus.empty())
+            {
+                nodes.push_back(std::move(cpus));
+            }
+        }
+    }
+#endif
+
+    if (nodes.empty())
+    {
+        std::vector<unsigned int> cpus;
+
+#ifdef __linux__
+        if (haveAffinity)
+        {
+            for (unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &affinity))
+                {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+#endif
+
+        if (cpus.empty())
+        {
+            for (unsigned int cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+
+        nodes.push_back(std::move(cpus));
+    }
+
+    return nodes;
+}
+
+ResourceUsage resourceUsage()
+{
+    ResourceUsage usage;
+
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+
+    if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+    {
+        const uint64_t kernelTicks = (static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+        const uint64_t userTicks = (static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+
+        // In units of 100 ns.
+        usage.cpuSeconds = static_cast<double>(kernelTicks + userTicks) / 1e7;
+    }
+
+    PROCESS_MEMORY_COUNTERS counters;
+
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        usage.residentBytes = counters.WorkingSetSize;
+        usage.peakResidentBytes = counters.PeakWorkingSetSize;
+        usage.minorFaults = counters.PageFaultCount;
+    }
+#else
+    rusage counters;
+
+    if (getrusage(RUSAGE_SELF, &counters) == 0)
+    {
+        usage.cpuSeconds = static_cast<double>(counters.ru_utime.tv_sec + counters.ru_stime.tv_sec) + static_cast<double>(counters.ru_utime.tv_usec + counters.ru_stime.tv_usec) / 1e6;
+        usage.minorFaults = static_cast<uint64_t>(counters.ru_minflt);
+        usage.majorFaults = static_cast<uint64_t>(counters.ru_majflt);
+        usage.voluntaryContextSwitches = static_cast<uint64_t>(counters.ru_nvcsw);
+        usage.involuntaryContextSwitches = static_cast<uint64_t>(counters.ru_nivcsw);
+
+        // Lifetime peak: bytes on macOS, KiB elsewhere.
+#if defined(__APPLE__)
+        usage.peakResidentBytes = static_cast<uint64_t>(counters.ru_maxrss);
+#else
+        usage.peakResidentBytes = static_cast<uint64_t>(counters.ru_maxrss) * 1024;
+#endif
+    }
+
+#if defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+    {
+        usage.residentBytes = info.resident_size;
+    }
+#elif defined(__linux__)
+    // Unlike ru_maxrss, VmHWM can be reset (see resetPeakResidentBytes).
+    FILE* status = fopen("/proc/self/status", "r");
+
+    if (status != NULL)
+    {
+        char line[256];
+        unsigned long long kib = 0;
+
+        while (fgets(line, sizeof(line), status) != NULL)
+        {
+            if (sscanf(line, "VmHWM: %llu kB", &kib) == 1)
+            {
+                usage.peakResidentBytes = kib * 1024;
+            }
+            else if (sscanf(line, "VmRSS: %llu kB", &kib) == 1)
+            {
+                usage.residentBytes = kib * 1024;
+            }
+        }
+
+        fclose(status);
+    }
+#endif
+#endif
+
+    return usage;
+}
+
+void resetPeakResidentBytes()
+{
+#ifdef __linux__
+    FILE* clearRefs = fopen("/proc/self/clear_refs", "w");
+
+    if (clearRefs != NULL)
+    {
+        fputs("5", clearRefs);
+        fclose(clearRefs);
+    }
+#endif
+}
@@ -0,0 +1,41 @@
+#ifndef SYSTEMRESOURCES_H
+#define SYSTEMRESOURCES_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Amount of memory (in bytes) this process can still allocate before running into trouble.
+// On Linux this is the smallest of the system-wide "MemAvailable" (/proc/meminfo) and the headroom
+// left below the cgroup's memory limit (v2 "memory.max" or v1 "memory.limit_in_bytes"), so that
+// running inside a container with a memory limit does not get the process OOM-killed.
+size_t availableMemory();
+
+// Number of CPU cores this process may actually use: the affinity mask and the cgroup's CPU quota
+// (v2 "cpu.max" or v1 "cpu.cfs_quota_us" / "cpu.cfs_period_us") are taken into account.
+unsigned int availableCores();
+
+// The CPUs this process may run on, grouped by NUMA node (nodes without any such CPU, e.g. memory-only ones, are left out).
+// Machines without NUMA, or whose topology the OS doesn't expose, are reported as a single node.
+std::vector<std::vector<unsigned int>> numaNodes();
+
+// Process-wide counters (all threads together) at one point in time: the difference between two samples is what happened in between.
+// Counters the OS doesn't provide stay 0 (Windows has neither major faults nor context switches, and counts all page faults as minor ones).
+struct ResourceUsage
+{
+    double cpuSeconds = 0.0;
+    uint64_t residentBytes = 0;
+    uint64_t peakResidentBytes = 0;
+    uint64_t minorFaults = 0;
+    uint64_t majorFaults = 0;
+    uint64_t voluntaryContextSwitches = 0;
+    uint64_t involuntaryContextSwitches = 0;
+};
+
+ResourceUsage resourceUsage();
+
+// Lowers the peak resident set size to the current one, so that the next peak can be measured on its own.
+// Only possible on Linux (elsewhere, peakResidentBytes remains the lifetime peak).
+void resetPeakResidentBytes();
+
+#endif // SYSTEMRESOURCES_H
@@ -1,3 +1,4 @@
+#include "cli.h"
 #include "constants.h"
 #include "mainwindow.h"
 
@@ -11,6 +12,11 @@ int main(int argc, char* argv[])
     QApplication::setOrganizationName(Constants::orgName);
     QApplication::setOrganizationDomain(Constants::orgDomain);
 
+    if (isHeadlessInvocation(argc, argv))
+    {
+        return runHeadless(argc, argv);
+    }
+
     QApplication application(argc, argv);
     application.setWindowIcon(QIcon(":/img/icon.png"));
 
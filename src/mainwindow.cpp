@@ -1,91 +1,73 @@
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
 
-#ifdef _WIN32
-#define WIN32_NO_STATUS
-#include <windows.h>
-#undef WIN32_NO_STATUS
-#include <bcrypt.h>
-#endif
-
 #include "constants.h"
+#include "saltgenerator.h"
+#include "argon2progress.h"
+#include "argon2kernels.h"
+#include "systemresources.h"
+#include "lanepool.h"
+#include "calibration.h"
+#include "phcstring.h"
+#include "matrixfile.h"
+#include "batchtablemodel.h"
 
 #include <argon2.h>
 
+#include <cmath>
+#include <algorithm>
+
+#include <QFile>
 #include <QTimer>
 #include <QDialog>
-#include <QDateTime>
+#include <QHeaderView>
+#include <QSaveFile>
+#include <QFileDialog>
+#include <QFontDatabase>
 #include <QSettings>
 #include <QMessageBox>
 #include <QStyleFactory>
-#include <QCryptographicHash>
-
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-static int (*hashFunction)( /// This is the function pointer that holds a reference to the selected Argon2 algorithm variant selected by the user. ///////
-        const uint32_t, //////// Time cost paramter (n of iterations)   ///////////////////////////////////////////////////////////////////////////////////
-        const uint32_t, //////// Memory cost parameter (in KiB)         ///////////////////////////////////////////////////////////////////////////////////
-        const uint32_t, //////// Parallelism parameter (n of threads)   ///////////////////////////////////////////////////////////////////////////////////
-        const void*, /////////// The password to hash with Argon2       ///////////////////////////////////////////////////////////////////////////////////
-        const size_t, ////////// Length of the passed password          ///////////////////////////////////////////////////////////////////////////////////
-        const void*, /////////// Salt bytes to use for hashing (these should be random)   /////////////////////////////////////////////////////////////////
-        const size_t, ////////// Length of the passed salt bytes array   //////////////////////////////////////////////////////////////////////////////////
-        const size_t, ////////// Desired hash length in bytes            //////////////////////////////////////////////////////////////////////////////////
-        char*, ///////////////// Output buffer for the encoded hash      //////////////////////////////////////////////////////////////////////////////////
-        const size_t /////////// Size of the output buffer in bytes               /////////////////////////////////////////////////////////////////////////
-        ) /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-        = &argon2id_hash_encoded; /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-// Read n bytes from /dev/urandom (or BCryptGenRandom on Windows).
-static const inline void dev_urandom(uint8_t* outputBuffer, const size_t outputBufferSize)
-{
-    if (outputBuffer != NULL && outputBufferSize > 0)
-    {
-#ifdef _WIN32
-        BCryptGenRandom(NULL, outputBuffer, (ULONG)outputBufferSize, BCRYPT_USE_SYSTEM_PREFERRED_RNG);
-#else
-        FILE* rnd = fopen("/dev/urandom", "r");
-        if (rnd != NULL)
-        {
-            const size_t n = fread(outputBuffer, sizeof(unsigned char), outputBufferSize, rnd);
-            if (n != outputBufferSize)
-            {
-                fprintf(stderr, "Argon2UI: Warning! Only %zu bytes out of %zu have been read from /dev/urandom\n", n, outputBufferSize);
-            }
-            fclose(rnd);
-        }
-#endif
-    }
-}
 
-static const inline argon2_type argonAlgoFromEncodedHashString(const char* encodedHashUtf8)
-{
-    if (strstr(encodedHashUtf8, "$argon2id$") == encodedHashUtf8)
-        return Argon2_id;
+// The Argon2 algorithm variant currently selected by the user.
+static argon2_type hashAlgorithm = Argon2_id;
 
-    if (strstr(encodedHashUtf8, "$argon2i$") == encodedHashUtf8)
-        return Argon2_i;
+static QString formatMiB(double mebibytes)
+{
+    return mebibytes >= 1024.0 ? QString("%1 GiB").arg(mebibytes / 1024.0, 0, 'f', std::fmod(mebibytes, 1024.0) == 0.0 ? 0 : 1) : QString("%1 MiB").arg(mebibytes, 0, 'f', 0);
+}
 
-    return Argon2_d;
+static QString formatDuration(double seconds)
+{
+    const long long total = std::llround(seconds);
+    return QString("%1:%2:%3").arg(total / 3600).arg(total / 60 % 60, 2, 10, QChar('0')).arg(total % 60, 2, 10, QChar('0'));
 }
 
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::MainWindow) /////////////////
 {
     ui->setupUi(this);
 
+    ui->kernelComboBox->addItem("Automatic (fastest available)", QVariant(QString("auto")));
+
+    for (const char* kernel : argon2_available_kernels())
+    {
+        ui->kernelComboBox->addItem(QString(kernel), QVariant(QString(kernel)));
+    }
+
+    if (argon2_kernel_overridden_by_environment())
+    {
+        ui->kernelComboBox->setEnabled(false);
+        ui->kernelComboBox->setToolTip(QString("Forced to \"%1\" by the %2 environment variable.").arg(argon2_active_kernel()).arg(ARGON2_KERNEL_ENVIRONMENT_VARIABLE));
+    }
+
     loadSettings();
+    updateKernelLabel();
+    updateMemoryWarning();
+    loadCostModelForActiveKernel();
 
 #ifdef __APPLE__
     setAttribute(Qt::WA_MacSmallSize);
 #endif
 
-    uint8_t initialEntropy[32];
-    dev_urandom(initialEntropy, sizeof(initialEntropy));
-    userEntropy = QString(reinterpret_cast<char*>(initialEntropy));
-    appendEntropy(QDateTime::currentDateTime().toString(Qt::DateFormat::RFC2822Date));
-
     ui->hashAlgorithmButtonGroup->setId(ui->argon2idRadioButton, 0);
     ui->hashAlgorithmButtonGroup->setId(ui->argon2iRadioButton, 1);
     ui->hashAlgorithmButtonGroup->setId(ui->argon2dRadioButton, 2);
@@ -100,11 +82,52 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::MainWi
 
     QObject::connect(ui->hashAlgorithmButtonGroup, SIGNAL(idClicked(int)), this, SLOT(onChangedHashAlgorithm(int)));
 
+    ui->hashProgressBar->hide();
+    ui->cancelHashButton->hide();
+
+    ui->statsWidget->hide();
+    ui->latencyHistogramLabel->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    batchModel = new BatchTableModel(this);
+    ui->batchTableView->setModel(batchModel);
+
+    // With millions of rows, the view mustn't size any section by its contents (that would materialize every row).
+    ui->batchTableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    ui->batchTableView->verticalHeader()->setDefaultSectionSize(fontMetrics().height() + 6);
+    ui->batchTableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    ui->batchTableView->setColumnWidth(BatchTableModel::LineColumn, fontMetrics().horizontalAdvance(QString("0000000000")));
+    ui->batchTableView->setColumnWidth(BatchTableModel::StatusColumn, fontMetrics().horizontalAdvance(QString("Mismatch0000")));
+
+    // The model picks up the batch's changes a few times per second, in one signal each, instead of once per finished row.
+    batchTimer = new QTimer(this);
+    batchTimer->setInterval(250);
+    QObject::connect(batchTimer, &QTimer::timeout, this, &MainWindow::updateBatchStatus);
+
     on_tabWidget_currentChanged(0);
 }
 
 MainWindow::~MainWindow()
 {
+    if (tuningThread.joinable())
+    {
+        tuner->cancel();
+        tuningThread.join();
+    }
+
+    if (costModelThread.joinable())
+    {
+        costModelThread.join();
+    }
+
+    // The batch stops submitting jobs (and its running ones abort) before the engine goes away.
+    if (batch)
+    {
+        batch->cancel();
+    }
+
+    // Hash jobs that are still waiting in the engine's queue are skipped and the running ones are aborted as soon as possible.
+    cancelledHashJobsWatermark = UINT64_MAX;
+
     QSettings settings;
 
     const bool saveParams = ui->saveParametersOnQuitCheckBox->isChecked();
@@ -115,7 +138,7 @@ MainWindow::~MainWindow()
     {
         settings.setValue(Constants::Settings::hashAlgo, QVariant(ui->hashAlgorithmButtonGroup->checkedId()));
         settings.setValue(Constants::Settings::timeCost, QVariant(ui->timeCostHorizontalSlider->value()));
-        settings.setValue(Constants::Settings::memoryCost, QVariant(ui->memoryCostHorizontalSlider->value()));
+        settings.setValue(Constants::Settings::memoryCost, QVariant(memoryCostMiB()));
         settings.setValue(Constants::Settings::parallelism, QVariant(ui->parallelismHorizontalSlider->value()));
         settings.setValue(Constants::Settings::hashLength, QVariant(ui->hashLengthHorizontalSlider->value()));
     }
@@ -129,6 +152,18 @@ MainWindow::~MainWindow()
     settings.setValue(Constants::Settings::saveHashParametersOnQuit, QVariant(saveParams));
     settings.setValue(Constants::Settings::saveWindowSizeOnQuit, QVariant(saveWindow));
     settings.setValue(Constants::Settings::selectTextOnFocus, QVariant(selectTextOnFocus));
+    settings.setValue(Constants::Settings::kernel, ui->kernelComboBox->currentData());
+    settings.setValue(Constants::Settings::largeMemoryMode, QVariant(largeMemoryMode));
+    settings.setValue(Constants::Settings::matrixFileEnabled, QVariant(ui->matrixFileCheckBox->isChecked()));
+    settings.setValue(Constants::Settings::matrixFilePath, QVariant(ui->matrixFileLineEdit->text()));
+    settings.setValue(Constants::Settings::tuneTargetLatency, QVariant(ui->tuneTargetLatencySpinBox->value()));
+    settings.setValue(Constants::Settings::tuneConcurrency, QVariant(ui->tuneConcurrencySpinBox->value()));
+    settings.setValue(Constants::Settings::tuneMemoryBudget, QVariant(ui->tuneMemoryBudgetSpinBox->value()));
+
+    if (costModel.valid())
+    {
+        saveCostModel(settings, engine.cores(), costModel);
+    }
 
     delete ui;
 }
@@ -146,6 +181,20 @@ void MainWindow::loadSettings()
     ui->saveWindowSizeOnQuitCheckBox->setChecked(saveWindow);
     ui->selectTextOnFocusCheckBox->setChecked(selectTextOnFocus);
 
+    const int kernelIndex = ui->kernelComboBox->findData(settings.value(Constants::Settings::kernel, QVariant(Constants::Settings::DefaultValues::kernel)));
+    ui->kernelComboBox->setCurrentIndex(kernelIndex != -1 ? kernelIndex : 0);
+
+    ui->tuneTargetLatencySpinBox->setValue(settings.value(Constants::Settings::tuneTargetLatency, QVariant(Constants::Settings::DefaultValues::tuneTargetLatencyMs)).toInt());
+    ui->tuneConcurrencySpinBox->setValue(settings.value(Constants::Settings::tuneConcurrency, QVariant(Constants::Settings::DefaultValues::tuneConcurrency)).toInt());
+    ui->tuneMemoryBudgetSpinBox->setValue(settings.value(Constants::Settings::tuneMemoryBudget, QVariant(Constants::Settings::DefaultValues::tuneMemoryBudgetMiB)).toInt());
+    ui->calibrationLabel->setText(describeCalibration(settings));
+
+    ui->matrixFileLineEdit->setText(settings.value(Constants::Settings::matrixFilePath, QVariant(QString())).toString());
+    ui->matrixFileCheckBox->setChecked(settings.value(Constants::Settings::matrixFileEnabled, QVariant(Constants::Settings::DefaultValues::matrixFileEnabled)).toBool());
+
+    // Before the sliders, so that their saved values aren't clamped to the regular mode's ranges.
+    ui->largeMemoryModeCheckBox->setChecked(settings.value(Constants::Settings::largeMemoryMode, QVariant(Constants::Settings::DefaultValues::largeMemoryMode)).toBool());
+
     if (saveParams)
     {
         switch (settings.value(Constants::Settings::hashAlgo, QVariant(0)).toInt())
@@ -162,7 +211,7 @@ void MainWindow::loadSettings()
         }
 
         ui->timeCostHorizontalSlider->setValue(settings.value(Constants::Settings::timeCost, QVariant(Constants::Settings::DefaultValues::timeCost)).toInt());
-        ui->memoryCostHorizontalSlider->setValue(settings.value(Constants::Settings::memoryCost, QVariant(Constants::Settings::DefaultValues::memoryCostMiB)).toInt());
+        setMemoryCostMiB(settings.value(Constants::Settings::memoryCost, QVariant(Constants::Settings::DefaultValues::memoryCostMiB)).toInt());
         ui->parallelismHorizontalSlider->setValue(settings.value(Constants::Settings::parallelism, QVariant(Constants::Settings::DefaultValues::parallelism)).toInt());
         ui->hashLengthHorizontalSlider->setValue(settings.value(Constants::Settings::hashLength, QVariant(Constants::Settings::DefaultValues::hashLength)).toInt());
     }
@@ -178,12 +227,7 @@ void MainWindow::loadSettings()
 
 void MainWindow::appendEntropy(const QString& additionalEntropy)
 {
-    const QString timestamp = QDateTime::currentDateTime().toString(Qt::DateFormat::ISODateWithMs);
-
-    QCryptographicHash sha256(QCryptographicHash::Algorithm::Sha256);
-    sha256.addData((userEntropy + additionalEntropy + timestamp).toUtf8());
-
-    userEntropy = QString(sha256.result());
+    userEntropy.mix(additionalEntropy.constData(), static_cast<size_t>(additionalEntropy.size()) * sizeof(QChar));
 }
 
 void MainWindow::on_tabWidget_currentChanged(int index)
@@ -223,50 +267,184 @@ void MainWindow::on_clearButton_clicked()
 
 void MainWindow::on_hashButton_clicked()
 {
-    if (busy)
+    if (pendingHashJobs == 0)
     {
-        return;
+        ui->encodedHashTextEdit->clear();
+        ui->hashProgressBar->setValue(0);
+        ui->hashProgressBar->show();
+        ui->cancelHashButton->show();
     }
 
-    busy = true;
+    uint8_t salt[32] = { 0x00 };
 
-    ui->encodedHashTextEdit->setText("Working on it... CPU go brr!");
-    repaint();
+    random_salt(salt, 16);
+    userEntropy.extract(salt + 16, 16);
 
-    uint8_t salt[32] = { 0x00 };
-    char encodedHash[1024] = { 0x00 };
+    Argon2HashRequest request;
+    request.parameters = sliderParameters();
+    request.password = ui->passwordLineEdit->text().toUtf8().toStdString();
+    request.salt = std::string(reinterpret_cast<const char*>(salt), sizeof(salt));
 
-    dev_urandom(salt, 16);
-    memcpy(salt + 16, userEntropy.constData(), 16);
+    if (ui->matrixFileCheckBox->isChecked() && !ui->matrixFileLineEdit->text().isEmpty())
+    {
+        request.matrixFile = ui->matrixFileLineEdit->text().toUtf8().toStdString();
 
-    QString output;
-    const QString password = ui->passwordLineEdit->text();
+        // An interrupted hash can only be resumed with its own salt: the engine takes it from the checkpoint.
+        if (!Argon2MatrixFile::checkpointSalt(request.matrixFile).empty())
+        {
+            request.salt.clear();
+        }
+    }
+
+    if (ui->traceNextHashCheckBox->isChecked())
+    {
+        ui->traceNextHashCheckBox->setChecked(false);
+        request.trace = std::make_shared<Argon2Trace>();
+    }
+
+    const std::shared_ptr<Argon2Trace> trace = request.trace;
+
+    const quint64 jobId = nextJobId++;
+    const char* hashFunctionName = getHashFunctionName();
+    const uint64_t memoryTraffic = Argon2Engine::memoryTraffic(request.parameters);
+    const Argon2Parameters parameters = request.parameters;
+    const double predictedSeconds = costModel.predict(parameters, engine).seconds;
+
+    // Shared by both callbacks: started by the first progress callback, on the worker thread that runs the job.
+    const auto meter = std::make_shared<Argon2JobMeter>("hash", parameters, engine.hashCost(parameters).cores);
+
+    latestHashJobId = jobId;
+
+    ++pendingHashJobs;
+    updateQueueStatus();
+
+    // The callbacks run on the engine's threads: everything that touches the UI is posted back to the GUI thread.
+
+    const auto onProgress = [this, jobId, meter](uint32_t slicesDone, uint32_t slicesTotal) {
+        if (jobId <= cancelledHashJobsWatermark.load())
+        {
+            return false;
+        }
+
+        if (slicesDone == 0)
+        {
+            meter->start();
+        }
+
+        QMetaObject::invokeMethod(this, [this, jobId, slicesDone, slicesTotal] { onHashProgress(jobId, static_cast<int>(slicesDone), static_cast<int>(slicesTotal)); }, Qt::QueuedConnection);
+        return true;
+    };
+
+    const auto onFinished = [this, jobId, hashFunctionName, memoryTraffic, parameters, predictedSeconds, meter, trace](const Argon2HashResult& result) {
+        const Argon2JobTelemetry job = meter->finish(result.error);
+
+        QString output;
+        QString statistics;
+
+        switch (result.error)
+        {
+            case ARGON2_OK:
+                output = QString::fromStdString(result.encodedHash);
+
+                if (result.seconds > 0.0)
+                {
+                    statistics = QString("Hashed in %1 s (%2 GiB/s of memory bandwidth)").arg(result.seconds, 0, 'f', 2).arg(static_cast<double>(memoryTraffic) / result.seconds / (1024.0 * 1024.0 * 1024.0), 0, 'f', 1);
+                }
+
+                break;
+            case ARGON2_ABORTED:
+                output = QString("Cancelled.");
+                break;
+            case ARGON2_CHECKPOINT_MISMATCH:
+                output = QString("The matrix file holds an interrupted hash of another password (or with other parameters). Hash that one to completion or pick another file.");
+                break;
+            default: {
+                char error[1024] = { 0x00 };
+                snprintf(error, sizeof(error), "Argon2 hash generation failed! \"%s\" function call returned: %d\n", hashFunctionName, result.error);
+                fprintf(stderr, "%s", error);
+                output = QString(error);
+                break;
+            }
+        }
 
-    const QByteArray passwordUtf8Bytes = password.toUtf8();
-    const char* passwordUtf8 = passwordUtf8Bytes.constData();
-    const size_t passwordUtf8Length = strlen(passwordUtf8); // This is OK and perfectly safe because, according to Qt documentation, ".constData()" returns a NUL-terminated buffer.
+        QMetaObject::invokeMethod(this, [this, jobId, error = result.error, seconds = result.seconds, output, statistics, parameters, predictedSeconds, job, trace] {
+            onHashed(jobId, error, output, statistics);
+            onJobMeasured(job);
 
-    const int argon2_timeCost = ui->timeCostHorizontalSlider->value();
-    const int argon2_memoryCostMiB = ui->memoryCostHorizontalSlider->value();
-    const int argon2_parallelism = ui->parallelismHorizontalSlider->value();
-    const int hashLength = ui->hashLengthHorizontalSlider->value();
+            if (error == ARGON2_OK)
+            {
+                onHashMeasured(parameters, predictedSeconds, seconds);
+            }
 
-    const int r = hashFunction(static_cast<uint32_t>(argon2_timeCost), static_cast<uint32_t>(argon2_memoryCostMiB) * 1024, argon2_parallelism, passwordUtf8, passwordUtf8Length, salt, sizeof(salt), static_cast<size_t>(hashLength), encodedHash, sizeof(encodedHash));
+            // (Its matrix is wiped in the background, most likely long before a file is picked.)
+            if (trace && error == ARGON2_OK)
+            {
+                exportFile("Save the hash's trace", "Chrome trace (*.json)", trace->json());
+            }
+        }, Qt::QueuedConnection);
+    };
+
+    engine.hash(std::move(request), onProgress, onFinished);
+}
 
-    if (r == ARGON2_OK)
+void MainWindow::on_cancelHashButton_clicked()
+{
+    quint64 watermark = cancelledHashJobsWatermark.load();
+
+    while (watermark < latestHashJobId && !cancelledHashJobsWatermark.compare_exchange_weak(watermark, latestHashJobId))
     {
-        output = QString(encodedHash);
     }
-    else
+}
+
+void MainWindow::onHashProgress(quint64 jobId, int slicesDone, int slicesTotal)
+{
+    // With several hash jobs running at once, the progress bar follows the most recently submitted one.
+    if (jobId != latestHashJobId)
+    {
+        return;
+    }
+
+    ui->hashProgressBar->setRange(0, slicesTotal);
+    ui->hashProgressBar->setValue(slicesDone);
+}
+
+void MainWindow::onHashed(quint64 jobId, int, const QString& output, const QString& statistics)
+{
+    --pendingHashJobs;
+    updateQueueStatus();
+
+    if (pendingHashJobs == 0)
+    {
+        ui->hashProgressBar->hide();
+        ui->cancelHashButton->hide();
+    }
+
+    // Jobs can complete out of order: never let an older hash overwrite a newer one.
+    if (jobId < lastDisplayedHashJobId)
     {
-        char error[1024] = { 0x00 };
-        snprintf(error, sizeof(error), "Argon2 hash generation failed! \"%s\" function call returned: %d\n", getHashFunctionName(), r);
-        fprintf(stderr, "%s", error);
-        output = QString(error);
+        return;
     }
 
-    busy = false;
+    lastDisplayedHashJobId = jobId;
     ui->encodedHashTextEdit->setText(output);
+
+    if (pendingHashJobs + pendingVerifyJobs == 0 && !statistics.isEmpty())
+    {
+        ui->statusbar->showMessage(statistics);
+    }
+}
+
+void MainWindow::updateQueueStatus()
+{
+    const int pendingJobs = pendingHashJobs + pendingVerifyJobs;
+
+    if (pendingJobs == 0)
+    {
+        ui->statusbar->clearMessage();
+        return;
+    }
+
+    ui->statusbar->showMessage(QString("%1 job%2 in progress...").arg(pendingJobs).arg(Constants::plural[pendingJobs > 1]));
 }
 
 const char* MainWindow::getHashFunctionName() const
@@ -287,15 +465,17 @@ void MainWindow::onChangedHashAlgorithm(int id)
     switch (id)
     {
         default:
-            hashFunction = &argon2id_hash_encoded;
+            hashAlgorithm = Argon2_id;
             break;
         case 1:
-            hashFunction = &argon2i_hash_encoded;
+            hashAlgorithm = Argon2_i;
             break;
         case 2:
-            hashFunction = &argon2d_hash_encoded;
+            hashAlgorithm = Argon2_d;
             break;
     }
+
+    updateCostPrediction();
 }
 
 void MainWindow::on_timeCostHorizontalSlider_valueChanged(int value)
@@ -303,13 +483,16 @@ void MainWindow::on_timeCostHorizontalSlider_valueChanged(int value)
     QString newLabelText = QString("Time cost (%1 iteration%2)").arg(value).arg(Constants::plural[value > 1]);
     ui->timeCostLabel->setText(newLabelText);
     appendEntropy(newLabelText);
+    updateCostPrediction();
 }
 
-void MainWindow::on_memoryCostHorizontalSlider_valueChanged(int value)
+void MainWindow::on_memoryCostHorizontalSlider_valueChanged(int)
 {
-    QString newLabelText = QString("Memory cost (%1 MiB)").arg(value);
+    QString newLabelText = QString("Memory cost (%1)").arg(formatMiB(memoryCostMiB()));
     ui->memoryCostLabel->setText(newLabelText);
     appendEntropy(newLabelText);
+    updateMemoryWarning();
+    updateCostPrediction();
 }
 
 void MainWindow::on_parallelismHorizontalSlider_valueChanged(int value)
@@ -317,6 +500,7 @@ void MainWindow::on_parallelismHorizontalSlider_valueChanged(int value)
     QString newLabelText = QString("Parallelism (%1 thread%2)").arg(value).arg(Constants::plural[value > 1]);
     ui->parallelismLabel->setText(newLabelText);
     appendEntropy(newLabelText);
+    updateCostPrediction();
 }
 
 void MainWindow::on_hashLengthHorizontalSlider_valueChanged(int value)
@@ -324,6 +508,7 @@ void MainWindow::on_hashLengthHorizontalSlider_valueChanged(int value)
     QString newLabelText = QString("Hash length (%1 B)").arg(value);
     ui->hashLengthLabel->setText(newLabelText);
     appendEntropy(newLabelText);
+    updateCostPrediction();
 }
 
 void MainWindow::on_encodedHashTextEdit_selectionChanged()
@@ -340,28 +525,80 @@ void MainWindow::on_clearVerificationFieldsButton_clicked()
 
 void MainWindow::on_verifyButton_clicked()
 {
-    ui->verificationResultLabel->clear();
-    repaint();
+    ui->verificationResultLabel->setText("Verifying...");
 
-    const QString password = ui->inputPasswordLineEdit->text();
-    const QString encodedHash = ui->inputTextEdit->toPlainText().replace(" ", "").replace("\t", "").replace("\n", "").replace("\r\n", "");
+    // Pasted hashes often come wrapped or indented: every whitespace character is dropped in a single pass.
+    const QByteArray input = ui->inputTextEdit->toPlainText().toUtf8();
 
-    const QByteArray passwordUtf8Bytes = password.toUtf8();
-    const char* passwordUtf8 = passwordUtf8Bytes.constData();
-    const size_t passwordUtf8Length = strlen(passwordUtf8);
+    std::string encodedHash;
+    encodedHash.reserve(static_cast<size_t>(input.size()));
 
-    const QByteArray encodedHashUtf8Bytes = encodedHash.toUtf8();
-    const char* encodedHashUtf8 = encodedHashUtf8Bytes.constData();
+    for (const char c : input)
+    {
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+        {
+            encodedHash.push_back(c);
+        }
+    }
 
-    const int r = argon2_verify(encodedHashUtf8, passwordUtf8, passwordUtf8Length, argonAlgoFromEncodedHashString(encodedHashUtf8));
+    const quint64 jobId = nextJobId++;
 
-    if (r == ARGON2_OK)
+    ++pendingVerifyJobs;
+    updateQueueStatus();
+
+    // Just for the telemetry (malformed hashes are rejected by the engine).
+    PhcString phc;
+    Argon2Parameters parameters;
+
+    if (parsePhcString(encodedHash, phc))
+    {
+        parameters.type = phc.type;
+        parameters.timeCost = phc.timeCost;
+        parameters.memoryCostKiB = phc.memoryCostKiB;
+        parameters.parallelism = phc.parallelism;
+        parameters.hashLength = static_cast<uint32_t>(phc.hash.size() * 3 / 4);
+    }
+
+    const auto meter = std::make_shared<Argon2JobMeter>("verify", parameters, engine.hashCost(parameters).cores);
+
+    const auto onProgress = [meter](uint32_t slicesDone, uint32_t) {
+        if (slicesDone == 0)
+        {
+            meter->start();
+        }
+
+        return true;
+    };
+
+    engine.verify(std::move(encodedHash), ui->inputPasswordLineEdit->text().toUtf8().toStdString(), onProgress, [this, jobId, meter](int result) {
+        const Argon2JobTelemetry job = meter->finish(result);
+
+        QMetaObject::invokeMethod(this, [this, jobId, result, job] {
+            onVerified(jobId, result);
+            onJobMeasured(job);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::onVerified(quint64 jobId, int result)
+{
+    --pendingVerifyJobs;
+    updateQueueStatus();
+
+    if (jobId < lastDisplayedVerifyJobId)
+    {
+        return;
+    }
+
+    lastDisplayedVerifyJobId = jobId;
+
+    if (result == ARGON2_OK)
     {
         ui->verificationResultLabel->setText("✅  Verification successful.\nArgon2 hash matches the entered password.");
     }
     else
     {
-        ui->verificationResultLabel->setText(QString("❌  Verification failed.\n\"argon2_verify\" function call returned error code %1.").arg(r));
+        ui->verificationResultLabel->setText(QString("❌  Verification failed.\n\"argon2_verify\" function call returned error code %1.").arg(result));
     }
 }
 
@@ -396,9 +633,16 @@ void MainWindow::on_factoryResetPushButton_clicked()
     ui->saveParametersOnQuitCheckBox->setChecked(Constants::Settings::DefaultValues::saveHashParametersOnQuit);
     ui->saveWindowSizeOnQuitCheckBox->setChecked(Constants::Settings::DefaultValues::saveWindowSizeOnQuit);
     ui->selectTextOnFocusCheckBox->setChecked(Constants::Settings::DefaultValues::selectTextOnFocus);
+    ui->kernelComboBox->setCurrentIndex(0);
+    ui->largeMemoryModeCheckBox->setChecked(Constants::Settings::DefaultValues::largeMemoryMode);
+    ui->matrixFileCheckBox->setChecked(Constants::Settings::DefaultValues::matrixFileEnabled);
+    ui->matrixFileLineEdit->clear();
+    ui->tuneTargetLatencySpinBox->setValue(Constants::Settings::DefaultValues::tuneTargetLatencyMs);
+    ui->tuneConcurrencySpinBox->setValue(Constants::Settings::DefaultValues::tuneConcurrency);
+    ui->tuneMemoryBudgetSpinBox->setValue(Constants::Settings::DefaultValues::tuneMemoryBudgetMiB);
 
     ui->timeCostHorizontalSlider->setValue(Constants::Settings::DefaultValues::timeCost);
-    ui->memoryCostHorizontalSlider->setValue(Constants::Settings::DefaultValues::memoryCostMiB);
+    setMemoryCostMiB(Constants::Settings::DefaultValues::memoryCostMiB);
     ui->parallelismHorizontalSlider->setValue(Constants::Settings::DefaultValues::parallelism);
     ui->hashLengthHorizontalSlider->setValue(Constants::Settings::DefaultValues::hashLength);
 
@@ -409,6 +653,529 @@ void MainWindow::on_factoryResetPushButton_clicked()
     resize(minimumWidth(), minimumHeight());
 }
 
+void MainWindow::on_kernelComboBox_currentIndexChanged(int)
+{
+    // The cost model (and its corrections so far) belongs to the previous kernel.
+    if (costModel.valid())
+    {
+        QSettings settings;
+        saveCostModel(settings, engine.cores(), costModel);
+    }
+
+    argon2_select_kernel(ui->kernelComboBox->currentData().toString().toUtf8().constData());
+    updateKernelLabel();
+    loadCostModelForActiveKernel();
+}
+
+void MainWindow::updateKernelLabel()
+{
+    const char* how = argon2_kernel_overridden_by_environment() ? "forced via " ARGON2_KERNEL_ENVIRONMENT_VARIABLE : ui->kernelComboBox->currentIndex() == 0 ? "auto-detected" : "selected in the settings";
+    ui->aboutKernelLabel->setText(QString("Argon2 kernel: %1 (%2)").arg(argon2_active_kernel()).arg(how));
+}
+
+void MainWindow::on_largeMemoryModeCheckBox_toggled(bool checked)
+{
+    applyLargeMemoryMode(checked);
+}
+
+void MainWindow::on_matrixFileCheckBox_toggled(bool checked)
+{
+    ui->matrixFileLineEdit->setEnabled(checked);
+    ui->matrixFileBrowseButton->setEnabled(checked);
+}
+
+void MainWindow::on_matrixFileBrowseButton_clicked()
+{
+    // (Not confirming overwrites: a file that holds another hash's checkpoint is left alone anyway.)
+    const QString fileName = QFileDialog::getSaveFileName(this, "Keep the matrix in", ui->matrixFileLineEdit->text(), QString(), nullptr, QFileDialog::DontConfirmOverwrite);
+
+    if (!fileName.isEmpty())
+    {
+        ui->matrixFileLineEdit->setText(fileName);
+    }
+}
+
+int MainWindow::memoryCostMiB() const
+{
+    const int value = ui->memoryCostHorizontalSlider->value();
+    return largeMemoryMode ? static_cast<int>(std::lround(std::exp2(static_cast<double>(value) / Constants::LargeMemoryMode::memorySliderStepsPerDoubling))) : value;
+}
+
+// In large-memory mode, the slider only has a few steps per doubling: the value goes to the nearest one, or to the one below if roundDown is set.
+void MainWindow::setMemoryCostMiB(int memoryCostMiB, bool roundDown)
+{
+    // (The epsilon keeps exact powers of two on their own step despite log2's rounding errors.)
+    const double step = std::log2(std::max(memoryCostMiB, 1)) * Constants::LargeMemoryMode::memorySliderStepsPerDoubling;
+    const int value = largeMemoryMode ? static_cast<int>(roundDown ? std::floor(step + 1e-9) : std::lround(step)) : memoryCostMiB;
+    ui->memoryCostHorizontalSlider->setValue(value);
+
+    // Same slider position as before (e.g. after switching scales) means no valueChanged signal.
+    on_memoryCostHorizontalSlider_valueChanged(value);
+}
+
+void MainWindow::applyLargeMemoryMode(bool enabled)
+{
+    if (enabled == largeMemoryMode)
+    {
+        return;
+    }
+
+    const int currentMemoryCostMiB = memoryCostMiB();
+
+    largeMemoryMode = enabled;
+
+    if (enabled)
+    {
+        ui->memoryCostHorizontalSlider->setRange(0, static_cast<int>(std::lround(std::log2(Constants::LargeMemoryMode::maxMemoryCostMiB))) * Constants::LargeMemoryMode::memorySliderStepsPerDoubling);
+        ui->parallelismHorizontalSlider->setMaximum(Constants::LargeMemoryMode::maxParallelism);
+    }
+    else
+    {
+        ui->memoryCostHorizontalSlider->setRange(1, 128);
+        ui->parallelismHorizontalSlider->setMaximum(16);
+    }
+
+    setMemoryCostMiB(currentMemoryCostMiB);
+
+    LanePoolOptions laneOptions;
+    laneOptions.numaAware = enabled;
+    LanePool::shared().configure(laneOptions);
+}
+
+Argon2Parameters MainWindow::sliderParameters() const
+{
+    Argon2Parameters parameters;
+    parameters.type = hashAlgorithm;
+    parameters.timeCost = static_cast<uint32_t>(ui->timeCostHorizontalSlider->value());
+    parameters.memoryCostKiB = static_cast<uint32_t>(memoryCostMiB()) * 1024;
+    parameters.parallelism = static_cast<uint32_t>(ui->parallelismHorizontalSlider->value());
+    parameters.hashLength = static_cast<uint32_t>(ui->hashLengthHorizontalSlider->value());
+
+    return parameters;
+}
+
+void MainWindow::loadCostModelForActiveKernel()
+{
+    QSettings settings;
+
+    if (loadCostModel(settings, engine.cores(), costModel))
+    {
+        updateCostPrediction();
+        return;
+    }
+
+    costModel = Argon2CostModel();
+
+    // Unless one is being fitted already: once done, it notices if that was for another kernel.
+    if (!costModelThread.joinable())
+    {
+        const QString kernel(argon2_active_kernel());
+
+        costModelThread = std::thread([this, kernel] {
+            const Argon2CostModel model = Argon2CostModel::calibrate(engine);
+            QMetaObject::invokeMethod(this, [this, kernel, model] { onCostModelCalibrated(kernel, model); }, Qt::QueuedConnection);
+        });
+    }
+
+    updateCostPrediction();
+}
+
+void MainWindow::onCostModelCalibrated(const QString& kernel, const Argon2CostModel& model)
+{
+    costModelThread.join();
+
+    if (kernel != argon2_active_kernel())
+    {
+        loadCostModelForActiveKernel();
+        return;
+    }
+
+    costModel = model;
+
+    if (costModel.valid())
+    {
+        QSettings settings;
+        saveCostModel(settings, engine.cores(), costModel);
+    }
+
+    updateCostPrediction();
+}
+
+void MainWindow::onHashMeasured(const Argon2Parameters& parameters, double predictedSeconds, double seconds)
+{
+    if (!costModel.valid() || predictedSeconds <= 0.0 || seconds <= 0.0)
+    {
+        return;
+    }
+
+    lastCostComparison = QString("Last hash: %1 s (predicted: %2 s, %3%4%)").arg(seconds, 0, 'f', 2).arg(predictedSeconds, 0, 'f', 2).arg(seconds >= predictedSeconds ? "+" : "").arg(100.0 * (seconds - predictedSeconds) / predictedSeconds, 0, 'f', 0);
+
+    // Only hashes that (most likely) ran alone are representative: the ones that had to share the cores and memory bandwidth would skew the model.
+    if (pendingHashJobs + pendingVerifyJobs == 0)
+    {
+        costModel.observe(parameters, engine, seconds);
+    }
+
+    updateCostPrediction();
+}
+
+void MainWindow::updateCostPrediction()
+{
+    if (!costModel.valid())
+    {
+        ui->costPredictionLabel->setText(costModelThread.joinable() ? "Measuring this machine's hashing speed..." : "");
+        return;
+    }
+
+    const Argon2CostPrediction prediction = costModel.predict(sliderParameters(), engine);
+
+    QString text = QString("≈ %1 s per hash, %2 of memory, up to %3 hashes/s on this machine").arg(prediction.seconds, 0, 'f', prediction.seconds < 0.1 ? 3 : 2).arg(formatMiB(static_cast<double>(prediction.peakMemoryBytes) / (1024.0 * 1024.0))).arg(prediction.maxHashesPerSecond, 0, 'f', prediction.maxHashesPerSecond < 10.0 ? 1 : 0);
+
+    if (!lastCostComparison.isEmpty())
+    {
+        text += "\n" + lastCostComparison;
+    }
+
+    ui->costPredictionLabel->setText(text);
+}
+
+void MainWindow::onJobMeasured(const Argon2JobTelemetry& job)
+{
+    telemetry.record(job);
+
+    QString outcome;
+
+    switch (job.error)
+    {
+        case ARGON2_OK:
+            break;
+        case ARGON2_VERIFY_MISMATCH:
+            outcome = " (no match)";
+            break;
+        case ARGON2_ABORTED:
+            outcome = " (cancelled)";
+            break;
+        default:
+            outcome = QString(" (failed: %1)").arg(argon2_error_message(job.error));
+            break;
+    }
+
+    QString text = QString("Last %1%2: %3, t = %4, m = %5, p = %6, with the %7 kernel on %8 thread%9")
+                       .arg(job.operation)
+                       .arg(outcome)
+                       .arg(argon2_type2string(job.parameters.type, 0))
+                       .arg(job.parameters.timeCost)
+                       .arg(formatMiB(job.parameters.memoryCostKiB / 1024.0))
+                       .arg(job.parameters.parallelism)
+                       .arg(QString::fromStdString(job.kernel))
+                       .arg(job.threads)
+                       .arg(Constants::plural[job.threads > 1]);
+
+    if (job.pinnedThreads || job.numaAware)
+    {
+        text += QString(" (%1)").arg(job.pinnedThreads && job.numaAware ? "pinned, NUMA-aware" : job.pinnedThreads ? "pinned" : "NUMA-aware");
+    }
+
+    if (job.wallSeconds > 0.0)
+    {
+        text += QString(".\n%1 s wall, %2 s CPU, peak RSS +%3, %4 minor / %5 major page faults, %6 voluntary / %7 involuntary context switches")
+                    .arg(job.wallSeconds, 0, 'f', 3)
+                    .arg(job.cpuSeconds, 0, 'f', 3)
+                    .arg(formatMiB(static_cast<double>(job.peakRssDeltaBytes) / (1024.0 * 1024.0)))
+                    .arg(job.minorFaults)
+                    .arg(job.majorFaults)
+                    .arg(job.voluntaryContextSwitches)
+                    .arg(job.involuntaryContextSwitches);
+
+        if (job.concurrentJobs != 0)
+        {
+            text += QString(" (process-wide, while %1 other job%2 ran)").arg(job.concurrentJobs).arg(Constants::plural[job.concurrentJobs > 1]);
+        }
+    }
+
+    ui->lastJobStatsLabel->setText(text + ".");
+
+    // One row per bucket, from the fastest to the slowest one that has any jobs.
+    const std::vector<double>& bounds = Argon2TelemetryLog::bucketBounds();
+    const std::vector<size_t> histogram = telemetry.recentHistogram();
+
+    const auto first = std::find_if(histogram.begin(), histogram.end(), [](size_t count) { return count != 0; });
+    const auto last = std::find_if(histogram.rbegin(), histogram.rend(), [](size_t count) { return count != 0; });
+
+    if (first == histogram.end())
+    {
+        ui->latencyHistogramLabel->clear();
+        return;
+    }
+
+    const size_t mostJobs = *std::max_element(histogram.begin(), histogram.end());
+    QStringList rows(QString("Wall time of the last %1 jobs:").arg(telemetry.recent().size()));
+
+    for (size_t i = static_cast<size_t>(first - histogram.begin()); i < histogram.size() - static_cast<size_t>(last - histogram.rbegin()); ++i)
+    {
+        const QString bound = i < bounds.size() ? QString("≤ %1 s").arg(bounds[i]) : QString("> %1 s").arg(bounds.back());
+        rows << QString("%1 %2 %3").arg(bound, -9).arg(QString(static_cast<int>((histogram[i] * 20 + mostJobs - 1) / mostJobs), QChar(0x2588)), -20).arg(histogram[i]);
+    }
+
+    ui->latencyHistogramLabel->setText(rows.join('\n'));
+}
+
+void MainWindow::on_statsToggleButton_toggled(bool checked)
+{
+    ui->statsToggleButton->setArrowType(checked ? Qt::DownArrow : Qt::RightArrow);
+    ui->statsWidget->setVisible(checked);
+}
+
+void MainWindow::on_batchOpenButton_clicked()
+{
+    const QString fileName = QFileDialog::getOpenFileName(this, "Open a list", QString(), "Text files (*.txt);;All files (*)");
+
+    if (fileName.isEmpty())
+    {
+        return;
+    }
+
+    const BatchMode mode = ui->batchModeComboBox->currentIndex() == 0 ? BatchMode::Hash : BatchMode::Verify;
+
+    std::unique_ptr<BatchTable> opened = BatchTable::open(QFile::encodeName(fileName).constData(), mode);
+
+    if (!opened)
+    {
+        QMessageBox::warning(this, "Open failed", QString("Couldn't open \"%1\".").arg(fileName));
+        return;
+    }
+
+    // (The previous batch, if any, is cancelled and waits for its aborted jobs.)
+    batchModel->setBatch(opened.get());
+    batch = std::move(opened);
+
+    updateBatchStatus();
+}
+
+void MainWindow::on_batchStartButton_clicked()
+{
+    if (!batch || batch->progress().running)
+    {
+        return;
+    }
+
+    batch->start(engine, sliderParameters());
+    batchTimer->start();
+
+    updateBatchStatus();
+}
+
+void MainWindow::on_batchCancelButton_clicked()
+{
+    if (batch)
+    {
+        batch->cancel();
+    }
+
+    updateBatchStatus();
+}
+
+void MainWindow::on_batchExportButton_clicked()
+{
+    if (!batch)
+    {
+        return;
+    }
+
+    const QString fileName = QFileDialog::getSaveFileName(this, "Export the results", QString(), "Text files (*.txt)");
+
+    if (fileName.isEmpty())
+    {
+        return;
+    }
+
+    // Streamed out of the batch in chunks: the results never exist as a whole, neither as one string nor as one per row.
+    QSaveFile file(fileName);
+
+    const auto write = [&file](const char* data, size_t size) { return file.write(data, static_cast<qint64>(size)) == static_cast<qint64>(size); };
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text) || !batch->exportResults(write) || !file.commit())
+    {
+        QMessageBox::warning(this, "Export failed", QString("Couldn't write \"%1\": %2").arg(fileName).arg(file.errorString()));
+    }
+}
+
+void MainWindow::updateBatchStatus()
+{
+    if (!batch)
+    {
+        return;
+    }
+
+    // (Before the model's refresh: once the batch is seen as stopped, that refresh is its last.)
+    const BatchTableProgress progress = batch->progress();
+
+    batchModel->refresh();
+
+    ui->batchStartButton->setEnabled(!progress.running && progress.done < progress.rows);
+    ui->batchCancelButton->setEnabled(progress.running);
+    ui->batchExportButton->setEnabled(progress.done > 0);
+    ui->batchProgressBar->setValue(progress.rows > 0 ? static_cast<int>(progress.done * 1000 / progress.rows) : 0);
+
+    QString status = QString("%1 of %2 row%3 done").arg(progress.done).arg(progress.rows).arg(Constants::plural[progress.rows != 1]);
+
+    if (progress.failed > 0)
+    {
+        status += QString(", %1 failed").arg(progress.failed);
+    }
+
+    if (progress.done > 0 && progress.seconds > 0.0)
+    {
+        const double rowsPerSecond = static_cast<double>(progress.done) / progress.seconds;
+
+        status += QString(" - %1 rows/s").arg(rowsPerSecond, 0, 'f', rowsPerSecond < 10.0 ? 1 : 0);
+
+        if (progress.running)
+        {
+            status += QString(" - ETA %1").arg(formatDuration(static_cast<double>(progress.rows - progress.done) / rowsPerSecond));
+        }
+    }
+
+    ui->batchStatusLabel->setText(status);
+
+    if (!progress.running)
+    {
+        batchTimer->stop();
+    }
+}
+
+void MainWindow::exportFile(const QString& caption, const QString& filter, const std::string& contents)
+{
+    const QString fileName = QFileDialog::getSaveFileName(this, caption, QString(), filter);
+
+    if (fileName.isEmpty())
+    {
+        return;
+    }
+
+    QSaveFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text) || file.write(contents.data(), static_cast<qint64>(contents.size())) != static_cast<qint64>(contents.size()) || !file.commit())
+    {
+        QMessageBox::warning(this, "Export failed", QString("Couldn't write \"%1\": %2").arg(fileName).arg(file.errorString()));
+    }
+}
+
+void MainWindow::on_exportPrometheusButton_clicked()
+{
+    exportFile("Export Prometheus metrics", "Prometheus text format (*.prom *.txt)", telemetry.prometheus());
+}
+
+void MainWindow::on_exportJsonLinesButton_clicked()
+{
+    exportFile("Export JSON lines", "JSON lines (*.jsonl)", telemetry.jsonLines());
+}
+
+void MainWindow::on_tuneButton_clicked()
+{
+    if (tuningThread.joinable())
+    {
+        tuner->cancel();
+        ui->tuneButton->setEnabled(false);
+        return;
+    }
+
+    Argon2TunerOptions options;
+    options.type = hashAlgorithm;
+    options.hashLength = static_cast<uint32_t>(ui->hashLengthHorizontalSlider->value());
+    options.targetSeconds = ui->tuneTargetLatencySpinBox->value() / 1000.0;
+    options.concurrency = static_cast<unsigned int>(ui->tuneConcurrencySpinBox->value());
+    options.memoryBudget = static_cast<size_t>(ui->tuneMemoryBudgetSpinBox->value()) * 1024 * 1024;
+    options.maxTimeCost = static_cast<uint32_t>(ui->timeCostHorizontalSlider->maximum());
+    options.maxMemoryCostMiB = largeMemoryMode ? Constants::LargeMemoryMode::maxMemoryCostMiB : static_cast<uint32_t>(ui->memoryCostHorizontalSlider->maximum());
+    options.maxParallelism = static_cast<uint32_t>(ui->parallelismHorizontalSlider->maximum());
+
+    ui->tuneButton->setText("Stop tuning");
+    ui->statusbar->showMessage("Tuning...");
+
+    tuner = std::make_unique<Argon2Tuner>(engine, options);
+
+    tuningThread = std::thread([this, options] {
+        const Argon2TuningResult result = tuner->run([this](const Argon2CalibrationSample& sample) {
+            const QString status = QString("Tuning: t = %1, m = %2, p = %3 took %4 ms").arg(sample.parameters.timeCost).arg(formatMiB(sample.parameters.memoryCostKiB / 1024.0)).arg(sample.parameters.parallelism).arg(sample.seconds * 1000.0, 0, 'f', 0);
+            QMetaObject::invokeMethod(this, [this, status] { ui->statusbar->showMessage(status); }, Qt::QueuedConnection);
+            return true;
+        });
+
+        QMetaObject::invokeMethod(this, [this, options, result] { onTuned(options, result); }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::onTuned(const Argon2TunerOptions& options, const Argon2TuningResult& result)
+{
+    tuningThread.join();
+    tuner.reset();
+
+    ui->tuneButton->setText("Tune");
+    ui->tuneButton->setEnabled(true);
+
+    if (result.error == ARGON2_ABORTED)
+    {
+        ui->statusbar->showMessage("Tuning cancelled.");
+        return;
+    }
+
+    if (result.error != ARGON2_OK)
+    {
+        ui->statusbar->showMessage(QString("Tuning failed: %1").arg(argon2_error_message(result.error)));
+        return;
+    }
+
+    QSettings settings;
+    saveCalibration(settings, options, result, engine.cores());
+    ui->calibrationLabel->setText(describeCalibration(settings));
+
+    if (!result.metTarget)
+    {
+        ui->statusbar->clearMessage();
+        QMessageBox::warning(this, "Auto-tuning", QString("Even the cheapest parameters (1 MiB, a single pass) took %1 ms, which misses the %2 ms target: the sliders were left unchanged.").arg(result.seconds * 1000.0, 0, 'f', 0).arg(options.targetSeconds * 1000.0, 0, 'f', 0));
+        return;
+    }
+
+    // Rounded down onto the slider's scale: rounding up could take the hash past the latency target it was just measured against.
+    const int tunedMemoryCostMiB = static_cast<int>(result.parameters.memoryCostKiB / 1024);
+
+    ui->timeCostHorizontalSlider->setValue(static_cast<int>(result.parameters.timeCost));
+    setMemoryCostMiB(tunedMemoryCostMiB, true);
+    ui->parallelismHorizontalSlider->setValue(static_cast<int>(result.parameters.parallelism));
+
+    QString message = QString("Tuned to %1 ms per hash (%2 measurements).").arg(result.seconds * 1000.0, 0, 'f', 0).arg(result.samples.size());
+
+    if (memoryCostMiB() != tunedMemoryCostMiB)
+    {
+        message += QString(" The tuned memory cost (%1) was rounded down to the slider's %2.").arg(formatMiB(tunedMemoryCostMiB)).arg(formatMiB(memoryCostMiB()));
+    }
+
+    ui->statusbar->showMessage(message);
+}
+
+void MainWindow::updateMemoryWarning()
+{
+    const double requestedMiB = memoryCostMiB();
+    const double availableMiB = static_cast<double>(availableMemory()) / (1024.0 * 1024.0);
+    const double budgetMiB = static_cast<double>(engine.memoryBudget()) / (1024.0 * 1024.0);
+
+    if (requestedMiB > availableMiB)
+    {
+        ui->memoryWarningLabel->setText(QString("⚠️  Only %1 of memory is currently available: hashing would swap heavily, if it runs at all.").arg(formatMiB(std::floor(availableMiB))));
+    }
+    else if (requestedMiB > budgetMiB)
+    {
+        ui->memoryWarningLabel->setText(QString("⚠️  More than the %1 the hashing engine may use (3/4 of the memory that was available at startup): this hash would be refused.").arg(formatMiB(std::floor(budgetMiB))));
+    }
+    else
+    {
+        ui->memoryWarningLabel->clear();
+    }
+
+    ui->memoryWarningLabel->setVisible(!ui->memoryWarningLabel->text().isEmpty());
+}
+
 void MainWindow::onChangedFocus(QWidget*, QWidget* newlyFocusedWidget)
 {
     {
@@ -1,9 +1,23 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <atomic>
+#include <memory>
+#include <thread>
+
 #include <QMainWindow>
 
+#include "argon2engine.h"
+#include "argon2tuner.h"
+#include "argon2costmodel.h"
+#include "jobtelemetry.h"
+#include "saltgenerator.h"
+#include "batchtable.h"
+
+class BatchTableModel;
+
 QT_BEGIN_NAMESPACE
+class QTimer;
 namespace Ui {
 class MainWindow;
 }
@@ -51,15 +65,99 @@ private slots:
 
     void on_factoryResetPushButton_clicked();
 
+    void on_kernelComboBox_currentIndexChanged(int index);
+
+    void on_largeMemoryModeCheckBox_toggled(bool checked);
+
+    void on_matrixFileCheckBox_toggled(bool checked);
+
+    void on_matrixFileBrowseButton_clicked();
+
+    void on_tuneButton_clicked();
+
     void onChangedFocus(QWidget*, QWidget*);
 
+    void on_cancelHashButton_clicked();
+
+    void onHashProgress(quint64 jobId, int slicesDone, int slicesTotal);
+
+    void onHashed(quint64 jobId, int result, const QString& output, const QString& statistics);
+
+    void onVerified(quint64 jobId, int result);
+
+    void on_statsToggleButton_toggled(bool checked);
+
+    void on_exportPrometheusButton_clicked();
+
+    void on_exportJsonLinesButton_clicked();
+
+    void on_batchOpenButton_clicked();
+
+    void on_batchStartButton_clicked();
+
+    void on_batchCancelButton_clicked();
+
+    void on_batchExportButton_clicked();
+
 private:
     Ui::MainWindow* ui;
-    bool busy = false;
-    QString userEntropy;
+    EntropyPool userEntropy;
+
+    quint64 nextJobId = 1;
+    quint64 latestHashJobId = 0;
+    quint64 lastDisplayedHashJobId = 0;
+    quint64 lastDisplayedVerifyJobId = 0;
+    int pendingHashJobs = 0;
+    int pendingVerifyJobs = 0;
+
+    // Whether the memory cost slider currently has the large-memory mode's logarithmic scale.
+    bool largeMemoryMode = false;
+
+    // Every hash job whose ID is lower than or equal to this is cancelled: queued ones are skipped
+    // and running ones are aborted at their next slice boundary (checked from the engine's threads).
+    std::atomic<quint64> cancelledHashJobsWatermark { 0 };
+
+    // The auto-tuner runs on its own thread (it blocks on the engine's results), which the destructor cancels and joins before anything else.
+    std::unique_ptr<Argon2Tuner> tuner;
+    std::thread tuningThread;
+
+    // Fitted for the active kernel (invalid while that's being done, on costModelThread, which the destructor joins as well).
+    Argon2CostModel costModel;
+    std::thread costModelThread;
+
+    // How the last hash's measured time compared to its prediction.
+    QString lastCostComparison;
+
+    // Every hash and verify job's telemetry (recorded on the GUI thread, once the job is done).
+    Argon2TelemetryLog telemetry;
+
+    // The Batch tab's list, shown by batchModel (refreshed by batchTimer while it runs). Cancelled by the destructor before the engine is destroyed,
+    // the batch itself is destroyed after it: the callbacks of the batch's remaining jobs write into it.
+    std::unique_ptr<BatchTable> batch;
+    BatchTableModel* batchModel = nullptr;
+    QTimer* batchTimer = nullptr;
+
+    // Declared last, so that it's destroyed first: its destructor waits for the remaining jobs,
+    // whose callbacks still access the members above.
+    Argon2Engine engine;
 
     void loadSettings();
     void appendEntropy(const QString& entropy);
     const char* getHashFunctionName() const;
+    void updateQueueStatus();
+    void updateKernelLabel();
+    int memoryCostMiB() const;
+    void setMemoryCostMiB(int memoryCostMiB, bool roundDown = false);
+    void applyLargeMemoryMode(bool enabled);
+    void updateMemoryWarning();
+    void onTuned(const Argon2TunerOptions& options, const Argon2TuningResult& result);
+    void loadCostModelForActiveKernel();
+    void onCostModelCalibrated(const QString& kernel, const Argon2CostModel& model);
+    void onHashMeasured(const Argon2Parameters& parameters, double predictedSeconds, double seconds);
+    void updateCostPrediction();
+    Argon2Parameters sliderParameters() const;
+    void onJobMeasured(const Argon2JobTelemetry& job);
+    void exportFile(const QString& caption, const QString& filter, const std::string& contents);
+    void updateBatchStatus();
 };
 #endif // MAINWINDOW_H